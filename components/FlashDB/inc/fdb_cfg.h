@@ -25,6 +25,13 @@
 #define FDB_USING_TSDB
 #endif
 
+#ifdef FDB_USING_TSDB
+/* Using 64-bit timestamp (fdb_time_t), the millisecond tick will not wrap after 24.8 days */
+#define FDB_USING_TIMESTAMP_64BIT
+/* Save the TSL timestamp as a 32-bit delta from the sector start time, it implies FDB_USING_TIMESTAMP_64BIT */
+#define FDB_TSDB_USING_TIME_DELTA
+#endif
+
 /* Using FAL storage mode */
 #ifndef FDB_USING_FAL_MODE
 #define FDB_USING_FAL_MODE
@@ -18,11 +18,52 @@
 #ifdef FDB_USING_KVDB
 /* Auto update KV to latest default when current KVDB version number is changed. @see fdb_kvdb.ver_num */
 /* #define FDB_KV_AUTO_UPDATE */
+/* Verify the KV name on flash before using the KV cache node, the name CRC32 and length is trusted by default */
+/* #define FDB_KV_CACHE_PARANOID */
+/* Using the in-RAM hash index of all KV names, the table size is FDB_KV_INDEX_TABLE_SIZE */
+/* #define FDB_KV_USING_INDEX */
+/* Using the in-RAM ordered index of all KV names for the prefix and range iteration, the table size is FDB_KV_ORDER_TABLE_SIZE */
+/* #define FDB_KV_USING_ORDERED_INDEX */
+/* Verify the KV CRC32 only once after boot, the verified KV is saved in a bitmap of FDB_KV_VERIFIED_MAP_SIZE bytes */
+/* #define FDB_KV_CRC_VERIFY_ONCE */
+/* Collect the KV garbage incrementally in budgeted steps, instead of collecting whole sectors when set KV */
+/* #define FDB_KV_USING_INCREMENTAL_GC */
+/* Select the GC sector by the cost-benefit of its garbage and live size, instead of the address order */
+/* #define FDB_KV_USING_GC_COST_BENEFIT */
+/* Allocate the KV by the in-RAM free-space map of all sectors, instead of the sector traversal on flash */
+/* #define FDB_KV_USING_FREE_MAP */
+/* Save the KV index snapshot to the db_name.fdb.idx file, the KVs written after it are checked only when boot */
+/* #define FDB_KV_USING_INDEX_SNAPSHOT */
+/* Only check the sector headers when init, the KV recovery check is deferred to the first modification */
+/* #define FDB_KV_USING_LAZY_LOAD */
+/* Using the counter KV which is increased in place by programming bits, the step number is FDB_KV_COUNTER_STEPS */
+/* #define FDB_KV_USING_COUNTER */
+/* Using the large blob KV which is bigger than a sector, the value is saved to the chunk KVs of FDB_KV_BLOB_CHUNK_SIZE */
+/* #define FDB_KV_USING_LARGE_BLOB */
+/* Read the KV by several readers at once with the shared read lock, @see FDB_KVDB_CTRL_SET_RDLOCK */
+/* #define FDB_KV_USING_RW_LOCK */
+/* Compress the KV value by the LZ codec when set KV, @see FDB_KVDB_CTRL_SET_COMPRESS */
+/* #define FDB_KV_USING_COMPRESS */
 #endif
 
 /* using TSDB (Time series database) feature */
 #define FDB_USING_TSDB
 
+#ifdef FDB_USING_TSDB
+/* Using 64-bit timestamp (fdb_time_t) */
+/* #define FDB_USING_TIMESTAMP_64BIT */
+/* Save the TSL timestamp as a 32-bit delta from the sector start time, it implies FDB_USING_TIMESTAMP_64BIT */
+/* #define FDB_TSDB_USING_TIME_DELTA */
+/* Using the TSL aggregate query (sum/min/max/avg/histogram) API: fdb_tsl_aggregate */
+/* #define FDB_TSDB_USING_AGGREGATE */
+/* The aggregate query reduction kernel lanes. 4 or 8 lets the compiler vectorize it on the SIMD processor, 1: scalar for MCU */
+/* #define FDB_TSL_AGG_LANES              4 */
+/* Share the sectors of one FAL partition between several TSDBs, @see FDB_TSDB_CTRL_SET_POOL */
+/* #define FDB_TSDB_USING_SECTOR_POOL */
+/* Archive the TSL of the recycled sector to a compressed file in POSIX file mode, @see FDB_TSDB_CTRL_SET_ARCHIVE */
+/* #define FDB_TSDB_USING_ARCHIVE */
+#endif
+
 /* Using FAL storage mode */
 #define FDB_USING_FAL_MODE
 
@@ -38,6 +79,12 @@
 /* Using file storage mode by POSIX file API, like open/read/write/close */
 /* #define FDB_USING_FILE_POSIX_MODE */
 
+/* The CRC32 table slicing number, 1 (default), 8 or 16. The bigger one is faster, but it costs 1KB ROM per slice */
+/* #define FDB_CRC32_SLICE                8 */
+
+/* Using the hardware CRC32 instruction: ARMv8 CRC32 or x86 PCLMUL, it's for the host build */
+/* #define FDB_CRC32_USING_HW */
+
 /* MCU Endian Configuration, default is Little Endian Order. */
 /* #define FDB_BIG_ENDIAN */ 
 
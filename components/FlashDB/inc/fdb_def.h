@@ -43,6 +43,70 @@ extern "C" {
 #define FDB_KV_USING_CACHE
 #endif
 
+/* the CRC32 table slicing number: 1 (1KB table), 8 (8KB tables) or 16 (16KB tables), more is faster */
+#ifndef FDB_CRC32_SLICE
+#define FDB_CRC32_SLICE                1
+#endif
+
+#if (FDB_CRC32_SLICE != 1) && (FDB_CRC32_SLICE != 8) && (FDB_CRC32_SLICE != 16)
+#error "The FDB_CRC32_SLICE only supports 1, 8 or 16"
+#endif
+
+/* the verified KV bitmap size, one bit per 16 bytes of database space */
+#ifndef FDB_KV_VERIFIED_MAP_SIZE
+#define FDB_KV_VERIFIED_MAP_SIZE       256
+#endif
+
+/* the KV hash index table size, it MUST be a power of 2 and bigger than the KV number */
+#ifndef FDB_KV_INDEX_TABLE_SIZE
+#define FDB_KV_INDEX_TABLE_SIZE        256
+#endif
+
+/* the KV ordered index table size, it should be bigger than the KV number */
+#ifndef FDB_KV_ORDER_TABLE_SIZE
+#define FDB_KV_ORDER_TABLE_SIZE        256
+#endif
+
+/* the KV name prefix length which is saved in the ordered index node */
+#ifndef FDB_KV_ORDER_KEY_LEN
+#define FDB_KV_ORDER_KEY_LEN           8
+#endif
+
+/* the maximum sector number of the free-space map, the map is NOT used when the KVDB has more sectors */
+#ifndef FDB_KV_FREE_MAP_SEC_NUM
+#define FDB_KV_FREE_MAP_SEC_NUM        64
+#endif
+
+/* the maximum sector number which the live and garbage size is saved for the cost-benefit GC */
+#ifndef FDB_KV_GC_SEC_NUM_MAX
+#define FDB_KV_GC_SEC_NUM_MAX          64
+#endif
+
+/* the default moved KV bytes budget of each incremental GC step */
+#ifndef FDB_KV_GC_STEP_BUDGET
+#define FDB_KV_GC_STEP_BUDGET          1024
+#endif
+
+/* the step number of the counter KV, it's increased in place until all steps are used, then it's rewritten */
+#ifndef FDB_KV_COUNTER_STEPS
+#define FDB_KV_COUNTER_STEPS           128
+#endif
+
+/* the max value size of each chunk KV of the large blob KV, it's also the buffer size of the large blob writer */
+#ifndef FDB_KV_BLOB_CHUNK_SIZE
+#define FDB_KV_BLOB_CHUNK_SIZE         1024
+#endif
+
+/* the compressed KV value buffer size, the bigger value is NOT compressed. It MUST be less than 64KB */
+#ifndef FDB_KV_COMPRESS_BUF_SIZE
+#define FDB_KV_COMPRESS_BUF_SIZE       1024
+#endif
+
+/* the smaller KV value is NOT compressed */
+#ifndef FDB_KV_COMPRESS_MIN_SIZE
+#define FDB_KV_COMPRESS_MIN_SIZE       64
+#endif
+
 #if defined(FDB_USING_FILE_LIBC_MODE) || defined(FDB_USING_FILE_POSIX_MODE)
 #define FDB_USING_FILE_MODE
 #endif
@@ -56,6 +120,58 @@ extern "C" {
 #define FDB_WRITE_GRAN 1
 #endif
 
+/* the maximum sector number of the TSDB sector pool */
+#ifndef FDB_TSDB_POOL_SEC_MAX
+#define FDB_TSDB_POOL_SEC_MAX          256
+#endif
+
+/* the maximum TSDB number of the TSDB sector pool */
+#ifndef FDB_TSDB_POOL_DB_MAX
+#define FDB_TSDB_POOL_DB_MAX           8
+#endif
+
+#if defined(FDB_TSDB_USING_ARCHIVE) && !defined(FDB_USING_FILE_POSIX_MODE)
+#error "The TSDB archive only supports the file mode by POSIX file API, please define FDB_USING_FILE_POSIX_MODE"
+#endif
+
+#if defined(FDB_KV_USING_INDEX_SNAPSHOT) && !defined(FDB_USING_FILE_POSIX_MODE)
+#error "The KV index snapshot only supports the file mode by POSIX file API, please define FDB_USING_FILE_POSIX_MODE"
+#endif
+
+#if defined(FDB_KV_USING_INDEX_SNAPSHOT) && !defined(FDB_KV_USING_INDEX)
+#error "The KV index snapshot needs the KV hash index, please define FDB_KV_USING_INDEX"
+#endif
+
+/* the maximum TSDB number of the merge iterator */
+#ifndef FDB_TSL_MERGE_MAX
+#define FDB_TSL_MERGE_MAX              8
+#endif
+
+/* the maximum subscriber number of each TSDB */
+#ifndef FDB_TSL_SUB_MAX
+#define FDB_TSL_SUB_MAX                4
+#endif
+
+/* the raw data size of each block in the TSDB archive file */
+#ifndef FDB_TSDB_ARC_BLOCK_SIZE
+#define FDB_TSDB_ARC_BLOCK_SIZE        4096
+#endif
+
+/* the TSL number which is decoded into the column buffer at once by the aggregate query */
+#ifndef FDB_TSL_AGG_BLOCK_SIZE
+#define FDB_TSL_AGG_BLOCK_SIZE         16
+#endif
+
+/* the log data buffer size of the aggregate query, the nearby TSL logs are read by one flash read */
+#ifndef FDB_TSL_AGG_BUF_SIZE
+#define FDB_TSL_AGG_BUF_SIZE           256
+#endif
+
+/* the reduction kernel lanes of the aggregate query, 1: scalar */
+#ifndef FDB_TSL_AGG_LANES
+#define FDB_TSL_AGG_LANES              1
+#endif
+
 /* log function. default FDB_PRINT macro is printf() */
 #ifndef FDB_PRINT
 #define FDB_PRINT(...)                 printf(__VA_ARGS__)
@@ -91,6 +207,13 @@ if (!(EXPR))                                                                  \
 #define FDB_KVDB_CTRL_SET_FILE_MODE    0x09             /**< set file mode control command, this change MUST before database initialization */
 #define FDB_KVDB_CTRL_SET_MAX_SIZE     0x0A             /**< set database max size in file mode control command, this change MUST before database initialization */
 #define FDB_KVDB_CTRL_SET_NOT_FORMAT   0x0B             /**< set database NOT format mode control command, this change MUST before database initialization */
+#define FDB_KVDB_CTRL_SET_GC_BUDGET    0x0C             /**< set the moved KV bytes budget of the incremental GC step when set KV control command, default is FDB_KV_GC_STEP_BUDGET */
+#define FDB_KVDB_CTRL_SET_SEC_CACHE    0x0D             /**< set the whole database sector cache control command @see fdb_kvdb_sec_cache, this change MUST before database initialization */
+#define FDB_KVDB_CTRL_SET_SNAPSHOT     0x0E             /**< set the index snapshot mode control command, this change MUST before database initialization */
+#define FDB_KVDB_CTRL_SET_LAZY_LOAD    0x0F             /**< set the lazy load mode control command, this change MUST before database initialization */
+#define FDB_KVDB_CTRL_SET_RDLOCK       0x10             /**< set the shared read lock function control command, the lock function is the exclusive write lock */
+#define FDB_KVDB_CTRL_SET_RDUNLOCK     0x11             /**< set the shared read unlock function control command */
+#define FDB_KVDB_CTRL_SET_COMPRESS     0x12             /**< set the KV value compression mode control command, this change will take effect on the next set KV */
 
 #define FDB_TSDB_CTRL_SET_SEC_SIZE     0x00             /**< set sector size control command, this change MUST before database initialization */
 #define FDB_TSDB_CTRL_GET_SEC_SIZE     0x01             /**< get sector size control command */
@@ -102,6 +225,18 @@ if (!(EXPR))                                                                  \
 #define FDB_TSDB_CTRL_SET_FILE_MODE    0x09             /**< set file mode control command, this change MUST before database initialization */
 #define FDB_TSDB_CTRL_SET_MAX_SIZE     0x0A             /**< set database max size in file mode control command, this change MUST before database initialization */
 #define FDB_TSDB_CTRL_SET_NOT_FORMAT   0x0B             /**< set database NOT formatable mode control command, this change MUST before database initialization */
+#define FDB_TSDB_CTRL_SET_SNAPSHOT_READ 0x0C            /**< set snapshot read mode control command, the iterator will NOT hold the lock when walking */
+#define FDB_TSDB_CTRL_GET_SNAPSHOT_READ 0x0D            /**< get snapshot read mode control command */
+#define FDB_TSDB_CTRL_SET_POOL         0x0E             /**< set the shared sector pool control command, this change MUST before database initialization */
+#define FDB_TSDB_CTRL_SET_ARCHIVE      0x0F             /**< set the archive mode control command, this change MUST before database initialization */
+#define FDB_TSDB_CTRL_GET_ARCHIVE_SIZE 0x10             /**< get the archive file size control command */
+#define FDB_TSDB_CTRL_SET_WAIT         0x11             /**< set the new TSL wait function control command */
+#define FDB_TSDB_CTRL_SET_NOTIFY       0x12             /**< set the new TSL notify function control command */
+
+/* the TSL timestamp delta format always saves the sector start time by 64-bit */
+#if defined(FDB_TSDB_USING_TIME_DELTA) && !defined(FDB_USING_TIMESTAMP_64BIT)
+#define FDB_USING_TIMESTAMP_64BIT
+#endif
 
 #ifdef FDB_USING_TIMESTAMP_64BIT
     typedef int64_t fdb_time_t;
@@ -162,6 +297,7 @@ struct fdb_kv {
     fdb_kv_status_t status;                      /**< node status, @see fdb_kv_status_t */
     bool crc_is_ok;                              /**< node CRC32 check is OK */
     uint8_t name_len;                            /**< name length */
+    uint8_t attr;                                /**< attribute bits in the KV header, it's erased by default */
     uint32_t magic;                              /**< magic word(`K`, `V`, `4`, `0`) */
     uint32_t len;                                /**< node total length (header + name + value), must align by FDB_WRITE_GRAN */
     uint32_t value_len;                          /**< value length */
@@ -183,6 +319,22 @@ struct fdb_kv_iterator {
 };
 typedef struct fdb_kv_iterator *fdb_kv_iterator_t;
 
+#ifdef FDB_KV_USING_LARGE_BLOB
+/* large blob KV writer, the value is saved to the chunk KVs one by one, @see fdb_kv_set_blob_begin */
+struct fdb_kv_blob_writer {
+    char key[FDB_KV_NAME_MAX + 1];               /**< KV name */
+    fdb_err_t result;                            /**< the first error when writing, the value is dropped on error */
+    uint32_t gen;                                /**< generation of the chunk KVs, the old value has the other one */
+    uint32_t len;                                /**< written value length */
+    uint32_t crc32;                              /**< written value crc32 */
+    uint32_t chunk_size;                         /**< value size of the chunk KV */
+    uint32_t chunk_num;                          /**< saved chunk KV number */
+    size_t buf_len;                              /**< buffered value length */
+    uint8_t buf[FDB_KV_BLOB_CHUNK_SIZE];         /**< chunk buffer */
+};
+typedef struct fdb_kv_blob_writer *fdb_kv_blob_writer_t;
+#endif /* FDB_KV_USING_LARGE_BLOB */
+
 /* time series log node object */
 struct fdb_tsl {
     fdb_tsl_status_t status;                     /**< node status, @see fdb_log_status_t */
@@ -192,6 +344,7 @@ struct fdb_tsl {
         uint32_t index;                          /**< node index address */
         uint32_t log;                            /**< log data address */
     } addr;
+    uint32_t sec_gen;                            /**< the sector generation when the TSL is read, the blob read fails when the sector is recycled after it */
 };
 typedef struct fdb_tsl *fdb_tsl_t;
 typedef bool (*fdb_tsl_cb)(fdb_tsl_t tsl, void *arg);
@@ -236,6 +389,12 @@ struct kvdb_sec_info {
 };
 typedef struct kvdb_sec_info *kv_sec_info_t;
 
+/* the whole database sector cache which is supplied by caller, @see FDB_KVDB_CTRL_SET_SEC_CACHE */
+struct fdb_kvdb_sec_cache {
+    struct kvdb_sec_info *table;                 /**< the sector info table, each sector has its own node */
+    size_t num;                                  /**< the node number of the table, it MUST be no less than the sector number */
+};
+
 /* TSDB section information */
 struct tsdb_sec_info {
     bool check_ok;                               /**< sector header check is OK */
@@ -253,12 +412,39 @@ struct tsdb_sec_info {
 typedef struct tsdb_sec_info *tsdb_sec_info_t;
 
 struct kv_cache_node {
-    uint16_t name_crc;                           /**< KV name's CRC32 low 16bit value */
+    uint32_t name_crc;                           /**< KV name's CRC32 value */
     uint16_t active;                             /**< KV node access active degree */
+    uint8_t name_len;                            /**< KV name length */
     uint32_t addr;                               /**< KV node address */
 };
 typedef struct kv_cache_node *kv_cache_node_t;
 
+struct kv_index_node {
+    uint32_t name_crc;                           /**< KV name's CRC32 value */
+    uint32_t addr;                               /**< KV node address, FDB_DATA_UNUSED: empty node */
+};
+typedef struct kv_index_node *kv_index_node_t;
+
+struct kv_order_node {
+    uint32_t addr;                               /**< KV node address */
+    char key[FDB_KV_ORDER_KEY_LEN];              /**< KV name prefix, the shorter name is padded by '\0' */
+};
+typedef struct kv_order_node *kv_order_node_t;
+
+struct kv_sec_stat {
+    uint32_t live;                               /**< the live KV size in the sector */
+    uint32_t garbage;                            /**< the deleted or error KV size in the sector, 0xFFFFFFFF: unknown */
+    uint32_t seq;                                /**< the write sequence when the sector is used, the older one is smaller */
+};
+typedef struct kv_sec_stat *kv_sec_stat_t;
+
+struct kv_free_node {
+    uint32_t empty_kv;                           /**< the empty KV address of the sector, 0xFFFFFFFF: unknown */
+    uint8_t store;                               /**< sector store status @see fdb_sector_store_status_t */
+    uint8_t dirty;                               /**< sector dirty status @see fdb_sector_dirty_status_t */
+};
+typedef struct kv_free_node *kv_free_node_t;
+
 /* database structure */
 typedef struct fdb_db *fdb_db_t;
 struct fdb_db {
@@ -289,6 +475,11 @@ struct fdb_db {
 #endif
     void (*lock)(fdb_db_t db);                   /**< lock the database operate */
     void (*unlock)(fdb_db_t db);                 /**< unlock the database operate */
+#ifdef FDB_KV_USING_RW_LOCK
+    void (*rdlock)(fdb_db_t db);                 /**< lock the database for the shared read, the lock function is exclusive */
+    void (*rdunlock)(fdb_db_t db);               /**< unlock the database for the shared read */
+    uint8_t wr_locked;                           /**< the exclusive lock nesting count, it's 0 when read shared */
+#endif
 
     void *user_data;
 };
@@ -308,8 +499,66 @@ struct fdb_kvdb {
     struct kv_cache_node kv_cache_table[FDB_KV_CACHE_TABLE_SIZE];
     /* sector cache table, it caching the sector info which status is current using */
     struct kvdb_sec_info sector_cache_table[FDB_SECTOR_CACHE_TABLE_SIZE];
+    /* the whole database sector cache table which is supplied by caller, it's used instead of the sector cache table */
+    struct kvdb_sec_info *sector_cache_all;
+    size_t sector_cache_all_num;                 /**< the node number of the whole database sector cache table */
 #endif /* FDB_KV_USING_CACHE */
 
+#ifdef FDB_KV_USING_INDEX
+    /* KV hash index table of all KV, using open addressing with linear probing */
+    struct kv_index_node kv_index_table[FDB_KV_INDEX_TABLE_SIZE];
+    size_t kv_index_num;                         /**< the used node number of the index table */
+    bool kv_index_ok;                            /**< all KV is in the index, so the KV is not found when index missed */
+#endif /* FDB_KV_USING_INDEX */
+
+#ifdef FDB_KV_USING_ORDERED_INDEX
+    /* KV ordered index table of all KV, it's sorted by KV name */
+    struct kv_order_node kv_order_table[FDB_KV_ORDER_TABLE_SIZE];
+    size_t kv_order_num;                         /**< the used node number of the ordered index table */
+    bool kv_order_ok;                            /**< all KV is in the ordered index */
+#endif /* FDB_KV_USING_ORDERED_INDEX */
+
+#ifdef FDB_KV_CRC_VERIFY_ONCE
+    uint8_t kv_verified_map[FDB_KV_VERIFIED_MAP_SIZE]; /**< the KV which CRC32 is verified OK after boot */
+#endif
+
+#ifdef FDB_KV_USING_GC_COST_BENEFIT
+    /* the live and garbage size of each sector, it's counted when the sector is checked by GC first time */
+    struct kv_sec_stat sec_stat_table[FDB_KV_GC_SEC_NUM_MAX];
+    uint32_t sec_seq;                            /**< the write sequence of the last used sector, it's the GC age base */
+#endif
+
+#ifdef FDB_KV_USING_FREE_MAP
+    /* the status and empty KV address of all sectors, the KV is allocated by it without reading the flash */
+    struct kv_free_node free_map[FDB_KV_FREE_MAP_SEC_NUM];
+    bool free_map_ok;                            /**< the free-space map is built and all sectors are in it */
+#endif
+
+#ifdef FDB_KV_USING_INDEX_SNAPSHOT
+    bool snapshot;                               /**< save the index snapshot file, the KVDB is loaded by it when boot */
+    bool snap_valid;                             /**< the snapshot file has data, it's cleaned before any sector is erased */
+    bool snap_loaded;                            /**< the index is loaded by the snapshot when boot */
+    int snap_file;                               /**< snapshot file descriptor */
+    uint32_t snap_seq;                           /**< the sequence number of the last snapshot */
+#endif
+
+#ifdef FDB_KV_USING_LAZY_LOAD
+    bool lazy_load;                              /**< only check the sector headers when init */
+    bool lazy_pending;                           /**< the KV recovery check is NOT done, it's done before the first modification */
+#endif
+
+#ifdef FDB_KV_USING_INCREMENTAL_GC
+    uint32_t gc_sec_addr;                        /**< the sector address which is collecting by incremental GC, 0xFFFFFFFF: none */
+    uint32_t gc_kv_addr;                         /**< the next KV address to collect in the collecting sector */
+    size_t gc_budget;                            /**< the moved KV bytes budget of the GC step when set KV, 0: the whole sectors are collected when set KV */
+    bool gc_budget_set;                          /**< the GC budget is set by control command, otherwise FDB_KV_GC_STEP_BUDGET is used */
+#endif
+
+#ifdef FDB_KV_USING_COMPRESS
+    bool compress;                               /**< compress the KV value when set KV, default is false */
+    uint8_t comp_buf[FDB_KV_COMPRESS_BUF_SIZE];  /**< compressed KV value buffer */
+#endif
+
 #ifdef FDB_KV_AUTO_UPDATE
     uint32_t ver_num;                            /**< setting version number for update */
 #endif
@@ -318,6 +567,26 @@ struct fdb_kvdb {
 };
 typedef struct fdb_kvdb *fdb_kvdb_t;
 
+/* the sector info in the TSDB sector pool */
+struct fdb_tsdb_pool_sec {
+    uint32_t owner;                              /**< owner TSDB tag, 0xFFFFFFFF: free */
+    uint32_t seq;                                /**< allocation sequence number, the smaller is the older */
+    uint16_t prev;                               /**< the previous sector index in the owner's chain, 0xFFFF: none */
+    uint16_t next;                               /**< the next sector index in the owner's chain, 0xFFFF: none */
+};
+
+/* the sector pool which is shared by the TSDBs in one partition */
+struct fdb_tsdb_pool {
+    bool loaded;                                 /**< the sector table is loaded from flash */
+    uint32_t sec_num;                            /**< sector number in the partition */
+    uint32_t next_seq;                           /**< the next allocation sequence number */
+    struct fdb_tsdb *db_table[FDB_TSDB_POOL_DB_MAX]; /**< the TSDBs in this pool */
+    struct fdb_tsdb_pool_sec sec_table[FDB_TSDB_POOL_SEC_MAX];
+    void (*lock)(struct fdb_tsdb_pool *pool);    /**< lock the sector table, it's taken after the TSDB lock, NULL: not locked */
+    void (*unlock)(struct fdb_tsdb_pool *pool);  /**< unlock the sector table */
+};
+typedef struct fdb_tsdb_pool *fdb_tsdb_pool_t;
+
 /* TSDB structure */
 struct fdb_tsdb {
     struct fdb_db parent;                        /**< inherit from fdb_db */
@@ -326,10 +595,79 @@ struct fdb_tsdb {
     fdb_get_time get_time;                       /**< the current timestamp get function */
     size_t max_len;                              /**< the maximum length of each log */
     bool rollover;                               /**< the oldest data will rollover by newest data, default is true */
+    bool snapshot_read;                          /**< the iterator reads a snapshot without holding the lock, default is false */
+    volatile uint32_t recycled_num;              /**< the recycled sectors number, the snapshot iterator uses it to detect the recycled sectors */
+#ifdef FDB_TSDB_USING_SECTOR_POOL
+    fdb_tsdb_pool_t pool;                        /**< the shared sector pool, NULL: the TSDB owns the whole partition */
+    uint32_t owner;                              /**< owner tag in the pool, it's the CRC32 of the TSDB name */
+#endif
+#ifdef FDB_TSDB_USING_ARCHIVE
+    bool archive;                                /**< archive the TSL to the archive file before the sector is recycled */
+    int arc_file;                                /**< archive file descriptor */
+    uint32_t arc_size;                           /**< archive file valid size */
+    fdb_time_t arc_end_time;                     /**< the newest archived TSL timestamp */
+    uint32_t arc_blk_addr;                       /**< the block address in the raw data buffer, 0xFFFFFFFF: none */
+    uint32_t arc_locked;                         /**< the number of iterators which hold the lock, the archived TSL is read without locking again in their callbacks */
+    uint8_t arc_buf[FDB_TSDB_ARC_BLOCK_SIZE];    /**< archive block raw data buffer */
+    uint8_t arc_comp_buf[FDB_TSDB_ARC_BLOCK_SIZE + 64]; /**< archive block file data buffer, including the block header */
+#endif
+    struct {
+        fdb_tsl_cb cb;                           /**< it's called after the new TSL is committed, return true to unsubscribe */
+        void *arg;
+    } sub[FDB_TSL_SUB_MAX];                      /**< the new TSL subscribers */
+    bool (*wait)(fdb_db_t db, int32_t *timeout); /**< wait for the new TSL with the database locked, update the timeout to the remaining time, return false when timeout */
+    void (*notify)(fdb_db_t db);                 /**< wake up the waiters after the new TSL is committed */
 
     void *user_data;
 };
 typedef struct fdb_tsdb *fdb_tsdb_t;
+typedef bool (*fdb_tsl_merge_cb)(fdb_tsdb_t db, fdb_tsl_t tsl, void *arg);
+
+/* the numeric field type in the TSL log for aggregate query */
+typedef enum {
+    FDB_TSL_FIELD_INT8,
+    FDB_TSL_FIELD_UINT8,
+    FDB_TSL_FIELD_INT16,
+    FDB_TSL_FIELD_UINT16,
+    FDB_TSL_FIELD_INT32,
+    FDB_TSL_FIELD_UINT32,
+    FDB_TSL_FIELD_INT64,
+    FDB_TSL_FIELD_FLOAT,
+    FDB_TSL_FIELD_DOUBLE,
+} fdb_tsl_field_type_t;
+
+/* the numeric field extractor, the field is saved in the TSL log by the CPU byte order */
+struct fdb_tsl_extractor {
+    fdb_tsl_field_type_t type;                   /**< field type */
+    size_t offset;                               /**< field offset in the TSL log */
+};
+typedef struct fdb_tsl_extractor *fdb_tsl_extractor_t;
+
+#define FDB_TSL_AGG_SUM                (1 << 0) /**< calculate the sum and average */
+#define FDB_TSL_AGG_MIN                (1 << 1) /**< calculate the minimum */
+#define FDB_TSL_AGG_MAX                (1 << 2) /**< calculate the maximum */
+#define FDB_TSL_AGG_HIST               (1 << 3) /**< calculate the histogram */
+
+/* aggregate query specification */
+struct fdb_tsl_agg_spec {
+    uint32_t ops;                                /**< aggregate operations, @see FDB_TSL_AGG_SUM */
+    double hist_min;                             /**< histogram lower bound */
+    double hist_width;                           /**< histogram bin width */
+    size_t hist_num;                             /**< histogram bin number */
+    uint32_t *hist;                              /**< histogram bins, the out of range value is counted by the first or last bin */
+};
+typedef struct fdb_tsl_agg_spec *fdb_tsl_agg_spec_t;
+
+/* aggregate query result */
+struct fdb_tsl_agg_result {
+    size_t count;                                /**< aggregated TSL count */
+    double sum;                                  /**< sum of values */
+    double avg;                                  /**< average of values */
+    double min;                                  /**< minimum value */
+    double max;                                  /**< maximum value */
+    bool overflow;                               /**< the INT64 sum is overflowed, the sum and avg are NOT exact then */
+};
+typedef struct fdb_tsl_agg_result *fdb_tsl_agg_result_t;
 
 /* blob structure */
 struct fdb_blob {
@@ -339,6 +677,7 @@ struct fdb_blob {
         uint32_t meta_addr;                      /**< saved KV or TSL index address */
         uint32_t addr;                           /**< blob data saved address */
         size_t len;                              /**< blob data saved length */
+        uint32_t sec_gen;                        /**< the saved TSL sector generation, @see fdb_tsl */
     } saved;
 };
 typedef struct fdb_blob *fdb_blob_t;
@@ -53,6 +53,14 @@
 /* invalid address */
 #define FDB_FAILED_ADDR                      0xFFFFFFFF
 
+/* the database is read by several readers with the shared read lock, so the caches and file state MUST NOT be changed */
+#ifdef FDB_KV_USING_RW_LOCK
+#define FDB_DB_IS_READ_SHARED(db)            (((fdb_db_t)(db))->rdlock && ((fdb_db_t)(db))->init_ok                  \
+                                                 && ((fdb_db_t)(db))->wr_locked == 0)
+#else
+#define FDB_DB_IS_READ_SHARED(db)            false
+#endif
+
 size_t _fdb_set_status(uint8_t status_table[], size_t status_num, size_t status_index);
 size_t _fdb_get_status(uint8_t status_table[], size_t status_num);
 uint32_t _fdb_continue_ff_addr(fdb_db_t db, uint32_t start, uint32_t end);
@@ -65,5 +73,26 @@ size_t _fdb_read_status(fdb_db_t db, uint32_t addr, uint8_t status_table[], size
 fdb_err_t _fdb_flash_read(fdb_db_t db, uint32_t addr, void *buf, size_t size);
 fdb_err_t _fdb_flash_erase(fdb_db_t db, uint32_t addr, size_t size);
 fdb_err_t _fdb_flash_write(fdb_db_t db, uint32_t addr, const void *buf, size_t size, bool sync);
+uint32_t _fdb_calc_crc32_fill(uint32_t crc, uint8_t value, size_t size);
+size_t _fdb_lz_compress(const uint8_t *src, size_t src_len, uint8_t *dst, size_t dst_len);
+size_t _fdb_lz_decompress(const uint8_t *src, size_t src_len, uint8_t *dst, size_t dst_len);
+size_t _fdb_lz_decompress_flash(fdb_db_t db, uint32_t addr, size_t src_len, uint8_t *dst, size_t dst_len);
+#if defined(FDB_TSDB_USING_ARCHIVE) || defined(FDB_KV_USING_INDEX_SNAPSHOT)
+int _fdb_file_ext_open(fdb_db_t db, const char *ext, uint32_t *size);
+void _fdb_file_ext_close(int fd);
+fdb_err_t _fdb_file_ext_read(int fd, uint32_t offset, void *buf, size_t size);
+fdb_err_t _fdb_file_ext_write(int fd, uint32_t offset, const void *buf, size_t size);
+fdb_err_t _fdb_file_ext_truncate(int fd, uint32_t size);
+#endif
+#ifdef FDB_USING_TSDB
+bool _fdb_tsl_blob_check(fdb_db_t db, fdb_blob_t blob);
+#endif
+#ifdef FDB_TSDB_USING_ARCHIVE
+/* the TSL index address flag of the archived TSL, the low bits are the block address in the archive file,
+ * and the log address is the offset in the block raw data */
+#define FDB_TSL_ARC_INDEX                    0x80000000
+#define FDB_TSL_IS_ARC(index)                (((index) & FDB_TSL_ARC_INDEX) != 0)
+size_t _fdb_tsl_arc_blob_read(fdb_db_t db, fdb_blob_t blob, size_t offset, size_t len);
+#endif
 
 #endif /* _FDB_LOW_LVL_H_ */
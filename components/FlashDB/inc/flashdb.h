@@ -36,6 +36,9 @@ fdb_err_t fdb_kvdb_init   (fdb_kvdb_t db, const char *name, const char *path, st
 void      fdb_kvdb_control(fdb_kvdb_t db, int cmd, void *arg);
 fdb_err_t fdb_kvdb_check(fdb_kvdb_t db);
 fdb_err_t fdb_kvdb_deinit(fdb_kvdb_t db);
+bool      fdb_kvdb_gc_step(fdb_kvdb_t db, size_t budget);
+fdb_err_t fdb_kvdb_save_snapshot(fdb_kvdb_t db);
+fdb_err_t fdb_kvdb_finish_load(fdb_kvdb_t db);
 fdb_err_t fdb_tsdb_init   (fdb_tsdb_t db, const char *name, const char *path, fdb_get_time get_time, size_t max_len,
         void *user_data);
 void      fdb_tsdb_control(fdb_tsdb_t db, int cmd, void *arg);
@@ -44,30 +47,51 @@ fdb_err_t fdb_tsdb_deinit(fdb_tsdb_t db);
 /* blob API */
 fdb_blob_t fdb_blob_make     (fdb_blob_t blob, const void *value_buf, size_t buf_len);
 size_t     fdb_blob_read     (fdb_db_t db, fdb_blob_t blob);
+size_t     fdb_blob_read_at  (fdb_db_t db, fdb_blob_t blob, size_t offset, size_t len);
 
 /* Key-Value API like a KV DB */
 fdb_err_t         fdb_kv_set          (fdb_kvdb_t db, const char *key, const char *value);
 char             *fdb_kv_get          (fdb_kvdb_t db, const char *key);
 fdb_err_t         fdb_kv_set_blob     (fdb_kvdb_t db, const char *key, fdb_blob_t blob);
+fdb_err_t         fdb_kv_set_batch    (fdb_kvdb_t db, const char *keys[], struct fdb_blob blobs[], size_t num);
 size_t            fdb_kv_get_blob     (fdb_kvdb_t db, const char *key, fdb_blob_t blob);
 fdb_err_t         fdb_kv_del          (fdb_kvdb_t db, const char *key);
+fdb_err_t         fdb_kv_counter_set  (fdb_kvdb_t db, const char *key, uint32_t value);
+fdb_err_t         fdb_kv_counter_get  (fdb_kvdb_t db, const char *key, uint32_t *value);
+fdb_err_t         fdb_kv_counter_inc  (fdb_kvdb_t db, const char *key, uint32_t *value);
 fdb_kv_t          fdb_kv_get_obj      (fdb_kvdb_t db, const char *key, fdb_kv_t kv);
 fdb_blob_t        fdb_kv_to_blob      (fdb_kv_t   kv, fdb_blob_t blob);
 fdb_err_t         fdb_kv_set_default  (fdb_kvdb_t db);
 void              fdb_kv_print        (fdb_kvdb_t db);
 fdb_kv_iterator_t fdb_kv_iterator_init(fdb_kvdb_t db, fdb_kv_iterator_t itr);
 bool              fdb_kv_iterate      (fdb_kvdb_t db, fdb_kv_iterator_t itr);
+bool              fdb_kv_iterate_prefix(fdb_kvdb_t db, fdb_kv_iterator_t itr, const char *prefix);
+bool              fdb_kv_iterate_range(fdb_kvdb_t db, fdb_kv_iterator_t itr, const char *from, const char *to);
+#ifdef FDB_KV_USING_LARGE_BLOB
+fdb_err_t         fdb_kv_set_blob_begin(fdb_kvdb_t db, const char *key, fdb_kv_blob_writer_t writer);
+fdb_err_t         fdb_kv_set_blob_write(fdb_kvdb_t db, fdb_kv_blob_writer_t writer, const void *buf, size_t len);
+fdb_err_t         fdb_kv_set_blob_end (fdb_kvdb_t db, fdb_kv_blob_writer_t writer);
+size_t            fdb_kv_read_blob_at (fdb_kvdb_t db, const char *key, size_t offset, void *buf, size_t len);
+#endif
 
 /* Time series log API like a TSDB */
 fdb_err_t  fdb_tsl_append      (fdb_tsdb_t db, fdb_blob_t blob);
 fdb_err_t  fdb_tsl_append_with_ts(fdb_tsdb_t db, fdb_blob_t blob, fdb_time_t timestamp);
+fdb_err_t  fdb_tsl_subscribe   (fdb_tsdb_t db, fdb_tsl_cb cb, void *arg);
+fdb_err_t  fdb_tsl_unsubscribe (fdb_tsdb_t db, fdb_tsl_cb cb, void *arg);
+bool       fdb_tsl_wait_newer  (fdb_tsdb_t db, fdb_time_t last_time, int32_t timeout);
 void       fdb_tsl_iter        (fdb_tsdb_t db, fdb_tsl_cb cb, void *cb_arg);
 void       fdb_tsl_iter_reverse(fdb_tsdb_t db, fdb_tsl_cb cb, void *cb_arg);
 void       fdb_tsl_iter_by_time(fdb_tsdb_t db, fdb_time_t from, fdb_time_t to, fdb_tsl_cb cb, void *cb_arg);
+void       fdb_tsl_iter_merge  (fdb_tsdb_t db[], size_t db_num, fdb_time_t from, fdb_time_t to, fdb_tsl_merge_cb cb, void *cb_arg);
 size_t     fdb_tsl_query_count (fdb_tsdb_t db, fdb_time_t from, fdb_time_t to, fdb_tsl_status_t status);
 fdb_err_t  fdb_tsl_set_status  (fdb_tsdb_t db, fdb_tsl_t tsl, fdb_tsl_status_t status);
 void       fdb_tsl_clean       (fdb_tsdb_t db);
 fdb_blob_t fdb_tsl_to_blob     (fdb_tsl_t tsl, fdb_blob_t blob);
+#ifdef FDB_TSDB_USING_AGGREGATE
+fdb_err_t  fdb_tsl_aggregate   (fdb_tsdb_t db, fdb_time_t from, fdb_time_t to, fdb_tsl_extractor_t extractor,
+        fdb_tsl_agg_spec_t spec, fdb_tsl_agg_result_t result);
+#endif
 
 /* fdb_utils.c */
 uint32_t   fdb_calc_crc32(uint32_t crc, const void *buf, size_t size);
@@ -119,10 +119,47 @@ static int open_db_file(fdb_db_t db, uint32_t addr, bool clean)
     return fd;
 }
 
+#ifdef FDB_KV_USING_RW_LOCK
+/*
+ * Read the database file by the shared reader. The file cache and the file offset are NOT changed,
+ * the file is opened for this read only when it's NOT in the cache.
+ */
+static fdb_err_t read_db_file_shared(fdb_db_t db, uint32_t addr, void *buf, size_t size)
+{
+    fdb_err_t result = FDB_NO_ERR;
+    int fd = get_file_from_cache(db, FDB_ALIGN_DOWN(addr, db->sec_size));
+    bool opened = false;
+    char path[DB_PATH_MAX];
+
+    if (fd <= 0) {
+        get_db_file_path(db, addr, path, DB_PATH_MAX);
+        fd = open(path, O_RDONLY);
+        opened = true;
+    }
+    if (fd > 0) {
+        if (pread(fd, buf, size, addr % db->sec_size) != (ssize_t)size)
+            result = FDB_READ_ERR;
+        if (opened)
+            close(fd);
+    } else {
+        result = FDB_READ_ERR;
+    }
+    return result;
+}
+#endif /* FDB_KV_USING_RW_LOCK */
+
 fdb_err_t _fdb_file_read(fdb_db_t db, uint32_t addr, void *buf, size_t size)
 {
     fdb_err_t result = FDB_NO_ERR;
-    int fd = open_db_file(db, addr, false);
+    int fd;
+
+#ifdef FDB_KV_USING_RW_LOCK
+    if (FDB_DB_IS_READ_SHARED(db)) {
+        return read_db_file_shared(db, addr, buf, size);
+    }
+#endif
+
+    fd = open_db_file(db, addr, false);
     if (fd > 0) {
         /* get the offset address is relative to the start of the current file */
         addr = addr % db->sec_size;
@@ -176,6 +213,75 @@ fdb_err_t _fdb_file_erase(fdb_db_t db, uint32_t addr, size_t size)
     }
     return result;
 }
+
+#if defined(FDB_TSDB_USING_ARCHIVE) || defined(FDB_KV_USING_INDEX_SNAPSHOT)
+/**
+ * Open the extra file of the database, such as the TSDB archive file. It's created when not exist.
+ *
+ * @param db database object
+ * @param ext the extra file name extension, the file name is db_name.fdb.ext
+ * @param size the extra file size
+ *
+ * @return file descriptor, < 0: failed
+ */
+int _fdb_file_ext_open(fdb_db_t db, const char *ext, uint32_t *size)
+{
+    char path[DB_PATH_MAX];
+    off_t end;
+    int fd;
+
+    if (strlen(db->storage.dir) + 1 + DB_NAME_MAX + 5 + strlen(ext) >= DB_PATH_MAX) {
+        FDB_INFO("Error: db (%s) %s file path (%s) is too log.\n", db->name, ext, db->storage.dir);
+        return -1;
+    }
+    snprintf(path, DB_PATH_MAX, "%s/%.*s.fdb.%s", db->storage.dir, DB_NAME_MAX, db->name, ext);
+    fd = open(path, O_RDWR | O_CREAT, 0777);
+    if (fd < 0) {
+        FDB_INFO("Error: open (%s) file failed.\n", path);
+        return fd;
+    }
+    end = lseek(fd, 0, SEEK_END);
+    *size = end < 0 ? 0 : (uint32_t)end;
+
+    return fd;
+}
+
+void _fdb_file_ext_close(int fd)
+{
+    if (fd >= 0) {
+        close(fd);
+    }
+}
+
+fdb_err_t _fdb_file_ext_read(int fd, uint32_t offset, void *buf, size_t size)
+{
+    if ((lseek(fd, offset, SEEK_SET) != (off_t)offset) || (read(fd, buf, size) != (ssize_t)size)) {
+        return FDB_READ_ERR;
+    }
+
+    return FDB_NO_ERR;
+}
+
+fdb_err_t _fdb_file_ext_write(int fd, uint32_t offset, const void *buf, size_t size)
+{
+    if ((lseek(fd, offset, SEEK_SET) != (off_t)offset) || (write(fd, buf, size) != (ssize_t)size)) {
+        return FDB_WRITE_ERR;
+    }
+    fsync(fd);
+
+    return FDB_NO_ERR;
+}
+
+fdb_err_t _fdb_file_ext_truncate(int fd, uint32_t size)
+{
+    if (ftruncate(fd, size) != 0) {
+        return FDB_ERASE_ERR;
+    }
+    fsync(fd);
+
+    return FDB_NO_ERR;
+}
+#endif /* defined(FDB_TSDB_USING_ARCHIVE) || defined(FDB_KV_USING_INDEX_SNAPSHOT) */
 #elif defined(FDB_USING_FILE_LIBC_MODE)
 
 static FILE *get_file_from_cache(fdb_db_t db, uint32_t sec_addr)
@@ -257,10 +363,42 @@ static FILE *open_db_file(fdb_db_t db, uint32_t addr, bool clean)
     return fd;
 }
 
+#ifdef FDB_KV_USING_RW_LOCK
+/*
+ * Read the database file by the shared reader. The FILE object has its own offset and buffer,
+ * so the cached one is NOT used, the file is opened for this read.
+ */
+static fdb_err_t read_db_file_shared(fdb_db_t db, uint32_t addr, void *buf, size_t size)
+{
+    fdb_err_t result = FDB_NO_ERR;
+    char path[DB_PATH_MAX];
+    FILE *fp;
+
+    get_db_file_path(db, addr, path, DB_PATH_MAX);
+    fp = fopen(path, "rb");
+    if (fp) {
+        if ((fseek(fp, addr % db->sec_size, SEEK_SET) != 0) || (fread(buf, size, 1, fp) != 1))
+            result = FDB_READ_ERR;
+        fclose(fp);
+    } else {
+        result = FDB_READ_ERR;
+    }
+    return result;
+}
+#endif /* FDB_KV_USING_RW_LOCK */
+
 fdb_err_t _fdb_file_read(fdb_db_t db, uint32_t addr, void *buf, size_t size)
 {
     fdb_err_t result = FDB_NO_ERR;
-    FILE *fp = open_db_file(db, addr, false);
+    FILE *fp;
+
+#ifdef FDB_KV_USING_RW_LOCK
+    if (FDB_DB_IS_READ_SHARED(db)) {
+        return read_db_file_shared(db, addr, buf, size);
+    }
+#endif
+
+    fp = open_db_file(db, addr, false);
     if (fp) {
         addr = addr % db->sec_size;
         if ((fseek(fp, addr, SEEK_SET) != 0) || (fread(buf, size, 1, fp) != 1))
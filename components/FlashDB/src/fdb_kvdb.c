@@ -35,6 +35,8 @@
 #define SECTOR_MAGIC_WORD                        0x30424446
 /* magic word(`K`, `V`, `0`, `0`) */
 #define KV_MAGIC_WORD                            0x3030564B
+/* magic word(`B`, `A`, `T`, `0`) */
+#define KV_BATCH_MAGIC_WORD                      0x30544142
 /* GC minimum number of empty sectors. GC will using at least 1 empty sector. */
 #define GC_MIN_EMPTY_SEC_NUM                     1
 
@@ -48,6 +50,18 @@
 #define FDB_GC_EMPTY_SEC_THRESHOLD                1
 #endif
 
+#ifdef FDB_KV_USING_INCREMENTAL_GC
+/* the remain empty sector threshold before incremental GC, it starts earlier than the GC when set KV */
+#ifndef FDB_GC_STEP_SEC_THRESHOLD
+#define FDB_GC_STEP_SEC_THRESHOLD                (FDB_GC_EMPTY_SEC_THRESHOLD + 1)
+#endif
+#endif /* FDB_KV_USING_INCREMENTAL_GC */
+
+/* the read buffer size when scanning the KV magic word, it MUST be a multiple of 4 */
+#ifndef FDB_KV_SCAN_BUF_SIZE
+#define FDB_KV_SCAN_BUF_SIZE                     128
+#endif
+
 /* the string KV value buffer size for legacy fdb_get_kv(db, ) function */
 #ifndef FDB_STR_KV_VALUE_MAX_SIZE
 #define FDB_STR_KV_VALUE_MAX_SIZE                128
@@ -57,6 +71,53 @@
 #error "The KV cache table size must less than 0xFFFF"
 #endif
 
+#if defined(FDB_KV_USING_INDEX) && ((FDB_KV_INDEX_TABLE_SIZE & (FDB_KV_INDEX_TABLE_SIZE - 1)) != 0)
+#error "The KV index table size must be a power of 2"
+#endif
+
+/* the KV attribute bit is set when it's different from the erased value, so the KV which has no attribute is erased */
+#define KV_ATTR_NONE                             FDB_BYTE_ERASED
+#define KV_ATTR_COUNTER                          0x01
+#define KV_ATTR_LARGE                            0x02
+#define KV_ATTR_CHUNK                            0x04
+#define KV_ATTR_COMPRESS                         0x08
+#define kv_attr_is_set(attr, bit)                ((((attr) ^ FDB_BYTE_ERASED) & (bit)) != 0)
+
+#ifdef FDB_KV_USING_COUNTER
+/* the counter value is the base value and the step table, the step is programmed in place and NOT in the CRC32 */
+#define KV_COUNTER_DATA_SIZE                     FDB_WG_ALIGN(sizeof(uint32_t))
+#if (FDB_WRITE_GRAN == 1)
+#define KV_COUNTER_TABLE_SIZE                    ((FDB_KV_COUNTER_STEPS + 7) / 8)
+#else
+#define KV_COUNTER_TABLE_SIZE                    (FDB_KV_COUNTER_STEPS * (FDB_WRITE_GRAN / 8))
+#endif
+#define KV_COUNTER_VALUE_SIZE                    (KV_COUNTER_DATA_SIZE + KV_COUNTER_TABLE_SIZE)
+#endif /* FDB_KV_USING_COUNTER */
+
+#ifdef FDB_KV_USING_LARGE_BLOB
+#define KV_LARGE_MAGIC_WORD                      0x304C424C
+/* the chunk KV name is the large KV name + separator + generation + 4 hex digits chunk index */
+#define KV_CHUNK_NAME_SEP                        '\x1F'
+#define KV_CHUNK_NAME_SUFFIX_LEN                 6
+#define KV_CHUNK_NUM_MAX                         0x10000
+#define KV_LARGE_CHUNK_NUM(large)                (((large)->len + (large)->chunk_size - 1) / (large)->chunk_size)
+#endif /* FDB_KV_USING_LARGE_BLOB */
+
+#ifdef FDB_KV_USING_COMPRESS
+#if FDB_KV_COMPRESS_BUF_SIZE > 0xFFFF
+#error "The compressed KV value buffer size must less than 64KB"
+#endif
+/* the compressed KV value is the raw value length and the LZ block */
+#define KV_COMP_HDR_SIZE                         sizeof(uint32_t)
+#endif /* FDB_KV_USING_COMPRESS */
+
+/* the verified KV bitmap unit size, it MUST be less than the KV header size, so each KV has its own bit */
+#define KV_VERIFIED_UNIT                         16
+
+#define KV_INDEX_MASK                            (FDB_KV_INDEX_TABLE_SIZE - 1)
+/* the index is full when the used node is more than 7/8 of table, the probe sequence will be too long */
+#define KV_INDEX_NUM_MAX                         (FDB_KV_INDEX_TABLE_SIZE - FDB_KV_INDEX_TABLE_SIZE / 8)
+
 /* the sector is not combined value */
 #if (FDB_BYTE_ERASED  == 0xFF)
 #define SECTOR_NOT_COMBINED                      0xFFFFFFFF
@@ -68,6 +129,8 @@
 /* the next address is get failed */
 #define FAILED_ADDR                              0xFFFFFFFF
 
+#define SEC_STAT_UNKNOWN                         0xFFFFFFFF
+
 #define KV_STATUS_TABLE_SIZE                     FDB_STATUS_TABLE_SIZE(FDB_KV_STATUS_NUM)
 
 #define SECTOR_NUM                               (db_max_size(db) / db_sec_size(db))
@@ -80,13 +143,47 @@
 #define KV_MAGIC_OFFSET                          ((unsigned long)(&((struct kv_hdr_data *)0)->magic))
 #define KV_LEN_OFFSET                            ((unsigned long)(&((struct kv_hdr_data *)0)->len))
 #define KV_NAME_LEN_OFFSET                       ((unsigned long)(&((struct kv_hdr_data *)0)->name_len))
+#define KV_SNAPSHOT_SEQ_OFFSET                   ((unsigned long)(&((struct kv_snapshot_hdr *)0)->seq))
 
 #define db_name(db)                              (((fdb_db_t)db)->name)
 #define db_init_ok(db)                           (((fdb_db_t)db)->init_ok)
 #define db_sec_size(db)                          (((fdb_db_t)db)->sec_size)
 #define db_max_size(db)                          (((fdb_db_t)db)->max_size)
 #define db_oldest_addr(db)                       (((fdb_db_t)db)->oldest_addr)
+#ifdef FDB_KV_USING_INCREMENTAL_GC
+/* the GC budget is FDB_KV_GC_STEP_BUDGET until it's set by control command */
+#define db_gc_budget(db)                         ((db)->gc_budget_set ? (db)->gc_budget : FDB_KV_GC_STEP_BUDGET)
+#endif
+
+#ifdef FDB_KV_USING_RW_LOCK
+#define db_lock(db)                                                            \
+    do {                                                                       \
+        if (((fdb_db_t)db)->lock) ((fdb_db_t)db)->lock((fdb_db_t)db);          \
+        ((fdb_db_t)db)->wr_locked++;                                           \
+    } while(0);
+
+#define db_unlock(db)                                                          \
+    do {                                                                       \
+        ((fdb_db_t)db)->wr_locked--;                                           \
+        if (((fdb_db_t)db)->unlock) ((fdb_db_t)db)->unlock((fdb_db_t)db);      \
+    } while(0);
+
+/* the reader takes the exclusive lock when the shared read lock is NOT set */
+#define db_rdlock(db)                                                          \
+    do {                                                                       \
+        if (((fdb_db_t)db)->rdlock) ((fdb_db_t)db)->rdlock((fdb_db_t)db);      \
+        else db_lock(db)                                                       \
+    } while(0);
 
+#define db_rdunlock(db)                                                        \
+    do {                                                                       \
+        if (((fdb_db_t)db)->rdlock) {                                          \
+            if (((fdb_db_t)db)->rdunlock) ((fdb_db_t)db)->rdunlock((fdb_db_t)db); \
+        } else db_unlock(db)                                                   \
+    } while(0);
+
+#define db_rdlock_is_shared(db)                  (((fdb_db_t)db)->rdlock != NULL)
+#else
 #define db_lock(db)                                                            \
     do {                                                                       \
         if (((fdb_db_t)db)->lock) ((fdb_db_t)db)->lock((fdb_db_t)db);          \
@@ -97,8 +194,17 @@
         if (((fdb_db_t)db)->unlock) ((fdb_db_t)db)->unlock((fdb_db_t)db);      \
     } while(0);
 
+#define db_rdlock(db)                            db_lock(db)
+#define db_rdunlock(db)                          db_unlock(db)
+#define db_rdlock_is_shared(db)                  false
+#endif /* FDB_KV_USING_RW_LOCK */
+
 #define VER_NUM_KV_NAME                         "__ver_num__"
 
+#define KV_SNAPSHOT_MAGIC_WORD                   0x3044494B
+/* the sector states number which is read or written at once in the snapshot file */
+#define KV_SNAPSHOT_SEC_BUF_NUM                  16
+
 struct sector_hdr_data {
     struct {
         uint8_t store[FDB_STORE_STATUS_TABLE_SIZE];  /**< sector store status @see fdb_sector_store_status_t */
@@ -119,6 +225,8 @@ struct kv_hdr_data {
     uint32_t len;                                /**< KV node total length (header + name + value), must align by FDB_WRITE_GRAN */
     uint32_t crc32;                              /**< KV node crc32(name_len + data_len + name + value) */
     uint8_t name_len;                            /**< name length */
+    uint8_t attr;                                /**< KV attribute bits, it's erased by default, @see KV_ATTR_COUNTER */
+    uint8_t reserved[2];
     uint32_t value_len;                          /**< value length */
 #if (FDB_WRITE_GRAN == 64)
     uint8_t padding[4];                          /**< align padding for 64bit write granularity */
@@ -129,6 +237,43 @@ struct kv_hdr_data {
 };
 typedef struct kv_hdr_data *kv_hdr_data_t;
 
+/* the batch record is saved as the value of an empty name KV, which is in front of all KVs in the batch */
+struct kv_batch_data {
+    uint32_t magic;                              /**< magic word(`B`, `A`, `T`, `0`) */
+    uint32_t num;                                /**< the KV number in the batch */
+    uint32_t len;                                /**< the total length of the KVs behind the batch record */
+};
+
+#ifdef FDB_KV_USING_LARGE_BLOB
+/* the large blob record is saved as the value of the large KV, the blob value is saved in the chunk KVs */
+struct kv_large_data {
+    uint32_t magic;                              /**< magic word(`L`, `B`, `L`, `0`) */
+    uint32_t len;                                /**< blob value length */
+    uint32_t crc32;                              /**< blob value crc32 */
+    uint32_t chunk_size;                         /**< value size of the chunk KV, the last one may be less */
+    uint32_t gen;                                /**< generation of the chunk KVs, 0 or 1 */
+};
+#endif /* FDB_KV_USING_LARGE_BLOB */
+
+#ifdef FDB_KV_USING_INDEX_SNAPSHOT
+/* the snapshot file is made of the header, the states of all sectors and the KV index table */
+struct kv_snapshot_hdr {
+    uint32_t magic;                              /**< magic word(`K`, `I`, `D`, `0`) */
+    uint32_t crc32;                              /**< snapshot crc32(the data behind it, the sector states and the index table) */
+    uint32_t seq;                                /**< sequence number, it's increased by each snapshot */
+    uint32_t sec_size;                           /**< KVDB sector size */
+    uint32_t max_size;                           /**< KVDB max size */
+    uint32_t index_size;                         /**< KV index table size */
+};
+
+struct kv_snapshot_sec {
+    uint32_t empty_kv;                           /**< the next empty KV address, the KVs written after the snapshot are behind it */
+    uint8_t store;                               /**< sector store status @see fdb_sector_store_status_t */
+    uint8_t dirty;                               /**< sector dirty status @see fdb_sector_dirty_status_t */
+    uint8_t reserved[2];
+};
+#endif /* FDB_KV_USING_INDEX_SNAPSHOT */
+
 struct alloc_kv_cb_args {
     fdb_kvdb_t db;
     size_t kv_size;
@@ -143,12 +288,38 @@ struct gc_cb_args {
 
 static void gc_collect(fdb_kvdb_t db);
 static void gc_collect_by_free_size(fdb_kvdb_t db, size_t free_size);
+#ifdef FDB_KV_USING_INCREMENTAL_GC
+static bool gc_collect_step(fdb_kvdb_t db, size_t budget);
+#endif
+#ifdef FDB_KV_USING_LAZY_LOAD
+static bool is_kv_batch(fdb_kvdb_t db, fdb_kv_t kv, struct kv_batch_data *batch);
+static void finish_lazy_load(fdb_kvdb_t db);
+#endif
+#ifdef FDB_KV_USING_LARGE_BLOB
+static void del_chunk_kvs(fdb_kvdb_t db, const char *key, uint32_t gen, uint32_t num);
+#endif
 
 #ifdef FDB_KV_USING_CACHE
 static void update_sector_cache(fdb_kvdb_t db, kv_sec_info_t sector)
 {
     size_t i, empty_index = FDB_SECTOR_CACHE_TABLE_SIZE;
 
+    if (FDB_DB_IS_READ_SHARED(db)) {
+        /* the cache is only changed with the exclusive lock */
+        return;
+    }
+
+    if (db->sector_cache_all) {
+        /* the whole database sector cache, each sector has its own node */
+        kv_sec_info_t node = &db->sector_cache_all[sector->addr / db_sec_size(db)];
+        if (sector->check_ok) {
+            memcpy(node, sector, sizeof(struct kvdb_sec_info));
+        } else {
+            node->addr = FDB_DATA_UNUSED;
+        }
+        return;
+    }
+
     for (i = 0; i < FDB_SECTOR_CACHE_TABLE_SIZE; i++) {
         /* update the sector empty_addr in cache */
         if (db->sector_cache_table[i].addr == sector->addr) {
@@ -175,6 +346,11 @@ static kv_sec_info_t get_sector_from_cache(fdb_kvdb_t db, uint32_t sec_addr)
 {
     size_t i;
 
+    if (db->sector_cache_all) {
+        kv_sec_info_t node = &db->sector_cache_all[sec_addr / db_sec_size(db)];
+        return node->addr == sec_addr ? node : NULL;
+    }
+
     for (i = 0; i < FDB_SECTOR_CACHE_TABLE_SIZE; i++) {
         if (db->sector_cache_table[i].addr == sec_addr) {
             return &db->sector_cache_table[i];
@@ -204,12 +380,18 @@ static void update_sector_status_store_cache(fdb_kvdb_t db, uint32_t sec_addr, f
 static void update_kv_cache(fdb_kvdb_t db, const char *name, size_t name_len, uint32_t addr)
 {
     size_t i, empty_index = FDB_KV_CACHE_TABLE_SIZE, min_activity_index = FDB_KV_CACHE_TABLE_SIZE;
-    uint16_t name_crc = (uint16_t) (fdb_calc_crc32(0, name, name_len) >> 16), min_activity = 0xFFFF;
+    uint32_t name_crc = fdb_calc_crc32(0, name, name_len);
+    uint16_t min_activity = 0xFFFF;
+
+    if (FDB_DB_IS_READ_SHARED(db)) {
+        /* the cache is only changed with the exclusive lock */
+        return;
+    }
 
     for (i = 0; i < FDB_KV_CACHE_TABLE_SIZE; i++) {
         if (addr != FDB_DATA_UNUSED) {
             /* update the KV address in cache */
-            if (db->kv_cache_table[i].name_crc == name_crc) {
+            if (db->kv_cache_table[i].name_crc == name_crc && db->kv_cache_table[i].name_len == name_len) {
                 db->kv_cache_table[i].addr = addr;
                 return;
             } else if ((db->kv_cache_table[i].addr == FDB_DATA_UNUSED) && (empty_index == FDB_KV_CACHE_TABLE_SIZE)) {
@@ -223,7 +405,7 @@ static void update_kv_cache(fdb_kvdb_t db, const char *name, size_t name_len, ui
                     min_activity = db->kv_cache_table[i].active;
                 }
             }
-        } else if (db->kv_cache_table[i].name_crc == name_crc) {
+        } else if (db->kv_cache_table[i].name_crc == name_crc && db->kv_cache_table[i].name_len == name_len) {
             /* delete the KV */
             db->kv_cache_table[i].addr = FDB_DATA_UNUSED;
             db->kv_cache_table[i].active = 0;
@@ -234,30 +416,39 @@ static void update_kv_cache(fdb_kvdb_t db, const char *name, size_t name_len, ui
     if (empty_index < FDB_KV_CACHE_TABLE_SIZE) {
         db->kv_cache_table[empty_index].addr = addr;
         db->kv_cache_table[empty_index].name_crc = name_crc;
+        db->kv_cache_table[empty_index].name_len = name_len;
         db->kv_cache_table[empty_index].active = FDB_KV_CACHE_TABLE_SIZE;
     } else if (min_activity_index < FDB_KV_CACHE_TABLE_SIZE) {
         db->kv_cache_table[min_activity_index].addr = addr;
         db->kv_cache_table[min_activity_index].name_crc = name_crc;
+        db->kv_cache_table[min_activity_index].name_len = name_len;
         db->kv_cache_table[min_activity_index].active = FDB_KV_CACHE_TABLE_SIZE;
     }
 }
 
 /*
  * Get KV info from cache. It's return true when cache is hit.
+ * The KV name is NOT verified on flash when FDB_KV_CACHE_PARANOID is disabled, so the caller MUST check it after read.
  */
 static bool get_kv_from_cache(fdb_kvdb_t db, const char *name, size_t name_len, uint32_t *addr)
 {
     size_t i;
-    uint16_t name_crc = (uint16_t) (fdb_calc_crc32(0, name, name_len) >> 16);
+    uint32_t name_crc = fdb_calc_crc32(0, name, name_len);
 
     for (i = 0; i < FDB_KV_CACHE_TABLE_SIZE; i++) {
-        if ((db->kv_cache_table[i].addr != FDB_DATA_UNUSED) && (db->kv_cache_table[i].name_crc == name_crc)) {
-            char saved_name[FDB_KV_NAME_MAX] = { 0 };
+        if ((db->kv_cache_table[i].addr != FDB_DATA_UNUSED) && (db->kv_cache_table[i].name_crc == name_crc)
+                && (db->kv_cache_table[i].name_len == name_len)) {
+#ifdef FDB_KV_CACHE_PARANOID
+            char saved_name[FDB_WG_ALIGN(FDB_KV_NAME_MAX)];
             /* read the KV name in flash */
-            _fdb_flash_read((fdb_db_t)db, db->kv_cache_table[i].addr + KV_HDR_DATA_SIZE, (uint32_t *) saved_name, FDB_KV_NAME_MAX);
-            if (!strncmp(name, saved_name, name_len)) {
+            _fdb_flash_read((fdb_db_t)db, db->kv_cache_table[i].addr + KV_HDR_DATA_SIZE, (uint32_t *) saved_name, FDB_WG_ALIGN(name_len));
+            if (!memcmp(name, saved_name, name_len))
+#endif
+            {
                 *addr = db->kv_cache_table[i].addr;
-                if (db->kv_cache_table[i].active >= 0xFFFF - FDB_KV_CACHE_TABLE_SIZE) {
+                if (FDB_DB_IS_READ_SHARED(db)) {
+                    /* the activity is NOT increased by the shared readers */
+                } else if (db->kv_cache_table[i].active >= 0xFFFF - FDB_KV_CACHE_TABLE_SIZE) {
                     db->kv_cache_table[i].active = 0xFFFF;
                 } else {
                     db->kv_cache_table[i].active += FDB_KV_CACHE_TABLE_SIZE;
@@ -271,14 +462,211 @@ static bool get_kv_from_cache(fdb_kvdb_t db, const char *name, size_t name_len,
 }
 #endif /* FDB_KV_USING_CACHE */
 
+#ifdef FDB_KV_USING_INDEX
+/*
+ * Check the KV name on flash is same as the name.
+ */
+static bool kv_name_match(fdb_kvdb_t db, uint32_t addr, const char *name, size_t name_len)
+{
+    struct kv_hdr_data kv_hdr;
+    char saved_name[FDB_WG_ALIGN(FDB_KV_NAME_MAX)];
+
+    _fdb_flash_read((fdb_db_t)db, addr, (uint32_t *)&kv_hdr, sizeof(struct kv_hdr_data));
+    if (kv_hdr.magic != KV_MAGIC_WORD || kv_hdr.name_len != name_len) {
+        return false;
+    }
+    _fdb_flash_read((fdb_db_t)db, addr + KV_HDR_DATA_SIZE, (uint32_t *) saved_name, FDB_WG_ALIGN(name_len));
+
+    return !memcmp(name, saved_name, name_len);
+}
+
+/*
+ * Find the index node of the KV name, the empty node which the KV can be inserted is returned when not found.
+ * It returns NULL when the table is full and the KV name is not found.
+ */
+static kv_index_node_t find_kv_index_node(fdb_kvdb_t db, const char *name, size_t name_len, uint32_t name_crc)
+{
+    size_t i, pos = name_crc & KV_INDEX_MASK;
+    kv_index_node_t node;
+
+    for (i = 0; i < FDB_KV_INDEX_TABLE_SIZE; i++, pos = (pos + 1) & KV_INDEX_MASK) {
+        node = &db->kv_index_table[pos];
+        if (node->addr == FDB_DATA_UNUSED
+                || (node->name_crc == name_crc && kv_name_match(db, node->addr, name, name_len))) {
+            return node;
+        }
+    }
+
+    return NULL;
+}
+
+static void update_kv_index(fdb_kvdb_t db, const char *name, size_t name_len, uint32_t addr)
+{
+    uint32_t name_crc = fdb_calc_crc32(0, name, name_len);
+    kv_index_node_t node = find_kv_index_node(db, name, name_len, name_crc);
+
+    if (node && node->addr != FDB_DATA_UNUSED) {
+        node->addr = addr;
+    } else if (node && db->kv_index_num < KV_INDEX_NUM_MAX) {
+        node->name_crc = name_crc;
+        node->addr = addr;
+        db->kv_index_num++;
+    } else if (db->kv_index_ok) {
+        /* the KV which is not in the index will be searched on flash */
+        FDB_INFO("Warning: The KV index table is full, please increase the FDB_KV_INDEX_TABLE_SIZE.\n");
+        db->kv_index_ok = false;
+    }
+}
+
+/*
+ * Delete the KV index node which is pointing to the KV address.
+ */
+static void del_kv_index(fdb_kvdb_t db, const char *name, size_t name_len, uint32_t addr)
+{
+    size_t i, j, home, pos = fdb_calc_crc32(0, name, name_len) & KV_INDEX_MASK;
+
+    for (i = 0; i < FDB_KV_INDEX_TABLE_SIZE; i++, pos = (pos + 1) & KV_INDEX_MASK) {
+        if (db->kv_index_table[pos].addr == FDB_DATA_UNUSED) {
+            return;
+        } else if (db->kv_index_table[pos].addr == addr) {
+            break;
+        }
+    }
+    if (i == FDB_KV_INDEX_TABLE_SIZE) {
+        return;
+    }
+    /* shift the following nodes backward, so the probe sequence is not broken without the tombstone */
+    for (i = pos, j = (pos + 1) & KV_INDEX_MASK; db->kv_index_table[j].addr != FDB_DATA_UNUSED; j = (j + 1) & KV_INDEX_MASK) {
+        home = db->kv_index_table[j].name_crc & KV_INDEX_MASK;
+        /* the node can move to the hole when its home position is not in (hole, node] cyclically */
+        if (((j - home) & KV_INDEX_MASK) >= ((j - i) & KV_INDEX_MASK)) {
+            db->kv_index_table[i] = db->kv_index_table[j];
+            i = j;
+        }
+    }
+    db->kv_index_table[i].addr = FDB_DATA_UNUSED;
+    db->kv_index_num--;
+}
+
+static void reset_kv_index(fdb_kvdb_t db)
+{
+    size_t i;
+
+    for (i = 0; i < FDB_KV_INDEX_TABLE_SIZE; i++) {
+        db->kv_index_table[i].addr = FDB_DATA_UNUSED;
+    }
+    db->kv_index_num = 0;
+}
+#endif /* FDB_KV_USING_INDEX */
+
+#ifdef FDB_KV_USING_ORDERED_INDEX
+/*
+ * Compare the KV name of the ordered index node with the name by byte order. The saved name prefix is compared
+ * first, the full name is read from flash only when the prefix is same.
+ */
+static int kv_order_cmp(fdb_kvdb_t db, kv_order_node_t node, const char *name, size_t name_len)
+{
+    struct kv_hdr_data kv_hdr;
+    char saved_name[FDB_WG_ALIGN(FDB_KV_NAME_MAX)];
+    size_t len = name_len < FDB_KV_ORDER_KEY_LEN ? name_len : FDB_KV_ORDER_KEY_LEN;
+    int cmp;
+
+    if ((cmp = memcmp(node->key, name, len)) != 0) {
+        return cmp;
+    } else if (name_len < FDB_KV_ORDER_KEY_LEN) {
+        /* the saved name is longer when it's not end at here */
+        return node->key[name_len] != '\0';
+    }
+    /* the prefix is same, compare the full name on flash */
+    _fdb_flash_read((fdb_db_t)db, node->addr, (uint32_t *)&kv_hdr, sizeof(struct kv_hdr_data));
+    if (kv_hdr.name_len > FDB_KV_NAME_MAX) {
+        kv_hdr.name_len = FDB_KV_NAME_MAX;
+    }
+    _fdb_flash_read((fdb_db_t)db, node->addr + KV_HDR_DATA_SIZE, (uint32_t *) saved_name, FDB_WG_ALIGN(kv_hdr.name_len));
+    len = kv_hdr.name_len < name_len ? kv_hdr.name_len : name_len;
+    if ((cmp = memcmp(saved_name, name, len)) != 0) {
+        return cmp;
+    }
+
+    return (int)kv_hdr.name_len - (int)name_len;
+}
+
+/*
+ * Find the position of the first node which KV name is not less than the name.
+ */
+static size_t kv_order_lower_bound(fdb_kvdb_t db, const char *name, size_t name_len, bool *found)
+{
+    size_t low = 0, high = db->kv_order_num, mid;
+    int cmp;
+
+    *found = false;
+    while (low < high) {
+        mid = low + (high - low) / 2;
+        cmp = kv_order_cmp(db, &db->kv_order_table[mid], name, name_len);
+        if (cmp < 0) {
+            low = mid + 1;
+        } else {
+            *found = *found || cmp == 0;
+            high = mid;
+        }
+    }
+
+    return low;
+}
+
+static void update_kv_order(fdb_kvdb_t db, const char *name, size_t name_len, uint32_t addr)
+{
+    bool found;
+    size_t pos = kv_order_lower_bound(db, name, name_len, &found);
+    kv_order_node_t node = &db->kv_order_table[pos];
+
+    if (found) {
+        node->addr = addr;
+    } else if (db->kv_order_num < FDB_KV_ORDER_TABLE_SIZE) {
+        memmove(node + 1, node, (db->kv_order_num - pos) * sizeof(struct kv_order_node));
+        node->addr = addr;
+        memset(node->key, 0, sizeof(node->key));
+        memcpy(node->key, name, name_len < FDB_KV_ORDER_KEY_LEN ? name_len : FDB_KV_ORDER_KEY_LEN);
+        db->kv_order_num++;
+    } else if (db->kv_order_ok) {
+        /* the KV which is not in the ordered index will be iterated on flash */
+        FDB_INFO("Warning: The KV ordered index table is full, please increase the FDB_KV_ORDER_TABLE_SIZE.\n");
+        db->kv_order_ok = false;
+    }
+}
+
+/*
+ * Delete the KV ordered index node which is pointing to the KV address.
+ */
+static void del_kv_order(fdb_kvdb_t db, const char *name, size_t name_len, uint32_t addr)
+{
+    bool found;
+    size_t pos = kv_order_lower_bound(db, name, name_len, &found);
+    kv_order_node_t node = &db->kv_order_table[pos];
+
+    if (found && node->addr == addr) {
+        memmove(node, node + 1, (db->kv_order_num - pos - 1) * sizeof(struct kv_order_node));
+        db->kv_order_num--;
+    }
+}
+
+static void reset_kv_order(fdb_kvdb_t db)
+{
+    db->kv_order_num = 0;
+    db->kv_order_ok = true;
+}
+#endif /* FDB_KV_USING_ORDERED_INDEX */
+
 /*
  * find the next KV address by magic word on the flash
  */
 static uint32_t find_next_kv_addr(fdb_kvdb_t db, uint32_t start, uint32_t end)
 {
-    uint8_t buf[32];
-    uint32_t start_bak = start, i;
-    uint32_t magic;
+    uint32_t buf[FDB_KV_SCAN_BUF_SIZE / sizeof(uint32_t)];
+    const uint8_t *p = (const uint8_t *) buf;
+    uint8_t magic[sizeof(uint32_t)];
+    uint32_t addr, pattern, word;
+    size_t i, j, len;
 
 #ifdef FDB_KV_USING_CACHE
     kv_sec_info_t sector;
@@ -288,19 +676,50 @@ static uint32_t find_next_kv_addr(fdb_kvdb_t db, uint32_t start, uint32_t end)
     }
 #endif /* FDB_KV_USING_CACHE */
 
-    for (; start < end && start + sizeof(buf) < end; start += (sizeof(buf) - sizeof(uint32_t))) {
-        if (_fdb_flash_read((fdb_db_t)db, start, (uint32_t *) buf, sizeof(buf)) != FDB_NO_ERR)
-            return FAILED_ADDR;
-        for (i = 0; i < sizeof(buf) - sizeof(uint32_t) && start + i < end; i++) {
+    /* the magic word bytes on flash */
 #ifndef FDB_BIG_ENDIAN            /* Little Endian Order */
-            magic = buf[i] + ((uint32_t)buf[i + 1] << 8) + ((uint32_t)buf[i + 2] << 16) + ((uint32_t)buf[i + 3] << 24);
+    magic[0] = (uint8_t) KV_MAGIC_WORD;
+    magic[1] = (uint8_t) (KV_MAGIC_WORD >> 8);
+    magic[2] = (uint8_t) (KV_MAGIC_WORD >> 16);
+    magic[3] = (uint8_t) (KV_MAGIC_WORD >> 24);
 #else                       /* Big Endian Order */
-            magic = buf[i + 3] + ((uint32_t)buf[i + 2] << 8) + ((uint32_t)buf[i + 1] << 16) + ((uint32_t)buf[i] << 24);
+    magic[0] = (uint8_t) (KV_MAGIC_WORD >> 24);
+    magic[1] = (uint8_t) (KV_MAGIC_WORD >> 16);
+    magic[2] = (uint8_t) (KV_MAGIC_WORD >> 8);
+    magic[3] = (uint8_t) KV_MAGIC_WORD;
 #endif
-            if (magic == KV_MAGIC_WORD && (start + i - KV_MAGIC_OFFSET) >= start_bak) {
-                return start + i - KV_MAGIC_OFFSET;
+    addr = start + KV_MAGIC_OFFSET;
+    /* the next KV is usually just at the start address */
+    if (addr + sizeof(uint32_t) <= end) {
+        if (_fdb_flash_read((fdb_db_t)db, addr, buf, sizeof(uint32_t)) != FDB_NO_ERR)
+            return FAILED_ADDR;
+        if (!memcmp(p, magic, sizeof(magic))) {
+            return start;
+        }
+    }
+
+    pattern = magic[0] * 0x01010101UL;
+    /* the windows are overlapped by 3 bytes, so the magic word across the windows is found */
+    for (addr += 1; addr + sizeof(uint32_t) <= end; addr += len - (sizeof(uint32_t) - 1)) {
+        len = end - addr < sizeof(buf) ? end - addr : sizeof(buf);
+        if (_fdb_flash_read((fdb_db_t)db, addr, buf, len) != FDB_NO_ERR)
+            return FAILED_ADDR;
+        for (i = 0; i + sizeof(uint32_t) <= len; i += sizeof(uint32_t)) {
+            /* SWAR: the word has the first magic byte when (word ^ pattern) has a zero byte */
+            word = buf[i / sizeof(uint32_t)] ^ pattern;
+            if (((word - 0x01010101UL) & ~word & 0x80808080UL) == 0) {
+                continue;
+            }
+            /* verify the candidates */
+            for (j = i; j < i + sizeof(uint32_t) && j + sizeof(uint32_t) <= len; j++) {
+                if (p[j] == magic[0] && !memcmp(p + j, magic, sizeof(magic))) {
+                    return addr + j - KV_MAGIC_OFFSET;
+                }
             }
         }
+        if (len < sizeof(buf)) {
+            break;
+        }
     }
 
     return FAILED_ADDR;
@@ -342,7 +761,49 @@ static uint32_t get_next_kv_addr(fdb_kvdb_t db, kv_sec_info_t sector, fdb_kv_t p
     return addr;
 }
 
-static fdb_err_t read_kv(fdb_kvdb_t db, fdb_kv_t kv)
+#ifdef FDB_KV_CRC_VERIFY_ONCE
+static bool kv_is_verified(fdb_kvdb_t db, uint32_t addr)
+{
+    uint32_t bit = addr / KV_VERIFIED_UNIT;
+
+    if (bit >= FDB_KV_VERIFIED_MAP_SIZE * 8) {
+        return false;
+    }
+    return (db->kv_verified_map[bit / 8] & (1 << (bit % 8))) != 0;
+}
+
+static void set_kv_verified(fdb_kvdb_t db, uint32_t addr, bool verified)
+{
+    uint32_t bit = addr / KV_VERIFIED_UNIT;
+
+    if (bit >= FDB_KV_VERIFIED_MAP_SIZE * 8 || FDB_DB_IS_READ_SHARED(db)) {
+        return;
+    }
+    if (verified) {
+        db->kv_verified_map[bit / 8] |= 1 << (bit % 8);
+    } else {
+        db->kv_verified_map[bit / 8] &= ~(1 << (bit % 8));
+    }
+}
+
+/*
+ * Clear the verified KV marks of the sector, it's called when the sector is erased.
+ */
+static void clear_sector_verified(fdb_kvdb_t db, uint32_t sec_addr)
+{
+    uint32_t addr;
+
+    for (addr = sec_addr; addr < sec_addr + db_sec_size(db); addr += KV_VERIFIED_UNIT) {
+        set_kv_verified(db, addr, false);
+    }
+}
+#endif /* FDB_KV_CRC_VERIFY_ONCE */
+
+/*
+ * Read the KV. The CRC32 of the KV which is verified after boot is not checked again when FDB_KV_CRC_VERIFY_ONCE,
+ * unless force_check is true.
+ */
+static fdb_err_t read_kv_ex(fdb_kvdb_t db, fdb_kv_t kv, bool force_check)
 {
     struct kv_hdr_data kv_hdr;
     uint8_t buf[32];
@@ -353,6 +814,7 @@ static fdb_err_t read_kv(fdb_kvdb_t db, fdb_kv_t kv)
     _fdb_flash_read((fdb_db_t)db, kv->addr.start, (uint32_t *)&kv_hdr, sizeof(struct kv_hdr_data));
     kv->status = (fdb_kv_status_t) _fdb_get_status(kv_hdr.status_table, FDB_KV_STATUS_NUM);
     kv->len = kv_hdr.len;
+    kv->attr = kv_hdr.attr;
 
     if (kv->len == UINT32_MAX || kv->len > db_max_size(db) || kv->len < KV_HDR_DATA_SIZE) {
         /* the KV length was not write, so reserved the info for current KV */
@@ -360,7 +822,10 @@ static fdb_err_t read_kv(fdb_kvdb_t db, fdb_kv_t kv)
         if (kv->status != FDB_KV_ERR_HDR) {
             kv->status = FDB_KV_ERR_HDR;
             FDB_INFO("Error: The KV @0x%08" PRIX32 " length has an error.\n", kv->addr.start);
-            _fdb_write_status((fdb_db_t)db, kv->addr.start, kv_hdr.status_table, FDB_KV_STATUS_NUM, FDB_KV_ERR_HDR, true);
+            if (!FDB_DB_IS_READ_SHARED(db)) {
+                /* the shared reader leaves it to the next writer */
+                _fdb_write_status((fdb_db_t)db, kv->addr.start, kv_hdr.status_table, FDB_KV_STATUS_NUM, FDB_KV_ERR_HDR, true);
+            }
         }
         kv->crc_is_ok = false;
         return FDB_READ_ERR;
@@ -368,20 +833,36 @@ static fdb_err_t read_kv(fdb_kvdb_t db, fdb_kv_t kv)
         //TODO Sector continuous mode, or the write length is not written completely
     }
 
-    /* CRC32 data len(header.name_len + header.value_len + name + value), using sizeof(uint32_t) for compatible V1.x */
-    calc_crc32 = fdb_calc_crc32(calc_crc32, &kv_hdr.name_len, sizeof(uint32_t));
-    calc_crc32 = fdb_calc_crc32(calc_crc32, &kv_hdr.value_len, sizeof(uint32_t));
-    crc_data_len = kv->len - KV_HDR_DATA_SIZE;
-    /* calculate the CRC32 value */
-    for (len = 0, size = 0; len < crc_data_len; len += size) {
-        if (len + sizeof(buf) < crc_data_len) {
-            size = sizeof(buf);
-        } else {
-            size = crc_data_len - len;
+#ifdef FDB_KV_CRC_VERIFY_ONCE
+    if (!force_check && kv_is_verified(db, kv->addr.start)) {
+        /* the name and value is not changed after verified */
+        calc_crc32 = kv_hdr.crc32;
+    } else
+#else
+    (void)force_check;
+#endif
+    {
+        /* CRC32 data len(header.name_len + header.value_len + name + value), using sizeof(uint32_t) for compatible V1.x */
+        calc_crc32 = fdb_calc_crc32(calc_crc32, &kv_hdr.name_len, sizeof(uint32_t));
+        calc_crc32 = fdb_calc_crc32(calc_crc32, &kv_hdr.value_len, sizeof(uint32_t));
+        crc_data_len = kv->len - KV_HDR_DATA_SIZE;
+#ifdef FDB_KV_USING_COUNTER
+        if (kv_attr_is_set(kv_hdr.attr, KV_ATTR_COUNTER) && crc_data_len > KV_COUNTER_TABLE_SIZE) {
+            /* the counter step table is changed in place */
+            crc_data_len -= KV_COUNTER_TABLE_SIZE;
         }
+#endif
+        /* calculate the CRC32 value */
+        for (len = 0, size = 0; len < crc_data_len; len += size) {
+            if (len + sizeof(buf) < crc_data_len) {
+                size = sizeof(buf);
+            } else {
+                size = crc_data_len - len;
+            }
 
-        _fdb_flash_read((fdb_db_t)db, kv->addr.start + KV_HDR_DATA_SIZE + len, (uint32_t *) buf, FDB_WG_ALIGN(size));
-        calc_crc32 = fdb_calc_crc32(calc_crc32, buf, size);
+            _fdb_flash_read((fdb_db_t)db, kv->addr.start + KV_HDR_DATA_SIZE + len, (uint32_t *) buf, FDB_WG_ALIGN(size));
+            calc_crc32 = fdb_calc_crc32(calc_crc32, buf, size);
+        }
     }
     /* check CRC32 */
     if (calc_crc32 != kv_hdr.crc32) {
@@ -392,8 +873,14 @@ static fdb_err_t read_kv(fdb_kvdb_t db, fdb_kv_t kv)
         kv_name_addr = kv->addr.start + KV_HDR_DATA_SIZE;
         _fdb_flash_read((fdb_db_t)db, kv_name_addr, (uint32_t *)kv->name, FDB_WG_ALIGN(name_len));
         FDB_INFO("Error: Read the KV (%.*s@0x%08" PRIX32 ") CRC32 check failed!\n", name_len, kv->name, kv->addr.start);
+#ifdef FDB_KV_CRC_VERIFY_ONCE
+        set_kv_verified(db, kv->addr.start, false);
+#endif
     } else {
         kv->crc_is_ok = true;
+#ifdef FDB_KV_CRC_VERIFY_ONCE
+        set_kv_verified(db, kv->addr.start, true);
+#endif
         /* the name is behind aligned KV header */
         kv_name_addr = kv->addr.start + KV_HDR_DATA_SIZE;
         _fdb_flash_read((fdb_db_t)db, kv_name_addr, (uint32_t *) kv->name, FDB_WG_ALIGN(kv_hdr.name_len));
@@ -410,59 +897,326 @@ static fdb_err_t read_kv(fdb_kvdb_t db, fdb_kv_t kv)
     return result;
 }
 
-static fdb_err_t read_sector_info(fdb_kvdb_t db, uint32_t addr, kv_sec_info_t sector, bool traversal)
+static fdb_err_t read_kv(fdb_kvdb_t db, fdb_kv_t kv)
 {
-    fdb_err_t result = FDB_NO_ERR;
-    struct sector_hdr_data sec_hdr = { 0 };
+    return read_kv_ex(db, kv, false);
+}
 
-    FDB_ASSERT(addr % db_sec_size(db) == 0);
-    FDB_ASSERT(sector);
+static bool kv_name_is_same(fdb_kv_t kv, const char *name, size_t name_len)
+{
+    return kv->crc_is_ok && kv->name_len == name_len && !strncmp(kv->name, name, name_len);
+}
 
-#ifdef FDB_KV_USING_CACHE
-    kv_sec_info_t sector_cache = get_sector_from_cache(db, addr);
-    if (sector_cache && ((!traversal) || (traversal && sector_cache->empty_kv != FAILED_ADDR))) {
-        memcpy(sector, sector_cache, sizeof(struct kvdb_sec_info));
-        return result;
+#ifdef FDB_KV_USING_COUNTER
+static bool kv_is_counter(fdb_kv_t kv)
+{
+    return kv->crc_is_ok && kv->value_len == KV_COUNTER_VALUE_SIZE && kv_attr_is_set(kv->attr, KV_ATTR_COUNTER);
+}
+
+/*
+ * Read the used step number of the counter step table. The steps are programmed in order, from the MSB of the first
+ * byte when the write granularity is 1 bit, otherwise one write granularity unit per step.
+ */
+static size_t read_counter_steps(fdb_kvdb_t db, uint32_t table_addr)
+{
+    uint8_t buf[32];
+    size_t steps = 0, len, size, i;
+
+    for (len = 0; len < KV_COUNTER_TABLE_SIZE; len += size) {
+        size = KV_COUNTER_TABLE_SIZE - len < sizeof(buf) ? KV_COUNTER_TABLE_SIZE - len : sizeof(buf);
+        _fdb_flash_read((fdb_db_t)db, table_addr + len, (uint32_t *) buf, size);
+#if (FDB_WRITE_GRAN == 1)
+        for (i = 0; i < size; i++) {
+            uint8_t bit;
+            for (bit = 0x80; bit && ((buf[i] ^ FDB_BYTE_ERASED) & bit); bit >>= 1) {
+                steps++;
+            }
+            if (bit) {
+                return steps;
+            }
+        }
+#else
+        for (i = 0; i < size; i += FDB_WRITE_GRAN / 8) {
+            if (buf[i] != FDB_BYTE_WRITTEN) {
+                return steps;
+            }
+            steps++;
+        }
+#endif /* FDB_WRITE_GRAN == 1 */
     }
-#endif /* FDB_KV_USING_CACHE */
 
-    /* read sector header raw data */
-    _fdb_flash_read((fdb_db_t)db, addr, (uint32_t *)&sec_hdr, sizeof(struct sector_hdr_data));
+    return steps;
+}
 
-    sector->status.store = FDB_SECTOR_STORE_UNUSED;
-    sector->status.dirty = FDB_SECTOR_DIRTY_UNUSED;
-    sector->addr = addr;
-    sector->magic = sec_hdr.magic;
-    /* check magic word and combined value */
-    if (sector->magic != SECTOR_MAGIC_WORD || 
-        (sec_hdr.combined != SECTOR_NOT_COMBINED && sec_hdr.combined != SECTOR_COMBINED)) {
-        sector->check_ok = false;
-        sector->combined = SECTOR_NOT_COMBINED;
-        return FDB_INIT_FAILED;
+/*
+ * Program the steps [from, to) of the counter step table, each write granularity unit is programmed only once.
+ */
+static fdb_err_t write_counter_steps(fdb_kvdb_t db, uint32_t table_addr, size_t from, size_t to)
+{
+    fdb_err_t result = FDB_NO_ERR;
+    uint8_t buf[32];
+    size_t i, n;
+
+#if (FDB_WRITE_GRAN == 1)
+    /* the programmed bits are programmed again, it's allowed when the write granularity is 1 bit */
+    for (i = from / 8; result == FDB_NO_ERR && i < (to + 7) / 8; i += n) {
+        for (n = 0; n < sizeof(buf) && i + n < (to + 7) / 8; n++) {
+            size_t bits = to - (i + n) * 8 > 8 ? 8 : to - (i + n) * 8;
+#if (FDB_BYTE_ERASED == 0xFF)
+            buf[n] = (uint8_t)(0xFF >> bits);
+#else
+            buf[n] = (uint8_t)~(0xFF >> bits);
+#endif
+        }
+        result = _fdb_flash_write((fdb_db_t)db, table_addr + i, (uint32_t *) buf, n, true);
     }
-    sector->check_ok = true;
-    /* get other sector info */
-    sector->combined = sec_hdr.combined;
-    sector->status.store = (fdb_sector_store_status_t) _fdb_get_status(sec_hdr.status_table.store, FDB_SECTOR_STORE_STATUS_NUM);
-    sector->status.dirty = (fdb_sector_dirty_status_t) _fdb_get_status(sec_hdr.status_table.dirty, FDB_SECTOR_DIRTY_STATUS_NUM);
-    /* traversal all KV and calculate the remain space size */
-    if (traversal) {
-        sector->remain = 0;
-        sector->empty_kv = sector->addr + SECTOR_HDR_DATA_SIZE;
-        if (sector->status.store == FDB_SECTOR_STORE_EMPTY) {
-            sector->remain = db_sec_size(db) - SECTOR_HDR_DATA_SIZE;
+#else
+    for (i = from; result == FDB_NO_ERR && i < to; i += n) {
+        n = (to - i) * (FDB_WRITE_GRAN / 8) < sizeof(buf) ? to - i : sizeof(buf) / (FDB_WRITE_GRAN / 8);
+        memset(buf, FDB_BYTE_ERASED, sizeof(buf));
+        for (size_t j = 0; j < n; j++) {
+            buf[j * (FDB_WRITE_GRAN / 8)] = FDB_BYTE_WRITTEN;
         }
-        else if (sector->status.store == FDB_SECTOR_STORE_USING) {
-            struct fdb_kv kv_obj;
+        result = _fdb_flash_write((fdb_db_t)db, table_addr + i * (FDB_WRITE_GRAN / 8), (uint32_t *) buf,
+                n * (FDB_WRITE_GRAN / 8), true);
+    }
+#endif /* FDB_WRITE_GRAN == 1 */
 
-            sector->remain = db_sec_size(db) - SECTOR_HDR_DATA_SIZE;
-            kv_obj.addr.start = sector->addr + SECTOR_HDR_DATA_SIZE;
-            do {
-                read_kv(db, &kv_obj);
-                if (!kv_obj.crc_is_ok) {
-                    if (kv_obj.status != FDB_KV_PRE_WRITE && kv_obj.status != FDB_KV_ERR_HDR) {
-                        sector->remain = 0;
-                        result = FDB_READ_ERR;
+    return result;
+}
+
+/*
+ * Read the counter value, it's the base value plus the used steps.
+ */
+static uint32_t read_counter(fdb_kvdb_t db, fdb_kv_t kv, size_t *steps)
+{
+    uint32_t base;
+    size_t used;
+
+    _fdb_flash_read((fdb_db_t)db, kv->addr.value, &base, sizeof(uint32_t));
+    used = read_counter_steps(db, kv->addr.value + KV_COUNTER_DATA_SIZE);
+    if (steps) {
+        *steps = used;
+    }
+
+    return base + (uint32_t)used;
+}
+#endif /* FDB_KV_USING_COUNTER */
+
+#ifdef FDB_KV_USING_GC_COST_BENEFIT
+static kv_sec_stat_t get_sec_stat_node(fdb_kvdb_t db, uint32_t addr)
+{
+    size_t index = addr / db_sec_size(db);
+
+    if (index < FDB_KV_GC_SEC_NUM_MAX && db->sec_stat_table[index].garbage != SEC_STAT_UNKNOWN) {
+        return &db->sec_stat_table[index];
+    }
+
+    return NULL;
+}
+
+/*
+ * the new KV is written in the sector
+ */
+static void sec_stat_add_kv(fdb_kvdb_t db, uint32_t kv_addr, uint32_t len, bool live)
+{
+    kv_sec_stat_t stat = get_sec_stat_node(db, kv_addr);
+
+    if (stat) {
+        if (live) {
+            stat->live += len;
+        } else {
+            stat->garbage += len;
+        }
+    }
+}
+
+/*
+ * the live KV is deleted
+ */
+static void sec_stat_del_kv(fdb_kvdb_t db, uint32_t kv_addr, uint32_t len)
+{
+    kv_sec_stat_t stat = get_sec_stat_node(db, kv_addr);
+
+    if (stat) {
+        stat->live = stat->live > len ? stat->live - len : 0;
+        stat->garbage += len;
+    }
+}
+
+/*
+ * the empty sector is used, it's the newest sector for the GC age
+ */
+static void sec_stat_use_sector(fdb_kvdb_t db, uint32_t sec_addr)
+{
+    size_t index = sec_addr / db_sec_size(db);
+
+    if (index < FDB_KV_GC_SEC_NUM_MAX) {
+        db->sec_stat_table[index].seq = ++db->sec_seq;
+    }
+}
+
+/*
+ * get the sector age by the write sequence, the sector out of the table is aged by the ring order
+ */
+static uint32_t get_sec_age(fdb_kvdb_t db, uint32_t sec_addr, uint32_t ring_age)
+{
+    size_t index = sec_addr / db_sec_size(db);
+
+    if (index < FDB_KV_GC_SEC_NUM_MAX) {
+        return db->sec_seq - db->sec_stat_table[index].seq + 1;
+    }
+
+    return ring_age;
+}
+
+static void reset_sec_stat(fdb_kvdb_t db, uint32_t sec_addr, bool unknown)
+{
+    size_t index = sec_addr / db_sec_size(db);
+
+    if (index < FDB_KV_GC_SEC_NUM_MAX) {
+        db->sec_stat_table[index].live = 0;
+        db->sec_stat_table[index].garbage = unknown ? SEC_STAT_UNKNOWN : 0;
+    }
+}
+
+/*
+ * get the live and garbage size of the sector, the unknown one is counted by the sector traversal
+ */
+static void get_sec_stat(fdb_kvdb_t db, kv_sec_info_t sector, uint32_t *live, uint32_t *garbage)
+{
+    kv_sec_stat_t stat = get_sec_stat_node(db, sector->addr);
+    struct fdb_kv kv;
+    uint32_t len, sec_end = sector->addr + db_sec_size(db);
+    size_t index = sector->addr / db_sec_size(db);
+
+    if (stat) {
+        *live = stat->live;
+        *garbage = stat->garbage;
+        return;
+    }
+
+    *live = 0;
+    *garbage = 0;
+    if (sector->status.store == FDB_SECTOR_STORE_USING || sector->status.store == FDB_SECTOR_STORE_FULL) {
+        kv.addr.start = sector->addr + SECTOR_HDR_DATA_SIZE;
+        do {
+            read_kv(db, &kv);
+            len = kv.len < sec_end - kv.addr.start ? kv.len : sec_end - kv.addr.start;
+            if (kv.crc_is_ok && (kv.status == FDB_KV_WRITE || kv.status == FDB_KV_PRE_DELETE)) {
+                *live += len;
+            } else {
+                *garbage += len;
+            }
+        } while ((kv.addr.start = get_next_kv_addr(db, sector, &kv)) != FAILED_ADDR);
+    }
+    if (index < FDB_KV_GC_SEC_NUM_MAX) {
+        db->sec_stat_table[index].live = *live;
+        db->sec_stat_table[index].garbage = *garbage;
+    }
+}
+#endif /* FDB_KV_USING_GC_COST_BENEFIT */
+
+#ifdef FDB_KV_USING_FREE_MAP
+static kv_free_node_t get_free_map_node(fdb_kvdb_t db, uint32_t addr)
+{
+    if (db->free_map_ok) {
+        return &db->free_map[addr / db_sec_size(db)];
+    }
+
+    return NULL;
+}
+
+/*
+ * Update the sector status and empty KV address in the free-space map.
+ */
+static void update_free_map(fdb_kvdb_t db, uint32_t sec_addr, fdb_sector_store_status_t store, uint32_t empty_kv)
+{
+    kv_free_node_t node = get_free_map_node(db, sec_addr);
+
+    if (node) {
+        node->store = store;
+        node->empty_kv = empty_kv;
+    }
+}
+
+static void update_free_map_dirty(fdb_kvdb_t db, uint32_t sec_addr, fdb_sector_dirty_status_t dirty)
+{
+    kv_free_node_t node = get_free_map_node(db, sec_addr);
+
+    if (node) {
+        node->dirty = dirty;
+    }
+}
+#endif /* FDB_KV_USING_FREE_MAP */
+
+#ifdef FDB_KV_USING_INDEX_SNAPSHOT
+/*
+ * Clean the snapshot file, it MUST be done before any sector is erased. The snapshot is valid until then, because
+ * the KVs written after it are always behind the empty KV address of the sector in the snapshot.
+ */
+static void clean_kv_snapshot(fdb_kvdb_t db)
+{
+    if (db->snap_valid) {
+        _fdb_file_ext_truncate(db->snap_file, 0);
+        db->snap_valid = false;
+    }
+}
+#endif /* FDB_KV_USING_INDEX_SNAPSHOT */
+
+static fdb_err_t read_sector_info(fdb_kvdb_t db, uint32_t addr, kv_sec_info_t sector, bool traversal)
+{
+    fdb_err_t result = FDB_NO_ERR;
+    struct sector_hdr_data sec_hdr = { 0 };
+
+    FDB_ASSERT(addr % db_sec_size(db) == 0);
+    FDB_ASSERT(sector);
+
+#ifdef FDB_KV_USING_CACHE
+    kv_sec_info_t sector_cache = get_sector_from_cache(db, addr);
+    if (sector_cache && ((!traversal) || (traversal && sector_cache->empty_kv != FAILED_ADDR))) {
+        memcpy(sector, sector_cache, sizeof(struct kvdb_sec_info));
+        return result;
+    }
+#endif /* FDB_KV_USING_CACHE */
+
+    /* read sector header raw data */
+    _fdb_flash_read((fdb_db_t)db, addr, (uint32_t *)&sec_hdr, sizeof(struct sector_hdr_data));
+
+    sector->status.store = FDB_SECTOR_STORE_UNUSED;
+    sector->status.dirty = FDB_SECTOR_DIRTY_UNUSED;
+    sector->addr = addr;
+    sector->magic = sec_hdr.magic;
+    /* check magic word and combined value */
+    if (sector->magic != SECTOR_MAGIC_WORD || 
+        (sec_hdr.combined != SECTOR_NOT_COMBINED && sec_hdr.combined != SECTOR_COMBINED)) {
+        sector->check_ok = false;
+        sector->combined = SECTOR_NOT_COMBINED;
+        return FDB_INIT_FAILED;
+    }
+    sector->check_ok = true;
+    /* get other sector info */
+    sector->combined = sec_hdr.combined;
+    sector->status.store = (fdb_sector_store_status_t) _fdb_get_status(sec_hdr.status_table.store, FDB_SECTOR_STORE_STATUS_NUM);
+    sector->status.dirty = (fdb_sector_dirty_status_t) _fdb_get_status(sec_hdr.status_table.dirty, FDB_SECTOR_DIRTY_STATUS_NUM);
+    /* traversal all KV and calculate the remain space size */
+    if (traversal) {
+        sector->remain = 0;
+        sector->empty_kv = sector->addr + SECTOR_HDR_DATA_SIZE;
+        if (sector->status.store == FDB_SECTOR_STORE_EMPTY) {
+            sector->remain = db_sec_size(db) - SECTOR_HDR_DATA_SIZE;
+        }
+        else if (sector->status.store == FDB_SECTOR_STORE_USING) {
+            struct fdb_kv kv_obj;
+
+            sector->remain = db_sec_size(db) - SECTOR_HDR_DATA_SIZE;
+            kv_obj.addr.start = sector->addr + SECTOR_HDR_DATA_SIZE;
+            do {
+                read_kv(db, &kv_obj);
+                if (!kv_obj.crc_is_ok) {
+                    if (kv_obj.status != FDB_KV_PRE_WRITE && kv_obj.status != FDB_KV_ERR_HDR) {
+                        sector->remain = 0;
+                        result = FDB_READ_ERR;
                         break;
                     }
                 }
@@ -579,20 +1333,135 @@ static bool find_kv_no_cache(fdb_kvdb_t db, const char *key, fdb_kv_t kv)
     return find_ok;
 }
 
+#ifdef FDB_KV_USING_LAZY_LOAD
+/* the level of the KV which is found before the recovery check, the higher one is the current value */
+#define KV_LAZY_FOUND_NONE             0
+#define KV_LAZY_FOUND_PRE_DELETE       1
+#define KV_LAZY_FOUND_WRITE            2
+#define KV_LAZY_FOUND_BATCH            3
+
+struct kv_lazy_find {
+    const char *key;
+    size_t key_len;
+    uint32_t addr;
+    uint8_t level;
+    uint32_t batch_start;                        /**< the KVs in the committed batch, they are KV_WRITE after recovery */
+    uint32_t batch_end;
+};
+
+static bool find_kv_lazy_cb(fdb_kv_t kv, void *arg1, void *arg2)
+{
+    fdb_kvdb_t db = arg1;
+    struct kv_lazy_find *find = arg2;
+    struct kv_batch_data batch;
+    uint8_t level = KV_LAZY_FOUND_NONE;
+
+    if (kv->status == FDB_KV_WRITE && is_kv_batch(db, kv, &batch)) {
+        find->batch_start = kv->addr.start + kv->len;
+        find->batch_end = find->batch_start + batch.len;
+        return false;
+    }
+    if (!kv_name_is_same(kv, find->key, find->key_len)) {
+        return false;
+    }
+    if ((kv->status == FDB_KV_PRE_WRITE || kv->status == FDB_KV_WRITE) && kv->addr.start >= find->batch_start
+            && kv->addr.start < find->batch_end) {
+        level = KV_LAZY_FOUND_BATCH;
+    } else if (kv->status == FDB_KV_WRITE) {
+        level = KV_LAZY_FOUND_WRITE;
+    } else if (kv->status == FDB_KV_PRE_DELETE) {
+        level = KV_LAZY_FOUND_PRE_DELETE;
+    }
+    if (level != KV_LAZY_FOUND_NONE && level >= find->level) {
+        find->level = level;
+        find->addr = kv->addr.start;
+    }
+
+    return false;
+}
+
+/*
+ * Find the KV before the recovery check. All KVs are checked, the KV is resolved as the recovery check does,
+ * e.g. the pre-deleted KV is used when its new KV is NOT written.
+ */
+static bool find_kv_lazy(fdb_kvdb_t db, const char *key, fdb_kv_t kv)
+{
+    struct kv_lazy_find find;
+
+    find.key = key;
+    find.key_len = strlen(key);
+    find.addr = FAILED_ADDR;
+    find.level = KV_LAZY_FOUND_NONE;
+    find.batch_start = find.batch_end = FAILED_ADDR;
+    kv_iterator(db, kv, db, &find, find_kv_lazy_cb);
+    if (find.level == KV_LAZY_FOUND_NONE) {
+        return false;
+    }
+    kv->addr.start = find.addr;
+    read_kv(db, kv);
+
+    return true;
+}
+#endif /* FDB_KV_USING_LAZY_LOAD */
+
+#ifdef FDB_KV_USING_INDEX
+/*
+ * Read the KV from index. The KV name is checked after the KV read, so it's no extra flash read for the name.
+ */
+static bool read_kv_from_index(fdb_kvdb_t db, const char *name, size_t name_len, fdb_kv_t kv)
+{
+    uint32_t name_crc = fdb_calc_crc32(0, name, name_len);
+    size_t i, pos = name_crc & KV_INDEX_MASK;
+
+    for (i = 0; i < FDB_KV_INDEX_TABLE_SIZE && db->kv_index_table[pos].addr != FDB_DATA_UNUSED;
+            i++, pos = (pos + 1) & KV_INDEX_MASK) {
+        if (db->kv_index_table[pos].name_crc == name_crc) {
+            kv->addr.start = db->kv_index_table[pos].addr;
+            read_kv(db, kv);
+            if (kv_name_is_same(kv, name, name_len)) {
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+#endif /* FDB_KV_USING_INDEX */
+
 static bool find_kv(fdb_kvdb_t db, const char *key, fdb_kv_t kv)
 {
     bool find_ok = false;
 
-#ifdef FDB_KV_USING_CACHE
+#if defined(FDB_KV_USING_CACHE) || defined(FDB_KV_USING_INDEX)
     size_t key_len = strlen(key);
+#endif
+
+#ifdef FDB_KV_USING_INDEX
+    if (read_kv_from_index(db, key, key_len, kv)) {
+        return true;
+    } else if (db->kv_index_ok) {
+        return false;
+    }
+#endif /* FDB_KV_USING_INDEX */
 
+#ifdef FDB_KV_USING_CACHE
     if (get_kv_from_cache(db, key, key_len, &kv->addr.start)) {
         read_kv(db, kv);
-        return true;
+        /* the cache node is matched by the name CRC32 and length, so check the name which is read with the KV */
+        if (kv_name_is_same(kv, key, key_len)) {
+            return true;
+        }
     }
 #endif /* FDB_KV_USING_CACHE */
 
-    find_ok = find_kv_no_cache(db, key, kv);
+#ifdef FDB_KV_USING_LAZY_LOAD
+    if (db->lazy_pending) {
+        find_ok = find_kv_lazy(db, key, kv);
+    } else
+#endif
+    {
+        find_ok = find_kv_no_cache(db, key, kv);
+    }
 
 #ifdef FDB_KV_USING_CACHE
     if (find_ok) {
@@ -616,12 +1485,138 @@ static bool fdb_is_str(uint8_t *value, size_t len)
     return true;
 }
 
+#ifdef FDB_KV_USING_LARGE_BLOB
+static void make_chunk_name(char *name, const char *key, uint32_t gen, uint32_t index)
+{
+    static const char hex[] = "0123456789ABCDEF";
+    char suffix[KV_CHUNK_NAME_SUFFIX_LEN + 1];
+    size_t key_len = strlen(key);
+
+    /* the suffix is the separator, the generation (0 or 1) and the 4 hex digits index, the key length is checked
+     * with the suffix length when the large KV is set */
+    suffix[0] = KV_CHUNK_NAME_SEP;
+    suffix[1] = (char)('0' + gen);
+    suffix[2] = hex[(index >> 12) & 0xF];
+    suffix[3] = hex[(index >> 8) & 0xF];
+    suffix[4] = hex[(index >> 4) & 0xF];
+    suffix[5] = hex[index & 0xF];
+    suffix[6] = '\0';
+    memcpy(name, key, key_len);
+    memcpy(name + key_len, suffix, sizeof(suffix));
+}
+
+/*
+ * Read the large blob record of the KV, it returns false when the KV is NOT a large KV.
+ */
+static bool read_large_kv(fdb_kvdb_t db, fdb_kv_t kv, struct kv_large_data *large)
+{
+    if (!kv->crc_is_ok || !kv_attr_is_set(kv->attr, KV_ATTR_LARGE) || kv->value_len != sizeof(struct kv_large_data)) {
+        return false;
+    }
+    _fdb_flash_read((fdb_db_t)db, kv->addr.value, (uint32_t *) large, sizeof(struct kv_large_data));
+
+    return large->magic == KV_LARGE_MAGIC_WORD && large->chunk_size > 0 && large->gen <= 1;
+}
+
+/*
+ * Read the large blob value from the offset, only the chunk KVs which are in the range are read.
+ */
+static size_t read_large_value(fdb_kvdb_t db, const char *key, struct kv_large_data *large, size_t offset, void *buf,
+        size_t len)
+{
+    char name[FDB_KV_NAME_MAX + 1];
+    struct fdb_kv chunk;
+    size_t read_len = 0, chunk_offset, size;
+
+    if (offset >= large->len) {
+        return 0;
+    } else if (len > large->len - offset) {
+        len = large->len - offset;
+    }
+
+    while (read_len < len) {
+        make_chunk_name(name, key, large->gen, (offset + read_len) / large->chunk_size);
+        chunk_offset = (offset + read_len) % large->chunk_size;
+        size = large->chunk_size - chunk_offset < len - read_len ? large->chunk_size - chunk_offset : len - read_len;
+        if (!find_kv(db, name, &chunk) || chunk.value_len < chunk_offset + size) {
+            FDB_INFO("Error: The chunk KV (%" PRIu32 ") of the large KV (%s) is lost.\n",
+                    (uint32_t)((offset + read_len) / large->chunk_size), key);
+            break;
+        }
+        _fdb_flash_read((fdb_db_t)db, chunk.addr.value + chunk_offset, (uint32_t *)((uint8_t *) buf + read_len), size);
+        read_len += size;
+    }
+
+    return read_len;
+}
+
+static size_t get_large_kv(fdb_kvdb_t db, const char *key, struct kv_large_data *large, void *value_buf,
+        size_t buf_len, size_t *value_len)
+{
+    size_t read_len = buf_len > large->len ? large->len : buf_len;
+
+    if (value_len) {
+        *value_len = large->len;
+    }
+    if (value_buf && read_len > 0) {
+        if (read_large_value(db, key, large, 0, value_buf, read_len) != read_len) {
+            read_len = 0;
+        } else if (read_len == large->len && fdb_calc_crc32(0, value_buf, read_len) != large->crc32) {
+            /* the whole value CRC32 is checked when the whole value is read */
+            FDB_INFO("Error: Read the large KV (%s) CRC32 check failed!\n", key);
+            read_len = 0;
+        }
+    }
+
+    return read_len;
+}
+#endif /* FDB_KV_USING_LARGE_BLOB */
+
+#ifdef FDB_KV_USING_COMPRESS
+/*
+ * Get the compressed KV value. The value is decompressed from flash directly to the value buffer.
+ */
+static size_t get_comp_kv(fdb_kvdb_t db, fdb_kv_t kv, void *value_buf, size_t buf_len, size_t *value_len)
+{
+    uint32_t raw_len = 0;
+    size_t read_len;
+
+    _fdb_flash_read((fdb_db_t)db, kv->addr.value, &raw_len, sizeof(raw_len));
+    if (value_len) {
+        *value_len = raw_len;
+    }
+    read_len = buf_len > raw_len ? raw_len : buf_len;
+    if (value_buf && read_len > 0) {
+        if (_fdb_lz_decompress_flash((fdb_db_t)db, kv->addr.value + KV_COMP_HDR_SIZE, kv->value_len - KV_COMP_HDR_SIZE,
+                value_buf, read_len) != read_len) {
+            FDB_INFO("Error: Decompress the KV (%.*s) value failed!\n", kv->name_len, kv->name);
+            read_len = 0;
+        }
+    }
+
+    return read_len;
+}
+#endif /* FDB_KV_USING_COMPRESS */
+
 static size_t get_kv(fdb_kvdb_t db, const char *key, void *value_buf, size_t buf_len, size_t *value_len)
 {
     struct fdb_kv kv;
     size_t read_len = 0;
+#ifdef FDB_KV_USING_LARGE_BLOB
+    struct kv_large_data large;
+#endif
 
     if (find_kv(db, key, &kv)) {
+#ifdef FDB_KV_USING_LARGE_BLOB
+        if (read_large_kv(db, &kv, &large)) {
+            return get_large_kv(db, key, &large, value_buf, buf_len, value_len);
+        }
+#endif
+#ifdef FDB_KV_USING_COMPRESS
+        if (kv_attr_is_set(kv.attr, KV_ATTR_COMPRESS)) {
+            return get_comp_kv(db, &kv, value_buf, buf_len, value_len);
+        }
+#endif
         if (value_len) {
             *value_len = kv.value_len;
         }
@@ -659,12 +1654,12 @@ fdb_kv_t fdb_kv_get_obj(fdb_kvdb_t db, const char *key, fdb_kv_t kv)
     }
 
     /* lock the KV cache */
-    db_lock(db);
+    db_rdlock(db);
 
     find_ok = find_kv(db, key, kv);
 
     /* unlock the KV cache */
-    db_unlock(db);
+    db_rdunlock(db);
 
     return find_ok ? kv : NULL;
 }
@@ -705,12 +1700,12 @@ size_t fdb_kv_get_blob(fdb_kvdb_t db, const char *key, fdb_blob_t blob)
     }
 
     /* lock the KV cache */
-    db_lock(db);
+    db_rdlock(db);
 
     read_len = get_kv(db, key, blob->buf, blob->size, &blob->saved.len);
 
     /* unlock the KV cache */
-    db_unlock(db);
+    db_rdunlock(db);
 
     return read_len;
 }
@@ -770,9 +1765,19 @@ static fdb_err_t format_sector(fdb_kvdb_t db, uint32_t addr, uint32_t combined_v
 
     FDB_ASSERT(addr % db_sec_size(db) == 0);
 
-    result = _fdb_flash_erase((fdb_db_t)db, addr, db_sec_size(db));
-    if (result == FDB_NO_ERR) {
-        /* initialize the header data */
+#ifdef FDB_KV_CRC_VERIFY_ONCE
+    clear_sector_verified(db, addr);
+#endif
+#ifdef FDB_KV_USING_GC_COST_BENEFIT
+    reset_sec_stat(db, addr, false);
+#endif
+#ifdef FDB_KV_USING_INDEX_SNAPSHOT
+    clean_kv_snapshot(db);
+#endif
+
+    result = _fdb_flash_erase((fdb_db_t)db, addr, db_sec_size(db));
+    if (result == FDB_NO_ERR) {
+        /* initialize the header data */
         memset(&sec_hdr, FDB_BYTE_ERASED, sizeof(struct sector_hdr_data));
 #if (FDB_WRITE_GRAN == 1)
         _fdb_set_status(sec_hdr.status_table.store, FDB_SECTOR_STORE_STATUS_NUM, FDB_SECTOR_STORE_EMPTY);
@@ -811,14 +1816,33 @@ static fdb_err_t format_sector(fdb_kvdb_t db, uint32_t addr, uint32_t combined_v
                                   true);
 #endif
 
+    }
 #ifdef FDB_KV_USING_CACHE
-        {
-            struct kvdb_sec_info sector = {.addr = addr, .check_ok = false, .empty_kv = FAILED_ADDR };
-            /* delete the sector cache */
-            update_sector_cache(db, &sector);
+    {
+        struct kvdb_sec_info sector = {.addr = addr, .check_ok = false, .empty_kv = FAILED_ADDR };
+        if (result == FDB_NO_ERR) {
+            /* the header of the formatted sector is known, so it's cached without reading the flash */
+            sector.check_ok = true;
+            sector.status.store = FDB_SECTOR_STORE_EMPTY;
+            sector.status.dirty = FDB_SECTOR_DIRTY_FALSE;
+            sector.magic = SECTOR_MAGIC_WORD;
+            sector.combined = combined_value;
+            sector.empty_kv = addr + SECTOR_HDR_DATA_SIZE;
+            sector.remain = db_sec_size(db) - SECTOR_HDR_DATA_SIZE;
         }
+        /* update or delete the sector cache */
+        update_sector_cache(db, &sector);
+    }
 #endif /* FDB_KV_USING_CACHE */
+#ifdef FDB_KV_USING_FREE_MAP
+    if (result == FDB_NO_ERR) {
+        update_free_map(db, addr, FDB_SECTOR_STORE_EMPTY, addr + SECTOR_HDR_DATA_SIZE);
+        update_free_map_dirty(db, addr, FDB_SECTOR_DIRTY_FALSE);
+    } else {
+        /* the sector will NOT be allocated */
+        update_free_map(db, addr, FDB_SECTOR_STORE_UNUSED, FAILED_ADDR);
     }
+#endif /* FDB_KV_USING_FREE_MAP */
 
     return result;
 }
@@ -835,6 +1859,12 @@ static fdb_err_t update_sec_status(fdb_kvdb_t db, kv_sec_info_t sector, size_t n
 #ifdef FDB_KV_USING_CACHE
         update_sector_status_store_cache(db, sector->addr, FDB_SECTOR_STORE_USING);
 #endif /* FDB_KV_USING_CACHE */
+#ifdef FDB_KV_USING_FREE_MAP
+        update_free_map(db, sector->addr, FDB_SECTOR_STORE_USING, sector->empty_kv + new_kv_len);
+#endif
+#ifdef FDB_KV_USING_GC_COST_BENEFIT
+        sec_stat_use_sector(db, sector->addr);
+#endif
 
     } else if (sector->status.store == FDB_SECTOR_STORE_USING) {
         /* check remain size */
@@ -845,12 +1875,20 @@ static fdb_err_t update_sec_status(fdb_kvdb_t db, kv_sec_info_t sector, size_t n
 #ifdef FDB_KV_USING_CACHE
             update_sector_status_store_cache(db, sector->addr, FDB_SECTOR_STORE_FULL);
 #endif /* FDB_KV_USING_CACHE */
+#ifdef FDB_KV_USING_FREE_MAP
+            update_free_map(db, sector->addr, FDB_SECTOR_STORE_FULL, sector->empty_kv + new_kv_len);
+#endif
 
             if (is_full) {
                 *is_full = true;
             }
-        } else if (is_full) {
-            *is_full = false;
+        } else {
+#ifdef FDB_KV_USING_FREE_MAP
+            update_free_map(db, sector->addr, FDB_SECTOR_STORE_USING, sector->empty_kv + new_kv_len);
+#endif
+            if (is_full) {
+                *is_full = false;
+            }
         }
     }
 
@@ -909,12 +1947,96 @@ static bool alloc_kv_cb(kv_sec_info_t sector, void *arg1, void *arg2)
     return false;
 }
 
+#ifdef FDB_KV_USING_FREE_MAP
+/*
+ * Alloc the KV in the sectors which has the store status by the free-space map, it's same as alloc_kv_cb.
+ */
+static uint32_t alloc_kv_by_free_map(fdb_kvdb_t db, kv_sec_info_t sector, size_t kv_size,
+        fdb_sector_store_status_t store)
+{
+    size_t i, sec_num = SECTOR_NUM, oldest = db_oldest_addr(db) / db_sec_size(db);
+    uint32_t sec_addr, remain;
+    kv_free_node_t node;
+
+    for (i = 0; i < sec_num; i++) {
+        node = &db->free_map[(oldest + i) % sec_num];
+        sec_addr = (uint32_t)((oldest + i) % sec_num) * db_sec_size(db);
+        if (node->store != store || (node->dirty != FDB_SECTOR_DIRTY_FALSE
+                && (node->dirty != FDB_SECTOR_DIRTY_TRUE || db->gc_request))) {
+            continue;
+        }
+        if (node->empty_kv == FAILED_ADDR) {
+            /* the empty KV address is unknown after boot, get it by the KV traversal once */
+            read_sector_info(db, sec_addr, sector, true);
+            node->empty_kv = sec_addr + db_sec_size(db) - sector->remain;
+        }
+        remain = db_sec_size(db) - (node->empty_kv - sec_addr);
+        if (remain > kv_size + FDB_SEC_REMAIN_THRESHOLD) {
+            sector->addr = sec_addr;
+            sector->check_ok = true;
+            sector->magic = SECTOR_MAGIC_WORD;
+            sector->combined = SECTOR_NOT_COMBINED;
+            sector->status.store = (fdb_sector_store_status_t) node->store;
+            sector->status.dirty = (fdb_sector_dirty_status_t) node->dirty;
+            sector->remain = remain;
+            sector->empty_kv = node->empty_kv;
+            return node->empty_kv;
+        }
+    }
+
+    return FAILED_ADDR;
+}
+
+/*
+ * Build the free-space map after the KV recovery check. The empty KV address of the using sector is got when alloc.
+ */
+static void build_free_map(fdb_kvdb_t db)
+{
+    struct kvdb_sec_info sector;
+    uint32_t sec_addr;
+
+    db->free_map_ok = SECTOR_NUM <= FDB_KV_FREE_MAP_SEC_NUM;
+    for (sec_addr = 0; db->free_map_ok && sec_addr < db_max_size(db); sec_addr += db_sec_size(db)) {
+        read_sector_info(db, sec_addr, &sector, false);
+        update_free_map_dirty(db, sec_addr, sector.check_ok ? sector.status.dirty : FDB_SECTOR_DIRTY_UNUSED);
+        if (sector.check_ok && sector.status.store == FDB_SECTOR_STORE_EMPTY) {
+            update_free_map(db, sec_addr, FDB_SECTOR_STORE_EMPTY, sec_addr + SECTOR_HDR_DATA_SIZE);
+        } else {
+            update_free_map(db, sec_addr, sector.check_ok ? sector.status.store : FDB_SECTOR_STORE_UNUSED, FAILED_ADDR);
+        }
+    }
+}
+#endif /* FDB_KV_USING_FREE_MAP */
+
 static uint32_t alloc_kv(fdb_kvdb_t db, kv_sec_info_t sector, size_t kv_size)
 {
     uint32_t empty_kv = FAILED_ADDR;
     size_t empty_sector = 0, using_sector = 0;
     struct alloc_kv_cb_args arg = {db, kv_size, &empty_kv};
 
+#ifdef FDB_KV_USING_FREE_MAP
+    if (db->free_map_ok) {
+        size_t i;
+        /* sector status statistics and alloc the KV by the map, the sector is NOT read from flash */
+        for (i = 0; i < SECTOR_NUM; i++) {
+            if (db->free_map[i].store == FDB_SECTOR_STORE_EMPTY) {
+                empty_sector++;
+            }
+        }
+        empty_kv = alloc_kv_by_free_map(db, sector, kv_size, FDB_SECTOR_STORE_USING);
+        if (empty_sector > 0 && empty_kv == FAILED_ADDR) {
+            if (empty_sector > FDB_GC_EMPTY_SEC_THRESHOLD || db->gc_request) {
+                empty_kv = alloc_kv_by_free_map(db, sector, kv_size, FDB_SECTOR_STORE_EMPTY);
+            } else {
+                /* no space for new KV now will GC and retry */
+                FDB_DEBUG("Trigger a GC check after alloc KV failed.\n");
+                db->gc_request = true;
+            }
+        }
+        return empty_kv;
+    }
+#endif /* FDB_KV_USING_FREE_MAP */
+
     /* sector status statistics */
     sector_iterator(db, sector, FDB_SECTOR_STORE_UNUSED, &empty_sector, &using_sector, sector_statistics_cb, false);
     if (using_sector > 0) {
@@ -975,6 +2097,30 @@ static fdb_err_t del_kv(fdb_kvdb_t db, const char *key, fdb_kv_t old_kv, bool co
             }
 #endif /* FDB_KV_USING_CACHE */
         }
+#ifdef FDB_KV_USING_INDEX
+        if (result == FDB_NO_ERR) {
+            /* the index node is deleted only when it's still pointing to this KV */
+            if (key != NULL) {
+                del_kv_index(db, key, strlen(key), old_kv->addr.start);
+            } else {
+                del_kv_index(db, old_kv->name, old_kv->name_len, old_kv->addr.start);
+            }
+        }
+#endif /* FDB_KV_USING_INDEX */
+#ifdef FDB_KV_USING_ORDERED_INDEX
+        if (result == FDB_NO_ERR) {
+            if (key != NULL) {
+                del_kv_order(db, key, strlen(key), old_kv->addr.start);
+            } else {
+                del_kv_order(db, old_kv->name, old_kv->name_len, old_kv->addr.start);
+            }
+        }
+#endif /* FDB_KV_USING_ORDERED_INDEX */
+#ifdef FDB_KV_USING_GC_COST_BENEFIT
+        if (result == FDB_NO_ERR) {
+            sec_stat_del_kv(db, old_kv->addr.start, old_kv->len);
+        }
+#endif
 
         db->last_is_complete_del = false;
     }
@@ -992,6 +2138,95 @@ static fdb_err_t del_kv(fdb_kvdb_t db, const char *key, fdb_kv_t old_kv, bool co
             }
         }
 #endif /* FDB_KV_USING_CACHE */
+#ifdef FDB_KV_USING_FREE_MAP
+        update_free_map_dirty(db, FDB_ALIGN_DOWN(old_kv->addr.start, db_sec_size(db)), FDB_SECTOR_DIRTY_TRUE);
+#endif
+    }
+
+    return result;
+}
+
+/*
+ * Check the KV is a batch record. The batch record is an empty name KV, the batch data is its value.
+ */
+static bool is_kv_batch(fdb_kvdb_t db, fdb_kv_t kv, struct kv_batch_data *batch)
+{
+    if (!kv->crc_is_ok || kv->name_len != 0 || kv->value_len != sizeof(struct kv_batch_data)) {
+        return false;
+    }
+    _fdb_flash_read((fdb_db_t)db, kv->addr.value, (uint32_t *) batch, sizeof(struct kv_batch_data));
+
+    return batch->magic == KV_BATCH_MAGIC_WORD;
+}
+
+/*
+ * Finish the committed batch. All KVs in batch will change to KV_WRITE and their old KVs will be deleted,
+ * then the batch record is deleted. It's also used to recovery the batch which is interrupted by power down.
+ */
+static fdb_err_t finish_kv_batch(fdb_kvdb_t db, fdb_kv_t batch_kv, struct kv_batch_data *batch)
+{
+    fdb_err_t result = FDB_NO_ERR;
+    uint8_t status_table[KV_STATUS_TABLE_SIZE];
+    struct fdb_kv kv, old_kv;
+    uint32_t end_addr;
+#ifdef FDB_KV_USING_LARGE_BLOB
+    struct kv_large_data large;
+    bool is_large;
+#endif
+
+    kv.addr.start = batch_kv->addr.start + batch_kv->len;
+    end_addr = kv.addr.start + batch->len;
+    for (; result == FDB_NO_ERR && kv.addr.start < end_addr; kv.addr.start += kv.len) {
+        read_kv(db, &kv);
+        if (!kv.crc_is_ok) {
+            FDB_INFO("Error: The KV (@0x%08" PRIX32 ") in batch is broken.\n", kv.addr.start);
+            return FDB_READ_ERR;
+        }
+        if (kv.status != FDB_KV_PRE_WRITE) {
+            /* it's finished before power down */
+            continue;
+        }
+#ifdef FDB_KV_USING_LARGE_BLOB
+        is_large = false;
+#endif
+        /* delete the old KV, the new KV is not found because of its status is KV_PRE_WRITE */
+        if (find_kv(db, kv.name, &old_kv)) {
+#ifdef FDB_KV_USING_LARGE_BLOB
+            is_large = read_large_kv(db, &old_kv, &large);
+#endif
+            result = del_kv(db, NULL, &old_kv, true);
+        }
+        if (result == FDB_NO_ERR) {
+            result = _fdb_write_status((fdb_db_t)db, kv.addr.start, status_table, FDB_KV_STATUS_NUM, FDB_KV_WRITE,
+                    false);
+        }
+        if (result == FDB_NO_ERR) {
+#ifdef FDB_KV_USING_CACHE
+            update_kv_cache(db, kv.name, kv.name_len, kv.addr.start);
+#endif
+#ifdef FDB_KV_USING_INDEX
+            update_kv_index(db, kv.name, kv.name_len, kv.addr.start);
+#endif
+#ifdef FDB_KV_USING_ORDERED_INDEX
+            update_kv_order(db, kv.name, kv.name_len, kv.addr.start);
+#endif
+#ifdef FDB_KV_USING_GC_COST_BENEFIT
+            sec_stat_add_kv(db, kv.addr.start, kv.len, true);
+#endif
+        }
+#ifdef FDB_KV_USING_LARGE_BLOB
+        /* the chunk KVs of the old large KV are deleted after the new KV is committed */
+        if (is_large && result == FDB_NO_ERR) {
+            del_chunk_kvs(db, kv.name, large.gen, KV_LARGE_CHUNK_NUM(&large));
+        }
+#endif
+    }
+    /* all KVs in batch are finished, delete the batch record */
+    if (result == FDB_NO_ERR) {
+        result = del_kv(db, NULL, batch_kv, true);
+    }
+    if (result == FDB_NO_ERR) {
+        batch_kv->status = FDB_KV_DELETED;
     }
 
     return result;
@@ -1031,12 +2266,23 @@ static fdb_err_t move_kv(fdb_kvdb_t db, fdb_kv_t kv)
     {
         uint8_t buf[32];
         size_t len, size, kv_len = kv->len;
+#ifdef FDB_KV_USING_COUNTER
+        bool is_counter = kv_is_counter(kv);
+#endif
 
         /* update the new KV sector status first */
         update_sec_status(db, &sector, kv->len, NULL);
 
         _fdb_write_status((fdb_db_t)db, kv_addr, status_table, FDB_KV_STATUS_NUM, FDB_KV_PRE_WRITE, false);
         kv_len -= KV_MAGIC_OFFSET;
+#ifdef FDB_KV_USING_COUNTER
+        if (is_counter) {
+            /* only the used steps are programmed, the unused steps are kept erased for programming in place */
+            kv_len -= KV_COUNTER_TABLE_SIZE;
+            write_counter_steps(db, kv_addr + kv->len - KV_COUNTER_TABLE_SIZE, 0,
+                    read_counter_steps(db, kv->addr.start + kv->len - KV_COUNTER_TABLE_SIZE));
+        }
+#endif
         for (len = 0, size = 0; len < kv_len; len += size) {
             if (len + sizeof(buf) < kv_len) {
                 size = sizeof(buf);
@@ -1047,12 +2293,21 @@ static fdb_err_t move_kv(fdb_kvdb_t db, fdb_kv_t kv)
             result = _fdb_flash_write((fdb_db_t)db, kv_addr + KV_MAGIC_OFFSET + len, (uint32_t *) buf, size, true);
         }
         _fdb_write_status((fdb_db_t)db, kv_addr, status_table, FDB_KV_STATUS_NUM, FDB_KV_WRITE, true);
+#ifdef FDB_KV_USING_GC_COST_BENEFIT
+        sec_stat_add_kv(db, kv_addr, kv->len, true);
+#endif
 
 #ifdef FDB_KV_USING_CACHE
         update_sector_empty_addr_cache(db, FDB_ALIGN_DOWN(kv_addr, db_sec_size(db)),
                 kv_addr + KV_HDR_DATA_SIZE + FDB_WG_ALIGN(kv->name_len) + FDB_WG_ALIGN(kv->value_len));
         update_kv_cache(db, kv->name, kv->name_len, kv_addr);
 #endif /* FDB_KV_USING_CACHE */
+#ifdef FDB_KV_USING_INDEX
+        update_kv_index(db, kv->name, kv->name_len, kv_addr);
+#endif
+#ifdef FDB_KV_USING_ORDERED_INDEX
+        update_kv_order(db, kv->name, kv->name_len, kv_addr);
+#endif
     }
 
     FDB_DEBUG("Moved the KV (%.*s) from 0x%08" PRIX32 " to 0x%08" PRIX32 ".\n", kv->name_len, kv->name, kv->addr.start, kv_addr);
@@ -1106,9 +2361,95 @@ static bool gc_check_cb(kv_sec_info_t sector, void *arg1, void *arg2)
 
 }
 
+#if defined(FDB_KV_USING_GC_COST_BENEFIT)
+struct gc_victim_args {
+    fdb_kvdb_t db;
+    uint32_t addr;
+    uint64_t score;
+    uint32_t ring_age;
+};
+
+/*
+ * the cost-benefit of collecting the sector is (1 - u) / (1 + u) * age as in the log-structured file system,
+ * u is the live size ratio, the age is the write sequence distance from the newest sector
+ */
+static bool gc_victim_cb(kv_sec_info_t sector, void *arg1, void *arg2)
+{
+    struct gc_victim_args *arg = arg1;
+    uint32_t live, garbage;
+    uint64_t score;
+
+    arg->ring_age--;
+    if (sector->check_ok && (sector->status.dirty == FDB_SECTOR_DIRTY_TRUE || sector->status.dirty == FDB_SECTOR_DIRTY_GC)) {
+        get_sec_stat(arg->db, sector, &live, &garbage);
+        score = ((uint64_t)garbage << 16) / ((uint64_t)garbage + 2 * (uint64_t)live + 1)
+                * get_sec_age(arg->db, sector->addr, arg->ring_age);
+        if (arg->addr == FAILED_ADDR || score > arg->score) {
+            arg->addr = sector->addr;
+            arg->score = score;
+        }
+    }
+
+    return false;
+}
+
+/*
+ * select the dirty sector which has the maximum cost-benefit for GC
+ */
+static uint32_t gc_select_victim(fdb_kvdb_t db)
+{
+    struct kvdb_sec_info sector;
+    struct gc_victim_args arg = { db, FAILED_ADDR, 0, (uint32_t)SECTOR_NUM + 1 };
+
+    sector_iterator(db, &sector, FDB_SECTOR_STORE_UNUSED, &arg, NULL, gc_victim_cb, false);
+
+    return arg.addr;
+}
+#elif defined(FDB_KV_USING_INCREMENTAL_GC)
+static bool gc_victim_cb(kv_sec_info_t sector, void *arg1, void *arg2)
+{
+    uint32_t *gc_sec_addr = arg1;
+
+    if (sector->check_ok && (sector->status.dirty == FDB_SECTOR_DIRTY_TRUE || sector->status.dirty == FDB_SECTOR_DIRTY_GC)) {
+        *gc_sec_addr = sector->addr;
+        return true;
+    }
+
+    return false;
+}
+
+/*
+ * select the oldest dirty sector for GC
+ */
+static uint32_t gc_select_victim(fdb_kvdb_t db)
+{
+    struct kvdb_sec_info sector;
+    uint32_t gc_sec_addr = FAILED_ADDR;
+
+    sector_iterator(db, &sector, FDB_SECTOR_STORE_UNUSED, &gc_sec_addr, NULL, gc_victim_cb, false);
+
+    return gc_sec_addr;
+}
+#endif /* defined(FDB_KV_USING_GC_COST_BENEFIT) */
+
+/*
+ * the next sector is the oldest one after the oldest sector is collected
+ */
+static void gc_update_oldest_addr(fdb_kvdb_t db, kv_sec_info_t sector)
+{
+#ifdef FDB_KV_USING_GC_COST_BENEFIT
+    /* the victim is NOT collected in the FIFO order, the collected sector in the middle is an empty hole */
+    if (sector->addr != db_oldest_addr(db)) {
+        return;
+    }
+#endif
+    db_oldest_addr(db) = get_next_sector_addr(db, sector, 0);
+}
+
 static bool do_gc(kv_sec_info_t sector, void *arg1, void *arg2)
 {
     struct fdb_kv kv;
+    struct kv_batch_data batch;
     struct gc_cb_args *gc = (struct gc_cb_args *)arg1;
     fdb_kvdb_t db = gc->db;
     uint32_t last_gc_sec_addr = 0;
@@ -1117,11 +2458,25 @@ static bool do_gc(kv_sec_info_t sector, void *arg1, void *arg2)
         uint8_t status_table[FDB_DIRTY_STATUS_TABLE_SIZE];
         /* change the sector status to GC */
         _fdb_write_status((fdb_db_t)db, sector->addr + SECTOR_DIRTY_OFFSET, status_table, FDB_SECTOR_DIRTY_STATUS_NUM, FDB_SECTOR_DIRTY_GC, true);
+#ifdef FDB_KV_USING_CACHE
+        {
+            kv_sec_info_t sector_cache = get_sector_from_cache(db, sector->addr);
+            if (sector_cache) {
+                sector_cache->status.dirty = FDB_SECTOR_DIRTY_GC;
+            }
+        }
+#endif /* FDB_KV_USING_CACHE */
+#ifdef FDB_KV_USING_FREE_MAP
+        update_free_map_dirty(db, sector->addr, FDB_SECTOR_DIRTY_GC);
+#endif
         /* search all KV */
         kv.addr.start = sector->addr + SECTOR_HDR_DATA_SIZE;
         do {
             read_kv(db, &kv);
-            if (kv.crc_is_ok && (kv.status == FDB_KV_WRITE || kv.status == FDB_KV_PRE_DELETE)) {
+            if (kv.crc_is_ok && kv.status == FDB_KV_WRITE && is_kv_batch(db, &kv, &batch)) {
+                /* the batch record is never moved, finish the committed batch before collect it */
+                finish_kv_batch(db, &kv, &batch);
+            } else if (kv.crc_is_ok && (kv.status == FDB_KV_WRITE || kv.status == FDB_KV_PRE_DELETE)) {
                 /* move the KV to new space */
                 if (move_kv(db, &kv) != FDB_NO_ERR) {
                     FDB_INFO("Error: Moved the KV (%.*s) for GC failed.\n", kv.name_len, kv.name);
@@ -1131,10 +2486,16 @@ static bool do_gc(kv_sec_info_t sector, void *arg1, void *arg2)
             }
         } while ((kv.addr.start = get_next_kv_addr(db, sector, &kv)) != FAILED_ADDR);
         format_sector(db, sector->addr, SECTOR_NOT_COMBINED);
+#ifdef FDB_KV_USING_INCREMENTAL_GC
+        if (sector->addr == db->gc_sec_addr) {
+            /* the incremental GC sector is collected */
+            db->gc_sec_addr = FAILED_ADDR;
+        }
+#endif
         last_gc_sec_addr = gc->last_gc_sec_addr;
         gc->last_gc_sec_addr = sector->addr;
         /* update oldest_addr for next GC sector format */
-        db_oldest_addr(db) = get_next_sector_addr(db, sector, 0);
+        gc_update_oldest_addr(db, sector);
         FDB_DEBUG("Collect a sector @0x%08" PRIX32 "\n", sector->addr);
         /* the collect new space is in last GC sector */
         struct kvdb_sec_info last_gc_sector;
@@ -1161,7 +2522,15 @@ static void gc_collect_by_free_size(fdb_kvdb_t db, size_t free_size)
     FDB_DEBUG("The remain empty sector is %" PRIu32 ", GC threshold is %" PRIdLEAST16 ".\n", (uint32_t)empty_sec_num, FDB_GC_EMPTY_SEC_THRESHOLD);
     if (empty_sec_num <= FDB_GC_EMPTY_SEC_THRESHOLD) {
         struct gc_cb_args arg = { db, free_size, empty_sec_addr };
+#ifdef FDB_KV_USING_GC_COST_BENEFIT
+        uint32_t gc_sec_addr;
+        /* collect the sector which has the maximum cost-benefit first */
+        while ((gc_sec_addr = gc_select_victim(db)) != FAILED_ADDR
+                && read_sector_info(db, gc_sec_addr, &sector, false) == FDB_NO_ERR && !do_gc(&sector, &arg, NULL));
+#else
         sector_iterator(db, &sector, FDB_SECTOR_STORE_UNUSED, &arg, NULL, do_gc, false);
+#endif
+
     }
 
     db->gc_request = false;
@@ -1177,6 +2546,108 @@ static void gc_collect(fdb_kvdb_t db)
     gc_collect_by_free_size(db, db_max_size(db));
 }
 
+#ifdef FDB_KV_USING_INCREMENTAL_GC
+/*
+ * select a dirty sector for incremental GC when the remain empty sectors are not enough
+ */
+static bool gc_select_sector(fdb_kvdb_t db)
+{
+    struct kvdb_sec_info sector;
+    size_t empty_sec_num = 0;
+    uint32_t empty_sec_addr = 0, gc_sec_addr = FAILED_ADDR;
+    uint8_t status_table[FDB_DIRTY_STATUS_TABLE_SIZE];
+
+    sector_iterator(db, &sector, FDB_SECTOR_STORE_EMPTY, &empty_sec_num, &empty_sec_addr, gc_check_cb, false);
+    if (empty_sec_num > FDB_GC_STEP_SEC_THRESHOLD) {
+        return false;
+    }
+    if ((gc_sec_addr = gc_select_victim(db)) == FAILED_ADDR) {
+        return false;
+    }
+    /* change the sector status to GC, so the new KV will NOT be allocated in it */
+    _fdb_write_status((fdb_db_t)db, gc_sec_addr + SECTOR_DIRTY_OFFSET, status_table, FDB_SECTOR_DIRTY_STATUS_NUM, FDB_SECTOR_DIRTY_GC, true);
+#ifdef FDB_KV_USING_CACHE
+    {
+        kv_sec_info_t sector_cache = get_sector_from_cache(db, gc_sec_addr);
+        if (sector_cache) {
+            sector_cache->status.dirty = FDB_SECTOR_DIRTY_GC;
+        }
+    }
+#endif /* FDB_KV_USING_CACHE */
+#ifdef FDB_KV_USING_FREE_MAP
+    update_free_map_dirty(db, gc_sec_addr, FDB_SECTOR_DIRTY_GC);
+#endif
+    db->gc_sec_addr = gc_sec_addr;
+    db->gc_kv_addr = gc_sec_addr + SECTOR_HDR_DATA_SIZE;
+    FDB_DEBUG("Incremental GC selected a sector @0x%08" PRIX32 "\n", gc_sec_addr);
+
+    return true;
+}
+
+/*
+ * collect the garbage incrementally, the step returns after the moved KV size is over the budget
+ *
+ * @return true: the GC is NOT finished and it can be continued
+ */
+static bool gc_collect_step(fdb_kvdb_t db, size_t budget)
+{
+    struct kvdb_sec_info sector;
+    struct fdb_kv kv;
+    struct kv_batch_data batch;
+    size_t moved = 0;
+    fdb_err_t result = FDB_NO_ERR;
+    bool finished = false;
+
+    while (moved < budget) {
+        if (db->gc_sec_addr == FAILED_ADDR && !gc_select_sector(db)) {
+            finished = true;
+            break;
+        }
+        if (read_sector_info(db, db->gc_sec_addr, &sector, false) != FDB_NO_ERR) {
+            db->gc_sec_addr = FAILED_ADDR;
+            break;
+        }
+        if (db->gc_kv_addr == FAILED_ADDR) {
+            /* all KV is moved, collect the sector */
+            format_sector(db, sector.addr, SECTOR_NOT_COMBINED);
+            gc_update_oldest_addr(db, &sector);
+            db->gc_sec_addr = FAILED_ADDR;
+            FDB_DEBUG("Incremental GC collected a sector @0x%08" PRIX32 "\n", sector.addr);
+            continue;
+        }
+        kv.addr.start = db->gc_kv_addr;
+        read_kv(db, &kv);
+        if (kv.crc_is_ok && kv.status == FDB_KV_WRITE && is_kv_batch(db, &kv, &batch)) {
+            /* the batch record is never moved, finish the committed batch before collect it */
+            finish_kv_batch(db, &kv, &batch);
+        } else if (kv.crc_is_ok && (kv.status == FDB_KV_WRITE || kv.status == FDB_KV_PRE_DELETE)) {
+            result = move_kv(db, &kv);
+            if (result != FDB_NO_ERR && db->gc_request) {
+                /* move it to the reserved empty sector */
+                result = move_kv(db, &kv);
+            }
+            if (result != FDB_NO_ERR) {
+                /* no space now, it will be retried on next step or collected when set KV */
+                FDB_INFO("Error: Moved the KV (%.*s) for GC failed.\n", kv.name_len, kv.name);
+                break;
+            }
+            moved += kv.len;
+        }
+        db->gc_kv_addr = get_next_kv_addr(db, &sector, &kv);
+    }
+    /* keep the GC request until no sector needs to be collected */
+    if (finished) {
+        db->gc_request = false;
+    }
+    /* select the next sector when the GC is still required */
+    if (db->gc_sec_addr == FAILED_ADDR) {
+        gc_select_sector(db);
+    }
+
+    return result == FDB_NO_ERR && db->gc_sec_addr != FAILED_ADDR;
+}
+#endif /* FDB_KV_USING_INCREMENTAL_GC */
+
 static fdb_err_t align_write(fdb_kvdb_t db, uint32_t addr, const uint32_t *buf, size_t size)
 {
     fdb_err_t result = FDB_NO_ERR;
@@ -1206,7 +2677,57 @@ static fdb_err_t align_write(fdb_kvdb_t db, uint32_t addr, const uint32_t *buf,
     return result;
 }
 
-static fdb_err_t create_kv_blob(fdb_kvdb_t db, kv_sec_info_t sector, const char *key, const void *value, size_t len)
+/*
+ * Write the KV header, name and value, the KV status is KV_PRE_WRITE after written.
+ */
+static fdb_err_t write_kv(fdb_kvdb_t db, uint32_t kv_addr, kv_hdr_data_t kv_hdr, const char *key, const void *value)
+{
+    fdb_err_t result = FDB_NO_ERR;
+    size_t align_remain, value_len = kv_hdr->value_len;
+
+#ifdef FDB_KV_USING_COUNTER
+    if (kv_attr_is_set(kv_hdr->attr, KV_ATTR_COUNTER)) {
+        /* the counter step table is erased, it's programmed in place and NOT in the CRC32 */
+        value_len -= KV_COUNTER_TABLE_SIZE;
+    }
+#endif
+
+    /* start calculate CRC32 */
+    kv_hdr->crc32 = 0;
+    /* CRC32(header.name_len + header.value_len + name + value), using sizeof(uint32_t) for compatible V1.x */
+    kv_hdr->crc32 = fdb_calc_crc32(kv_hdr->crc32, &kv_hdr->name_len, sizeof(uint32_t));
+    kv_hdr->crc32 = fdb_calc_crc32(kv_hdr->crc32, &kv_hdr->value_len, sizeof(uint32_t));
+    kv_hdr->crc32 = fdb_calc_crc32(kv_hdr->crc32, key, kv_hdr->name_len);
+    align_remain = FDB_WG_ALIGN(kv_hdr->name_len) - kv_hdr->name_len;
+    kv_hdr->crc32 = _fdb_calc_crc32_fill(kv_hdr->crc32, FDB_BYTE_ERASED, align_remain);
+    kv_hdr->crc32 = fdb_calc_crc32(kv_hdr->crc32, value, value_len);
+    align_remain = FDB_WG_ALIGN(value_len) - value_len;
+    kv_hdr->crc32 = _fdb_calc_crc32_fill(kv_hdr->crc32, FDB_BYTE_ERASED, align_remain);
+    /* write KV header data */
+    result = write_kv_hdr(db, kv_addr, kv_hdr);
+    /* write key name */
+    if (result == FDB_NO_ERR) {
+        result = align_write(db, kv_addr + KV_HDR_DATA_SIZE, (uint32_t *) key, kv_hdr->name_len);
+    }
+    /* write value */
+    if (result == FDB_NO_ERR) {
+        result = align_write(db, kv_addr + KV_HDR_DATA_SIZE + FDB_WG_ALIGN(kv_hdr->name_len), value, value_len);
+    }
+
+    return result;
+}
+
+static void init_kv_hdr(kv_hdr_data_t kv_hdr, size_t name_len, size_t value_len)
+{
+    memset(kv_hdr, FDB_BYTE_ERASED, sizeof(struct kv_hdr_data));
+    kv_hdr->magic = KV_MAGIC_WORD;
+    kv_hdr->name_len = name_len;
+    kv_hdr->value_len = value_len;
+    kv_hdr->len = KV_HDR_DATA_SIZE + FDB_WG_ALIGN(kv_hdr->name_len) + FDB_WG_ALIGN(kv_hdr->value_len);
+}
+
+static fdb_err_t create_kv_blob(fdb_kvdb_t db, kv_sec_info_t sector, const char *key, const void *value, size_t len,
+        uint8_t attr)
 {
     fdb_err_t result = FDB_NO_ERR;
     struct kv_hdr_data kv_hdr;
@@ -1218,11 +2739,8 @@ static fdb_err_t create_kv_blob(fdb_kvdb_t db, kv_sec_info_t sector, const char
         return FDB_KV_NAME_ERR;
     }
 
-    memset(&kv_hdr, FDB_BYTE_ERASED, sizeof(struct kv_hdr_data));
-    kv_hdr.magic = KV_MAGIC_WORD;
-    kv_hdr.name_len = strlen(key);
-    kv_hdr.value_len = len;
-    kv_hdr.len = KV_HDR_DATA_SIZE + FDB_WG_ALIGN(kv_hdr.name_len) + FDB_WG_ALIGN(kv_hdr.value_len);
+    init_kv_hdr(&kv_hdr, strlen(key), len);
+    kv_hdr.attr = attr;
 
     if (kv_hdr.len > db_sec_size(db) - SECTOR_HDR_DATA_SIZE) {
         FDB_INFO("Error: The KV size is too big\n");
@@ -1230,53 +2748,41 @@ static fdb_err_t create_kv_blob(fdb_kvdb_t db, kv_sec_info_t sector, const char
     }
 
     if (kv_addr != FAILED_ADDR || (kv_addr = new_kv(db, sector, kv_hdr.len)) != FAILED_ADDR) {
-        size_t align_remain;
         /* update the sector status */
         if (result == FDB_NO_ERR) {
             result = update_sec_status(db, sector, kv_hdr.len, &is_full);
         }
+        /* write the KV header, name and value */
         if (result == FDB_NO_ERR) {
-            uint8_t ff = FDB_BYTE_ERASED;
-            /* start calculate CRC32 */
-            kv_hdr.crc32 = 0;
-            /* CRC32(header.name_len + header.value_len + name + value), using sizeof(uint32_t) for compatible V1.x */
-            kv_hdr.crc32 = fdb_calc_crc32(kv_hdr.crc32, &kv_hdr.name_len, sizeof(uint32_t));
-            kv_hdr.crc32 = fdb_calc_crc32(kv_hdr.crc32, &kv_hdr.value_len, sizeof(uint32_t));
-            kv_hdr.crc32 = fdb_calc_crc32(kv_hdr.crc32, key, kv_hdr.name_len);
-            align_remain = FDB_WG_ALIGN(kv_hdr.name_len) - kv_hdr.name_len;
-            while (align_remain--) {
-                kv_hdr.crc32 = fdb_calc_crc32(kv_hdr.crc32, &ff, 1);
-            }
-            kv_hdr.crc32 = fdb_calc_crc32(kv_hdr.crc32, value, kv_hdr.value_len);
-            align_remain = FDB_WG_ALIGN(kv_hdr.value_len) - kv_hdr.value_len;
-            while (align_remain--) {
-                kv_hdr.crc32 = fdb_calc_crc32(kv_hdr.crc32, &ff, 1);
-            }
-            /* write KV header data */
-            result = write_kv_hdr(db, kv_addr, &kv_hdr);
+            result = write_kv(db, kv_addr, &kv_hdr, key, value);
         }
-        /* write key name */
-        if (result == FDB_NO_ERR) {
-            result = align_write(db, kv_addr + KV_HDR_DATA_SIZE, (uint32_t *) key, kv_hdr.name_len);
-
 #ifdef FDB_KV_USING_CACHE
+        if (result == FDB_NO_ERR) {
             if (!is_full) {
-                update_sector_empty_addr_cache(db, sector->addr,
-                        kv_addr + KV_HDR_DATA_SIZE + FDB_WG_ALIGN(kv_hdr.name_len) + FDB_WG_ALIGN(kv_hdr.value_len));
+                update_sector_empty_addr_cache(db, sector->addr, kv_addr + kv_hdr.len);
             }
             update_kv_cache(db, key, kv_hdr.name_len, kv_addr);
-#endif /* FDB_KV_USING_CACHE */
-        }
-        /* write value */
-        if (result == FDB_NO_ERR) {
-            result = align_write(db, kv_addr + KV_HDR_DATA_SIZE + FDB_WG_ALIGN(kv_hdr.name_len), value,
-                    kv_hdr.value_len);
         }
+#endif /* FDB_KV_USING_CACHE */
         /* change the KV status to KV_WRITE */
         if (result == FDB_NO_ERR) {
             result = _fdb_write_status((fdb_db_t) db, kv_addr, kv_hdr.status_table, FDB_KV_STATUS_NUM, FDB_KV_WRITE,
                     true);
         }
+#ifdef FDB_KV_USING_INDEX
+        if (result == FDB_NO_ERR) {
+            update_kv_index(db, key, kv_hdr.name_len, kv_addr);
+        }
+#endif
+#ifdef FDB_KV_USING_ORDERED_INDEX
+        if (result == FDB_NO_ERR) {
+            update_kv_order(db, key, kv_hdr.name_len, kv_addr);
+        }
+#endif
+#ifdef FDB_KV_USING_GC_COST_BENEFIT
+        /* the failed KV is garbage */
+        sec_stat_add_kv(db, kv_addr, kv_hdr.len, result == FDB_NO_ERR);
+#endif
         /* trigger GC collect when current sector is full */
         if (result == FDB_NO_ERR && is_full) {
             FDB_DEBUG("Trigger a GC check after created KV.\n");
@@ -1289,17 +2795,63 @@ static fdb_err_t create_kv_blob(fdb_kvdb_t db, kv_sec_info_t sector, const char
     return result;
 }
 
-/**
- * Delete an KV.
- *
- * @param db database object
- * @param key KV name
- *
- * @return result
+#ifdef FDB_KV_USING_LARGE_BLOB
+/*
+ * Delete the chunk KVs of the large KV in reverse order, so the remaining chunk KVs always start from index 0 when
+ * power down. The chunk number is counted on flash when it's UINT32_MAX, it's for the chunk KVs without the large KV.
  */
-fdb_err_t fdb_kv_del(fdb_kvdb_t db, const char *key)
+static void del_chunk_kvs(fdb_kvdb_t db, const char *key, uint32_t gen, uint32_t num)
 {
-    fdb_err_t result = FDB_NO_ERR;
+    char name[FDB_KV_NAME_MAX + 1];
+    struct fdb_kv kv;
+
+    if (num == UINT32_MAX) {
+        for (num = 0; num < KV_CHUNK_NUM_MAX; num++) {
+            make_chunk_name(name, key, gen, num);
+            if (!find_kv(db, name, &kv)) {
+                break;
+            }
+        }
+    }
+    while (num > 0) {
+        make_chunk_name(name, key, gen, --num);
+        del_kv(db, name, NULL, true);
+    }
+}
+
+/*
+ * Delete the KV by name, the chunk KVs are deleted after the large KV.
+ */
+static fdb_err_t del_large_kv(fdb_kvdb_t db, const char *key)
+{
+    fdb_err_t result;
+    struct fdb_kv kv;
+    struct kv_large_data large;
+
+    if (!find_kv(db, key, &kv)) {
+        FDB_DEBUG("Not found '%s' in KV.\n", key);
+        return FDB_KV_NAME_ERR;
+    }
+    result = del_kv(db, key, &kv, true);
+    if (result == FDB_NO_ERR && read_large_kv(db, &kv, &large)) {
+        del_chunk_kvs(db, key, large.gen, KV_LARGE_CHUNK_NUM(&large));
+    }
+
+    return result;
+}
+#endif /* FDB_KV_USING_LARGE_BLOB */
+
+/**
+ * Delete an KV.
+ *
+ * @param db database object
+ * @param key KV name
+ *
+ * @return result
+ */
+fdb_err_t fdb_kv_del(fdb_kvdb_t db, const char *key)
+{
+    fdb_err_t result = FDB_NO_ERR;
 
     if (!db_init_ok(db)) {
         FDB_INFO("Error: KV (%s) isn't initialize OK.\n", db_name(db));
@@ -1309,7 +2861,14 @@ fdb_err_t fdb_kv_del(fdb_kvdb_t db, const char *key)
     /* lock the KV cache */
     db_lock(db);
 
+#ifdef FDB_KV_USING_LAZY_LOAD
+    finish_lazy_load(db);
+#endif
+#ifdef FDB_KV_USING_LARGE_BLOB
+    result = del_large_kv(db, key);
+#else
     result = del_kv(db, key, NULL, true);
+#endif
 
     /* unlock the KV cache */
     db_unlock(db);
@@ -1317,40 +2876,117 @@ fdb_err_t fdb_kv_del(fdb_kvdb_t db, const char *key)
     return result;
 }
 
-static fdb_err_t set_kv(fdb_kvdb_t db, const char *key, const void *value_buf, size_t buf_len)
+/*
+ * Process the GC after set KV. The gc_step is true when an empty sector is used by the new KV.
+ */
+static void set_kv_gc(fdb_kvdb_t db, bool gc_step, size_t free_size)
+{
+#ifdef FDB_KV_USING_INCREMENTAL_GC
+    if (db_gc_budget(db) > 0) {
+        if (gc_step || db->gc_request || db->gc_sec_addr != FAILED_ADDR) {
+            gc_collect_step(db, db_gc_budget(db));
+        }
+        return;
+    }
+#else
+    (void)gc_step;
+#endif /* FDB_KV_USING_INCREMENTAL_GC */
+    if (db->gc_request) {
+        gc_collect_by_free_size(db, free_size);
+    }
+}
+
+static fdb_err_t set_kv_ex(fdb_kvdb_t db, const char *key, const void *value_buf, size_t buf_len, uint8_t attr)
 {
     fdb_err_t result = FDB_NO_ERR;
-    bool kv_is_found = false;
+    bool kv_is_found = false, gc_step = false;
+#ifdef FDB_KV_USING_LARGE_BLOB
+    struct kv_large_data large;
+    bool is_large = false;
+#endif
+
+#ifdef FDB_KV_USING_LAZY_LOAD
+    finish_lazy_load(db);
+#endif
 
     if (value_buf == NULL) {
+#ifdef FDB_KV_USING_LARGE_BLOB
+        result = del_large_kv(db, key);
+#else
         result = del_kv(db, key, NULL, true);
+#endif
     } else {
         /* make sure the flash has enough space */
         if (new_kv_ex(db, &db->cur_sector, strlen(key), buf_len) == FAILED_ADDR) {
             return FDB_SAVED_FULL;
         }
+        /* the empty sector number is reduced, check the incremental GC */
+        gc_step = db->cur_sector.status.store == FDB_SECTOR_STORE_EMPTY;
         kv_is_found = find_kv(db, key, &db->cur_kv);
+#ifdef FDB_KV_USING_LARGE_BLOB
+        is_large = kv_is_found && read_large_kv(db, &db->cur_kv, &large);
+#endif
         /* prepare to delete the old KV */
         if (kv_is_found) {
             result = del_kv(db, key, &db->cur_kv, false);
         }
         /* create the new KV */
         if (result == FDB_NO_ERR) {
-            result = create_kv_blob(db, &db->cur_sector, key, value_buf, buf_len);
+            result = create_kv_blob(db, &db->cur_sector, key, value_buf, buf_len, attr);
         }
         /* delete the old KV */
         if (kv_is_found && result == FDB_NO_ERR) {
             result = del_kv(db, key, &db->cur_kv, true);
         }
-        /* process the GC after set KV */
-        if (db->gc_request) {
-            gc_collect_by_free_size(db, KV_HDR_DATA_SIZE + FDB_WG_ALIGN(strlen(key)) + FDB_WG_ALIGN(buf_len));
+#ifdef FDB_KV_USING_LARGE_BLOB
+        /* the chunk KVs of the old large KV are deleted after the new KV is saved */
+        if (is_large && result == FDB_NO_ERR) {
+            del_chunk_kvs(db, key, large.gen, KV_LARGE_CHUNK_NUM(&large));
         }
+#endif
+        /* process the GC after set KV */
+        set_kv_gc(db, gc_step, KV_HDR_DATA_SIZE + FDB_WG_ALIGN(strlen(key)) + FDB_WG_ALIGN(buf_len));
     }
 
     return result;
 }
 
+#ifdef FDB_KV_USING_COMPRESS
+/*
+ * Compress the KV value to the compressed value buffer. It returns 0 when the value is NOT compressed,
+ * such as the value is too small or too big, or it's NOT smaller on flash after compressed.
+ */
+static size_t compress_kv_value(fdb_kvdb_t db, const void *value_buf, size_t buf_len)
+{
+    uint32_t raw_len = buf_len;
+    size_t comp_len;
+
+    if (!db->compress || buf_len < FDB_KV_COMPRESS_MIN_SIZE || buf_len > FDB_KV_COMPRESS_BUF_SIZE) {
+        return 0;
+    }
+    comp_len = _fdb_lz_compress(value_buf, buf_len, db->comp_buf + KV_COMP_HDR_SIZE, buf_len - KV_COMP_HDR_SIZE);
+    if (comp_len == 0 || FDB_WG_ALIGN(KV_COMP_HDR_SIZE + comp_len) >= FDB_WG_ALIGN(buf_len)) {
+        return 0;
+    }
+    memcpy(db->comp_buf, &raw_len, KV_COMP_HDR_SIZE);
+
+    return KV_COMP_HDR_SIZE + comp_len;
+}
+#endif /* FDB_KV_USING_COMPRESS */
+
+static fdb_err_t set_kv(fdb_kvdb_t db, const char *key, const void *value_buf, size_t buf_len)
+{
+#ifdef FDB_KV_USING_COMPRESS
+    size_t comp_len;
+
+    if (value_buf && (comp_len = compress_kv_value(db, value_buf, buf_len)) > 0) {
+        return set_kv_ex(db, key, db->comp_buf, comp_len, KV_ATTR_NONE ^ KV_ATTR_COMPRESS);
+    }
+#endif
+
+    return set_kv_ex(db, key, value_buf, buf_len, KV_ATTR_NONE);
+}
+
 /**
  * Set a blob KV. If it blob value is NULL, delete it.
  * If not find it in flash, then create it.
@@ -1402,6 +3038,527 @@ fdb_err_t fdb_kv_set(fdb_kvdb_t db, const char *key, const char *value)
     }
 }
 
+#ifdef FDB_KV_USING_COUNTER
+static fdb_err_t set_counter(fdb_kvdb_t db, const char *key, uint32_t value)
+{
+    uint8_t buf[KV_COUNTER_DATA_SIZE];
+
+    /* the step table is NOT written, all steps are erased */
+    memset(buf, FDB_BYTE_ERASED, sizeof(buf));
+    memcpy(buf, &value, sizeof(uint32_t));
+
+    return set_kv_ex(db, key, buf, KV_COUNTER_VALUE_SIZE, KV_ATTR_NONE ^ KV_ATTR_COUNTER);
+}
+
+/**
+ * Set a counter KV. The old KV is replaced, and the counter is increased from the value by fdb_kv_counter_inc.
+ *
+ * @param db database object
+ * @param key KV name
+ * @param value counter value
+ *
+ * @return result
+ */
+fdb_err_t fdb_kv_counter_set(fdb_kvdb_t db, const char *key, uint32_t value)
+{
+    fdb_err_t result = FDB_NO_ERR;
+
+    if (!db_init_ok(db)) {
+        FDB_INFO("Error: KV (%s) isn't initialize OK.\n", db_name(db));
+        return FDB_INIT_FAILED;
+    }
+
+    /* lock the KV cache */
+    db_lock(db);
+
+    result = set_counter(db, key, value);
+
+    /* unlock the KV cache */
+    db_unlock(db);
+
+    return result;
+}
+
+/**
+ * Get the value of a counter KV.
+ *
+ * @param db database object
+ * @param key KV name
+ * @param value counter value
+ *
+ * @return result, FDB_KV_NAME_ERR: the KV is NOT found or it's NOT a counter KV
+ */
+fdb_err_t fdb_kv_counter_get(fdb_kvdb_t db, const char *key, uint32_t *value)
+{
+    fdb_err_t result = FDB_NO_ERR;
+    struct fdb_kv kv;
+
+    if (!db_init_ok(db)) {
+        FDB_INFO("Error: KV (%s) isn't initialize OK.\n", db_name(db));
+        return FDB_INIT_FAILED;
+    }
+
+    /* lock the KV cache */
+    db_rdlock(db);
+
+    if (find_kv(db, key, &kv) && kv_is_counter(&kv)) {
+        *value = read_counter(db, &kv, NULL);
+    } else {
+        result = FDB_KV_NAME_ERR;
+    }
+
+    /* unlock the KV cache */
+    db_rdunlock(db);
+
+    return result;
+}
+
+/**
+ * Increase a counter KV by 1. The counter is increased in place by programming a step, it costs one write granularity
+ * unit, and it's rewritten only when all steps are used. The counter is created by 1 when it's NOT found.
+ *
+ * @param db database object
+ * @param key KV name
+ * @param value the counter value after increased, it can be NULL
+ *
+ * @return result, FDB_KV_NAME_ERR: the KV is NOT a counter KV
+ */
+fdb_err_t fdb_kv_counter_inc(fdb_kvdb_t db, const char *key, uint32_t *value)
+{
+    fdb_err_t result = FDB_NO_ERR;
+    struct fdb_kv kv;
+    uint32_t counter = 0;
+    size_t steps = FDB_KV_COUNTER_STEPS;
+
+    if (!db_init_ok(db)) {
+        FDB_INFO("Error: KV (%s) isn't initialize OK.\n", db_name(db));
+        return FDB_INIT_FAILED;
+    }
+
+    /* lock the KV cache */
+    db_lock(db);
+
+#ifdef FDB_KV_USING_LAZY_LOAD
+    finish_lazy_load(db);
+#endif
+
+    if (find_kv(db, key, &kv)) {
+        if (kv_is_counter(&kv)) {
+            counter = read_counter(db, &kv, &steps);
+        } else {
+            result = FDB_KV_NAME_ERR;
+        }
+    }
+    if (result == FDB_NO_ERR) {
+        if (steps < FDB_KV_COUNTER_STEPS) {
+            result = write_counter_steps(db, kv.addr.value + KV_COUNTER_DATA_SIZE, steps, steps + 1);
+        } else {
+            /* all steps are used, or it's a new counter */
+            result = set_counter(db, key, counter + 1);
+        }
+    }
+    if (result == FDB_NO_ERR && value) {
+        *value = counter + 1;
+    }
+
+    /* unlock the KV cache */
+    db_unlock(db);
+
+    return result;
+}
+#endif /* FDB_KV_USING_COUNTER */
+
+#ifdef FDB_KV_USING_LARGE_BLOB
+/*
+ * Save the buffered value of the large blob writer to the next chunk KV.
+ */
+static fdb_err_t save_chunk_kv(fdb_kvdb_t db, fdb_kv_blob_writer_t writer)
+{
+    fdb_err_t result;
+    char name[FDB_KV_NAME_MAX + 1];
+
+    if (writer->chunk_num >= KV_CHUNK_NUM_MAX) {
+        FDB_INFO("Error: The large KV (%s) size is too big\n", writer->key);
+        return FDB_SAVED_FULL;
+    }
+
+    make_chunk_name(name, writer->key, writer->gen, writer->chunk_num);
+    result = set_kv_ex(db, name, writer->buf, writer->buf_len, KV_ATTR_NONE ^ KV_ATTR_CHUNK);
+    if (result == FDB_NO_ERR) {
+        writer->chunk_num++;
+        writer->buf_len = 0;
+    }
+
+    return result;
+}
+
+/**
+ * Begin to set a large blob KV, the value size can be bigger than a sector. The value is written by
+ * fdb_kv_set_blob_write in several times, and it's saved to the chunk KVs one by one. The old value is replaced
+ * when fdb_kv_set_blob_end is successful, it's kept when power down or any error occurred before that.
+ *
+ * @param db database object
+ * @param key KV name, its length MUST be less than FDB_KV_NAME_MAX by 6 characters for the chunk KV name
+ * @param writer large blob writer object
+ *
+ * @return result
+ */
+fdb_err_t fdb_kv_set_blob_begin(fdb_kvdb_t db, const char *key, fdb_kv_blob_writer_t writer)
+{
+    struct fdb_kv kv;
+    struct kv_large_data large;
+    size_t name_len = strlen(key), max_size;
+
+    if (!db_init_ok(db)) {
+        FDB_INFO("Error: KV (%s) isn't initialize OK.\n", db_name(db));
+        return FDB_INIT_FAILED;
+    }
+
+    if (name_len + KV_CHUNK_NAME_SUFFIX_LEN > FDB_KV_NAME_MAX) {
+        FDB_INFO("Error: The large KV name length is more than %d\n", FDB_KV_NAME_MAX - KV_CHUNK_NAME_SUFFIX_LEN);
+        return FDB_KV_NAME_ERR;
+    }
+
+    strcpy(writer->key, key);
+    writer->result = FDB_NO_ERR;
+    writer->len = 0;
+    writer->crc32 = 0;
+    writer->chunk_num = 0;
+    writer->buf_len = 0;
+    /* the chunk KV MUST be saved in a sector */
+    max_size = FDB_WG_ALIGN_DOWN(db_sec_size(db) - SECTOR_HDR_DATA_SIZE - KV_HDR_DATA_SIZE
+            - FDB_WG_ALIGN(name_len + KV_CHUNK_NAME_SUFFIX_LEN));
+    writer->chunk_size = max_size < FDB_KV_BLOB_CHUNK_SIZE ? max_size : FDB_KV_BLOB_CHUNK_SIZE;
+
+    /* lock the KV cache */
+    db_lock(db);
+
+#ifdef FDB_KV_USING_LAZY_LOAD
+    finish_lazy_load(db);
+#endif
+
+    if (find_kv(db, key, &kv) && read_large_kv(db, &kv, &large)) {
+        writer->gen = large.gen ^ 1;
+    } else {
+        writer->gen = 0;
+        /* the chunk KVs are left when power down after the large KV is deleted */
+        del_chunk_kvs(db, key, 1, UINT32_MAX);
+    }
+    /* the chunk KVs are left when power down before the last writing is ended */
+    del_chunk_kvs(db, key, writer->gen, UINT32_MAX);
+
+    /* unlock the KV cache */
+    db_unlock(db);
+
+    return FDB_NO_ERR;
+}
+
+/**
+ * Write the value data of the large blob KV. The data is appended to the chunk buffer of the writer, the chunk KV is
+ * saved when the buffer is full. The value CRC32 is calculated incrementally.
+ *
+ * @param db database object
+ * @param writer large blob writer object, it's began by fdb_kv_set_blob_begin
+ * @param buf value data buffer
+ * @param len value data length
+ *
+ * @return result
+ */
+fdb_err_t fdb_kv_set_blob_write(fdb_kvdb_t db, fdb_kv_blob_writer_t writer, const void *buf, size_t len)
+{
+    const uint8_t *data = (const uint8_t *) buf;
+    size_t size;
+
+    if (!db_init_ok(db)) {
+        FDB_INFO("Error: KV (%s) isn't initialize OK.\n", db_name(db));
+        return FDB_INIT_FAILED;
+    }
+
+    if (writer->result != FDB_NO_ERR) {
+        return writer->result;
+    }
+
+    writer->crc32 = fdb_calc_crc32(writer->crc32, buf, len);
+    writer->len += len;
+    while (len > 0 && writer->result == FDB_NO_ERR) {
+        size = writer->chunk_size - writer->buf_len < len ? writer->chunk_size - writer->buf_len : len;
+        memcpy(writer->buf + writer->buf_len, data, size);
+        writer->buf_len += size;
+        data += size;
+        len -= size;
+        if (writer->buf_len == writer->chunk_size) {
+            /* lock the KV cache */
+            db_lock(db);
+            writer->result = save_chunk_kv(db, writer);
+            /* unlock the KV cache */
+            db_unlock(db);
+        }
+    }
+
+    return writer->result;
+}
+
+/**
+ * End the large blob KV setting. The last chunk KV and the large KV are saved, then the chunk KVs of the old value are
+ * deleted. The saved chunk KVs are dropped when any error occurred in writing, and the old value is kept.
+ *
+ * @param db database object
+ * @param writer large blob writer object, it's began by fdb_kv_set_blob_begin
+ *
+ * @return result
+ */
+fdb_err_t fdb_kv_set_blob_end(fdb_kvdb_t db, fdb_kv_blob_writer_t writer)
+{
+    fdb_err_t result;
+    struct kv_large_data large;
+
+    if (!db_init_ok(db)) {
+        FDB_INFO("Error: KV (%s) isn't initialize OK.\n", db_name(db));
+        return FDB_INIT_FAILED;
+    }
+
+    /* lock the KV cache */
+    db_lock(db);
+
+    result = writer->result;
+    if (result == FDB_NO_ERR && writer->buf_len > 0) {
+        result = save_chunk_kv(db, writer);
+    }
+    if (result == FDB_NO_ERR) {
+        large.magic = KV_LARGE_MAGIC_WORD;
+        large.len = writer->len;
+        large.crc32 = writer->crc32;
+        large.chunk_size = writer->chunk_size;
+        large.gen = writer->gen;
+        /* the old value is replaced by the large KV, its chunk KVs are deleted after that */
+        result = set_kv_ex(db, writer->key, &large, sizeof(large), KV_ATTR_NONE ^ KV_ATTR_LARGE);
+    }
+    if (result != FDB_NO_ERR) {
+        del_chunk_kvs(db, writer->key, writer->gen, writer->chunk_num);
+        writer->chunk_num = 0;
+    }
+    /* the ended writer MUST be began again */
+    writer->result = result == FDB_NO_ERR ? FDB_WRITE_ERR : result;
+
+    /* unlock the KV cache */
+    db_unlock(db);
+
+    return result;
+}
+
+#ifdef FDB_KV_USING_COMPRESS
+/*
+ * Read the compressed KV value from the offset. The value before the offset is also decompressed, so the value is
+ * decompressed to the compressed value buffer, it MUST be called with the exclusive lock when the offset is NOT 0.
+ */
+static size_t read_comp_kv_at(fdb_kvdb_t db, fdb_kv_t kv, size_t offset, void *buf, size_t len)
+{
+    size_t read_len;
+
+    if (offset == 0) {
+        return get_comp_kv(db, kv, buf, len, NULL);
+    }
+    if (offset >= sizeof(db->comp_buf)) {
+        return 0;
+    }
+    /* only the value before the end of the read range is decompressed */
+    read_len = len < sizeof(db->comp_buf) - offset ? offset + len : sizeof(db->comp_buf);
+    read_len = get_comp_kv(db, kv, db->comp_buf, read_len, NULL);
+    if (offset >= read_len) {
+        return 0;
+    }
+    len = read_len - offset;
+    memcpy(buf, db->comp_buf + offset, len);
+
+    return len;
+}
+#endif /* FDB_KV_USING_COMPRESS */
+
+/**
+ * Read the KV value from the offset. Only the chunk KVs in the range are read for the large blob KV, so a part of the
+ * large value is read without the buffer of whole value size.
+ *
+ * @param db database object
+ * @param key KV name
+ * @param offset value offset
+ * @param buf value buffer
+ * @param len the read length
+ *
+ * @return the actually read size
+ */
+size_t fdb_kv_read_blob_at(fdb_kvdb_t db, const char *key, size_t offset, void *buf, size_t len)
+{
+    struct fdb_kv kv;
+    struct kv_large_data large;
+    struct fdb_blob blob;
+    size_t read_len = 0;
+#ifdef FDB_KV_USING_COMPRESS
+    bool relocked = false;
+#endif
+
+    if (!db_init_ok(db)) {
+        FDB_INFO("Error: KV (%s) isn't initialize OK.\n", db_name(db));
+        return 0;
+    }
+
+    /* lock the KV cache */
+    db_rdlock(db);
+
+#ifdef FDB_KV_USING_COMPRESS
+__retry:
+#endif
+    if (find_kv(db, key, &kv)) {
+        if (read_large_kv(db, &kv, &large)) {
+            read_len = read_large_value(db, key, &large, offset, buf, len);
+#ifdef FDB_KV_USING_COMPRESS
+        } else if (kv_attr_is_set(kv.attr, KV_ATTR_COMPRESS)) {
+            if (offset == 0 || relocked || !db_rdlock_is_shared(db)) {
+                read_len = read_comp_kv_at(db, &kv, offset, buf, len);
+            } else {
+                /* the compressed value buffer is NOT shared by the readers, so it's read again with the exclusive lock */
+                db_rdunlock(db);
+                db_lock(db);
+                relocked = true;
+                goto __retry;
+            }
+#endif
+        } else {
+            read_len = fdb_blob_read_at((fdb_db_t)db, fdb_kv_to_blob(&kv, fdb_blob_make(&blob, buf, len)), offset, len);
+        }
+    }
+
+    /* unlock the KV cache */
+#ifdef FDB_KV_USING_COMPRESS
+    if (relocked) {
+        db_unlock(db);
+        return read_len;
+    }
+#endif
+    db_rdunlock(db);
+
+    return read_len;
+}
+#endif /* FDB_KV_USING_LARGE_BLOB */
+
+/**
+ * Set some blob KVs in one batch. All KVs in the batch are saved or none of them is saved when power down.
+ * The KVs are saved contiguously, so the total size of the batch MUST be less than a sector.
+ *
+ * @param db database object
+ * @param keys KV name array
+ * @param blobs blob object array, the blob value can NOT be NULL
+ * @param num the KV number in the batch
+ *
+ * @return result
+ */
+fdb_err_t fdb_kv_set_batch(fdb_kvdb_t db, const char *keys[], struct fdb_blob blobs[], size_t num)
+{
+    fdb_err_t result = FDB_NO_ERR;
+    uint8_t status_table[KV_STATUS_TABLE_SIZE];
+    struct kv_hdr_data kv_hdr;
+    struct kv_batch_data batch;
+    struct kvdb_sec_info sector;
+    struct fdb_kv batch_kv;
+    uint32_t kv_addr;
+    size_t i, j, name_len, total_len;
+    bool is_full = false, gc_step = false;
+
+    if (!db_init_ok(db)) {
+        FDB_INFO("Error: KV (%s) isn't initialize OK.\n", db_name(db));
+        return FDB_INIT_FAILED;
+    }
+
+    if (num == 0) {
+        return FDB_NO_ERR;
+    }
+
+    /* check all KVs and calculate the total length */
+    batch.magic = KV_BATCH_MAGIC_WORD;
+    batch.num = num;
+    batch.len = 0;
+    for (i = 0; i < num; i++) {
+        name_len = keys[i] ? strlen(keys[i]) : 0;
+        if (name_len == 0 || name_len > FDB_KV_NAME_MAX || blobs[i].buf == NULL) {
+            FDB_INFO("Error: The KV name or value in batch is invalid.\n");
+            return FDB_KV_NAME_ERR;
+        }
+        for (j = 0; j < i; j++) {
+            if (!strcmp(keys[i], keys[j])) {
+                FDB_INFO("Error: The KV (%s) is duplicated in batch.\n", keys[i]);
+                return FDB_KV_NAME_ERR;
+            }
+        }
+        batch.len += KV_HDR_DATA_SIZE + FDB_WG_ALIGN(name_len) + FDB_WG_ALIGN(blobs[i].size);
+    }
+    total_len = KV_HDR_DATA_SIZE + FDB_WG_ALIGN(sizeof(struct kv_batch_data)) + batch.len;
+    if (total_len > db_sec_size(db) - SECTOR_HDR_DATA_SIZE) {
+        FDB_INFO("Error: The KV batch size is too big\n");
+        return FDB_SAVED_FULL;
+    }
+
+    /* lock the KV cache */
+    db_lock(db);
+
+#ifdef FDB_KV_USING_LAZY_LOAD
+    finish_lazy_load(db);
+#endif
+
+    /* reserve the space for the batch record and all KVs once */
+    if ((kv_addr = new_kv(db, &sector, total_len)) == FAILED_ADDR) {
+        db_unlock(db);
+        return FDB_SAVED_FULL;
+    }
+    /* the empty sector number is reduced, check the incremental GC */
+    gc_step = sector.status.store == FDB_SECTOR_STORE_EMPTY;
+    batch_kv.addr.start = kv_addr;
+    result = update_sec_status(db, &sector, total_len, &is_full);
+    /* write the batch record and all KVs, they are KV_PRE_WRITE until the batch is committed */
+    if (result == FDB_NO_ERR) {
+        init_kv_hdr(&kv_hdr, 0, sizeof(struct kv_batch_data));
+        result = write_kv(db, kv_addr, &kv_hdr, "", &batch);
+        kv_addr += kv_hdr.len;
+    }
+    for (i = 0; result == FDB_NO_ERR && i < num; i++) {
+        init_kv_hdr(&kv_hdr, strlen(keys[i]), blobs[i].size);
+        result = write_kv(db, kv_addr, &kv_hdr, keys[i], blobs[i].buf);
+        kv_addr += kv_hdr.len;
+    }
+#ifdef FDB_KV_USING_CACHE
+    if (result == FDB_NO_ERR && !is_full) {
+        update_sector_empty_addr_cache(db, sector.addr, batch_kv.addr.start + total_len);
+    }
+#endif /* FDB_KV_USING_CACHE */
+    /* commit the batch, it's the only synced status change before the batch is saved */
+    if (result == FDB_NO_ERR) {
+        result = _fdb_write_status((fdb_db_t) db, batch_kv.addr.start, status_table, FDB_KV_STATUS_NUM, FDB_KV_WRITE,
+                true);
+    }
+    if (result == FDB_NO_ERR) {
+        read_kv(db, &batch_kv);
+#ifdef FDB_KV_USING_GC_COST_BENEFIT
+        sec_stat_add_kv(db, batch_kv.addr.start, batch_kv.len, true);
+#endif
+        /* change all KVs to KV_WRITE and delete the old KVs. It will be continued on next boot if power down */
+        result = finish_kv_batch(db, &batch_kv, &batch);
+    } else {
+#ifdef FDB_KV_USING_GC_COST_BENEFIT
+        /* the failed batch is garbage */
+        sec_stat_add_kv(db, batch_kv.addr.start, total_len, false);
+#endif
+    }
+    /* trigger GC collect when current sector is full */
+    if (result == FDB_NO_ERR && is_full) {
+        FDB_DEBUG("Trigger a GC check after created KV batch.\n");
+        db->gc_request = true;
+    }
+    set_kv_gc(db, gc_step, total_len);
+
+    /* unlock the KV cache */
+    db_unlock(db);
+
+    return result;
+}
+
 /**
  * recovery all KV to default.
  *
@@ -1417,12 +3574,26 @@ fdb_err_t fdb_kv_set_default(fdb_kvdb_t db)
     /* lock the KV cache */
     db_lock(db);
 
+#ifdef FDB_KV_USING_LAZY_LOAD
+    finish_lazy_load(db);
+#endif
+
 #ifdef FDB_KV_USING_CACHE
     for (i = 0; i < FDB_KV_CACHE_TABLE_SIZE; i++) {
         db->kv_cache_table[i].addr = FDB_DATA_UNUSED;
     }
 #endif /* FDB_KV_USING_CACHE */
 
+#ifdef FDB_KV_USING_INDEX
+    reset_kv_index(db);
+#endif
+#ifdef FDB_KV_USING_ORDERED_INDEX
+    reset_kv_order(db);
+#endif
+#ifdef FDB_KV_USING_INCREMENTAL_GC
+    db->gc_sec_addr = FAILED_ADDR;
+#endif
+
     /* format all sectors */
     for (addr = 0; addr < db_max_size(db); addr += db_sec_size(db)) {
         result = format_sector(db, addr, SECTOR_NOT_COMBINED);
@@ -1440,7 +3611,7 @@ fdb_err_t fdb_kv_set_default(fdb_kvdb_t db)
             value_len = db->default_kvs.kvs[i].value_len;
         }
         sector.empty_kv = FAILED_ADDR;
-        create_kv_blob(db, &sector, db->default_kvs.kvs[i].key, db->default_kvs.kvs[i].value, value_len);
+        create_kv_blob(db, &sector, db->default_kvs.kvs[i].key, db->default_kvs.kvs[i].value, value_len, KV_ATTR_NONE);
         if (result != FDB_NO_ERR) {
             goto __exit;
         }
@@ -1467,6 +3638,12 @@ static bool print_kv_cb(fdb_kv_t kv, void *arg1, void *arg2)
         if (kv->status == FDB_KV_WRITE) {
             FDB_PRINT("%.*s=", kv->name_len, kv->name);
 
+#ifdef FDB_KV_USING_COMPRESS
+            if (kv_attr_is_set(kv->attr, KV_ATTR_COMPRESS)) {
+                /* the compressed value is printed as blob */
+                value_is_str = false;
+            } else
+#endif
             if (kv->value_len < FDB_STR_KV_VALUE_MAX_SIZE ) {
                 uint8_t buf[32];
                 size_t len, size;
@@ -1519,7 +3696,7 @@ void fdb_kv_print(fdb_kvdb_t db)
     }
 
     /* lock the KV cache */
-    db_lock(db);
+    db_rdlock(db);
 
     kv_iterator(db, &kv, &using_size, db, print_kv_cb);
 
@@ -1528,7 +3705,7 @@ void fdb_kv_print(fdb_kvdb_t db)
             db_max_size(db) - db_sec_size(db) * FDB_GC_EMPTY_SEC_THRESHOLD);
 
     /* unlock the KV cache */
-    db_unlock(db);
+    db_rdunlock(db);
 }
 
 #ifdef FDB_KV_AUTO_UPDATE
@@ -1555,7 +3732,8 @@ static void kv_auto_update(fdb_kvdb_t db)
                         value_len = db->default_kvs.kvs[i].value_len;
                     }
                     db->cur_sector.empty_kv = FAILED_ADDR;
-                    create_kv_blob(db, &db->cur_sector, db->default_kvs.kvs[i].key, db->default_kvs.kvs[i].value, value_len);
+                    create_kv_blob(db, &db->cur_sector, db->default_kvs.kvs[i].key, db->default_kvs.kvs[i].value,
+                            value_len, KV_ATTR_NONE);
                 }
             }
         } else {
@@ -1620,6 +3798,7 @@ static bool check_and_recovery_gc_cb(kv_sec_info_t sector, void *arg1, void *arg
 static bool check_and_recovery_kv_cb(fdb_kv_t kv, void *arg1, void *arg2)
 {
     fdb_kvdb_t db = arg1;
+    struct kv_batch_data batch;
 
     /* recovery the prepare deleted KV */
     if (kv->crc_is_ok && kv->status == FDB_KV_PRE_DELETE) {
@@ -1631,31 +3810,300 @@ static bool check_and_recovery_kv_cb(fdb_kv_t kv, void *arg1, void *arg2)
             FDB_DEBUG("Warning: Moved an KV (size %" PRIu32 ") failed when recovery. Now will GC then retry.\n", kv->len);
             return true;
         }
+    } else if (kv->crc_is_ok && kv->status == FDB_KV_WRITE && is_kv_batch(db, kv, &batch)) {
+        FDB_INFO("Found a committed KV batch which has not finished. Now will finish it.\n");
+        finish_kv_batch(db, kv, &batch);
     } else if (kv->status == FDB_KV_PRE_WRITE) {
         uint8_t status_table[KV_STATUS_TABLE_SIZE];
-        /* the KV has not write finish, change the status to error */
+        /* the KV has not write finish, change the status to error. The KVs in uncommitted batch are discarded too */
         //TODO Draw the state replacement diagram of exception handling
         _fdb_write_status((fdb_db_t)db, kv->addr.start, status_table, FDB_KV_STATUS_NUM, FDB_KV_ERR_HDR, true);
-        return true;
     } else if (kv->crc_is_ok && kv->status == FDB_KV_WRITE) {
 #ifdef FDB_KV_USING_CACHE
         /* update the cache when first load. If caching is disabled, this step is not performed */
         update_kv_cache(db, kv->name, kv->name_len, kv->addr.start);
+#endif
+#ifdef FDB_KV_USING_INDEX
+        update_kv_index(db, kv->name, kv->name_len, kv->addr.start);
+#endif
+#ifdef FDB_KV_USING_ORDERED_INDEX
+        update_kv_order(db, kv->name, kv->name_len, kv->addr.start);
 #endif
     }
 
     return false;
 }
 
+#ifdef FDB_KV_USING_INDEX_SNAPSHOT
+static fdb_err_t save_kv_snapshot(fdb_kvdb_t db)
+{
+    fdb_err_t result = FDB_NO_ERR;
+    struct kv_snapshot_hdr hdr;
+    struct kv_snapshot_sec secs[KV_SNAPSHOT_SEC_BUF_NUM];
+    struct kvdb_sec_info sector;
+    uint32_t offset = sizeof(struct kv_snapshot_hdr), crc;
+    size_t i, num = 0, sec_num = SECTOR_NUM;
+
+    if (db->snap_file < 0) {
+        return FDB_INIT_FAILED;
+    }
+    /* the KV which is not in the index can't be loaded by the snapshot */
+    if (!db->kv_index_ok) {
+        return FDB_SAVED_FULL;
+    }
+
+    hdr.magic = KV_SNAPSHOT_MAGIC_WORD;
+    hdr.seq = db->snap_seq + 1;
+    hdr.sec_size = db_sec_size(db);
+    hdr.max_size = db_max_size(db);
+    hdr.index_size = FDB_KV_INDEX_TABLE_SIZE;
+    crc = fdb_calc_crc32(0, &hdr.seq, sizeof(struct kv_snapshot_hdr) - KV_SNAPSHOT_SEQ_OFFSET);
+    /* the file has data from now on, it will be cleaned when failed */
+    db->snap_valid = true;
+    for (i = 0; i < sec_num && result == FDB_NO_ERR; i++) {
+        if (read_sector_info(db, (uint32_t)i * db_sec_size(db), &sector, false) != FDB_NO_ERR) {
+            result = FDB_READ_ERR;
+            break;
+        }
+        if (sector.status.store == FDB_SECTOR_STORE_EMPTY || sector.status.store == FDB_SECTOR_STORE_USING) {
+            read_sector_info(db, sector.addr, &sector, true);
+            secs[num].empty_kv = sector.empty_kv;
+        } else {
+            /* the KV is never written to the full sector */
+            secs[num].empty_kv = sector.addr + db_sec_size(db);
+        }
+        secs[num].store = (uint8_t)sector.status.store;
+        secs[num].dirty = (uint8_t)sector.status.dirty;
+        secs[num].reserved[0] = secs[num].reserved[1] = FDB_BYTE_ERASED;
+        if (++num == KV_SNAPSHOT_SEC_BUF_NUM || i == sec_num - 1) {
+            crc = fdb_calc_crc32(crc, secs, num * sizeof(struct kv_snapshot_sec));
+            result = _fdb_file_ext_write(db->snap_file, offset, secs, num * sizeof(struct kv_snapshot_sec));
+            offset += num * sizeof(struct kv_snapshot_sec);
+            num = 0;
+        }
+    }
+    if (result == FDB_NO_ERR) {
+        crc = fdb_calc_crc32(crc, db->kv_index_table, sizeof(db->kv_index_table));
+        result = _fdb_file_ext_write(db->snap_file, offset, db->kv_index_table, sizeof(db->kv_index_table));
+    }
+    /* the header is written at last, the snapshot is NOT matched by the CRC32 when it's interrupted */
+    if (result == FDB_NO_ERR) {
+        hdr.crc32 = crc;
+        result = _fdb_file_ext_write(db->snap_file, 0, &hdr, sizeof(struct kv_snapshot_hdr));
+    }
+    if (result == FDB_NO_ERR) {
+        db->snap_seq = hdr.seq;
+    } else {
+        clean_kv_snapshot(db);
+    }
+
+    return result;
+}
+
+/*
+ * Load the KV index by the snapshot. The sector status is checked, and only the KVs which are written after the
+ * snapshot are checked for recovery. It returns false when the snapshot is NOT matched with the flash.
+ * The snapshot file is cleaned after it's loaded.
+ */
+static bool load_kv_snapshot(fdb_kvdb_t db)
+{
+    struct kv_snapshot_hdr hdr;
+    struct kv_snapshot_sec secs[KV_SNAPSHOT_SEC_BUF_NUM];
+    struct kvdb_sec_info sector;
+    struct kv_hdr_data kv_hdr;
+    struct fdb_kv kv;
+    char name[FDB_WG_ALIGN(FDB_KV_NAME_MAX)];
+    uint32_t offset, crc;
+    size_t i, j, num, sec_num = SECTOR_NUM;
+    kv_index_node_t node;
+    fdb_kv_status_t status;
+
+    if (!db->snap_valid || _fdb_file_ext_read(db->snap_file, 0, &hdr, sizeof(struct kv_snapshot_hdr)) != FDB_NO_ERR
+            || hdr.magic != KV_SNAPSHOT_MAGIC_WORD || hdr.sec_size != db_sec_size(db)
+            || hdr.max_size != db_max_size(db) || hdr.index_size != FDB_KV_INDEX_TABLE_SIZE) {
+        goto __failed;
+    }
+    /* check the CRC32 of the sector states and the index table */
+    crc = fdb_calc_crc32(0, &hdr.seq, sizeof(struct kv_snapshot_hdr) - KV_SNAPSHOT_SEQ_OFFSET);
+    for (i = 0, offset = sizeof(struct kv_snapshot_hdr); i < sec_num; i += num) {
+        num = sec_num - i < KV_SNAPSHOT_SEC_BUF_NUM ? sec_num - i : KV_SNAPSHOT_SEC_BUF_NUM;
+        if (_fdb_file_ext_read(db->snap_file, offset, secs, num * sizeof(struct kv_snapshot_sec)) != FDB_NO_ERR) {
+            goto __failed;
+        }
+        crc = fdb_calc_crc32(crc, secs, num * sizeof(struct kv_snapshot_sec));
+        offset += num * sizeof(struct kv_snapshot_sec);
+    }
+    if (_fdb_file_ext_read(db->snap_file, offset, db->kv_index_table, sizeof(db->kv_index_table)) != FDB_NO_ERR
+            || fdb_calc_crc32(crc, db->kv_index_table, sizeof(db->kv_index_table)) != hdr.crc32) {
+        goto __failed;
+    }
+    for (i = 0, db->kv_index_num = 0; i < FDB_KV_INDEX_TABLE_SIZE; i++) {
+        if (db->kv_index_table[i].addr != FDB_DATA_UNUSED) {
+            db->kv_index_num++;
+        }
+    }
+#ifdef FDB_KV_USING_ORDERED_INDEX
+    reset_kv_order(db);
+#endif
+
+    /* the sector status only goes forward until the sector is erased, the new KVs are behind the empty KV address */
+    for (i = 0, offset = sizeof(struct kv_snapshot_hdr); i < sec_num; i += num) {
+        num = sec_num - i < KV_SNAPSHOT_SEC_BUF_NUM ? sec_num - i : KV_SNAPSHOT_SEC_BUF_NUM;
+        if (_fdb_file_ext_read(db->snap_file, offset, secs, num * sizeof(struct kv_snapshot_sec)) != FDB_NO_ERR) {
+            goto __failed;
+        }
+        offset += num * sizeof(struct kv_snapshot_sec);
+        for (j = 0; j < num; j++) {
+            if (read_sector_info(db, (uint32_t)(i + j) * db_sec_size(db), &sector, false) != FDB_NO_ERR
+                    || sector.status.store < secs[j].store || sector.status.dirty < secs[j].dirty) {
+                goto __failed;
+            }
+            if (sector.status.store == FDB_SECTOR_STORE_EMPTY || secs[j].empty_kv >= sector.addr + db_sec_size(db)) {
+                continue;
+            }
+            kv.addr.start = secs[j].empty_kv;
+            do {
+                read_kv(db, &kv);
+                if (check_and_recovery_kv_cb(&kv, db, NULL) || db->gc_request) {
+                    goto __failed;
+                }
+            } while ((kv.addr.start = get_next_kv_addr(db, &sector, &kv)) != FAILED_ADDR);
+        }
+    }
+
+    /*
+     * check the KVs in the index, the KV which is deleted after the snapshot is removed.
+     * It's checked sector by sector, so the flash (or the sector file) is read in order.
+     */
+    for (j = 0, i = 0; j < sec_num; j++, i = 0) {
+        while (i < FDB_KV_INDEX_TABLE_SIZE) {
+            node = &db->kv_index_table[i];
+            if (node->addr == FDB_DATA_UNUSED || node->addr / db_sec_size(db) != j) {
+                i++;
+                continue;
+            }
+            _fdb_flash_read((fdb_db_t)db, node->addr, (uint32_t *)&kv_hdr, sizeof(struct kv_hdr_data));
+            status = _fdb_get_status(kv_hdr.status_table, FDB_KV_STATUS_NUM);
+            if (kv_hdr.magic != KV_MAGIC_WORD || kv_hdr.name_len > FDB_KV_NAME_MAX
+                    || (status != FDB_KV_WRITE && status != FDB_KV_DELETED)) {
+                /* the KV is changing when power down, it's recovered by checking all KV */
+                goto __failed;
+            }
+#ifndef FDB_KV_USING_ORDERED_INDEX
+            /* the name is only needed for removing the deleted KV */
+            if (status == FDB_KV_WRITE) {
+                i++;
+                continue;
+            }
+#endif
+            _fdb_flash_read((fdb_db_t)db, node->addr + KV_HDR_DATA_SIZE, (uint32_t *)name, FDB_WG_ALIGN(kv_hdr.name_len));
+            if (fdb_calc_crc32(0, name, kv_hdr.name_len) != node->name_crc) {
+                goto __failed;
+            }
+            if (status == FDB_KV_WRITE) {
+#ifdef FDB_KV_USING_ORDERED_INDEX
+                update_kv_order(db, name, kv_hdr.name_len, node->addr);
+#endif
+                i++;
+            } else {
+                /* the following node maybe moved to here, so check it again */
+                del_kv_index(db, name, kv_hdr.name_len, node->addr);
+            }
+        }
+    }
+    db->snap_seq = hdr.seq;
+    /* the snapshot is consumed, it's saved again by fdb_kvdb_save_snapshot or deinit. The session which doesn't use
+     * the snapshot mode erases the sectors without cleaning it, so it's NEVER loaded twice */
+    clean_kv_snapshot(db);
+
+    return true;
+
+__failed:
+    clean_kv_snapshot(db);
+
+    return false;
+}
+#endif /* FDB_KV_USING_INDEX_SNAPSHOT */
+
+/*
+ * Recovery the GC and the KVs which are changing when power down, then rebuild the index.
+ */
+static fdb_err_t load_kv_recovery(fdb_kvdb_t db)
+{
+    fdb_err_t result = FDB_NO_ERR;
+    struct fdb_kv kv;
+    struct kvdb_sec_info sector;
+
+    db->in_recovery_check = true;
+    /* check all sector header for recovery GC */
+    sector_iterator(db, &sector, FDB_SECTOR_STORE_UNUSED, db, NULL, check_and_recovery_gc_cb, false);
+
+#ifdef FDB_KV_USING_INDEX_SNAPSHOT
+    /* only the KVs which are written after the snapshot are checked, it falls back to check all KV when failed */
+    db->snap_loaded = load_kv_snapshot(db);
+    if (db->snap_loaded) {
+        goto __loaded;
+    }
+#endif
+
+__retry:
+#ifdef FDB_KV_USING_INDEX
+    /* the index is rebuilt by the KV recovery check, it's used after all KV is added */
+    db->kv_index_ok = false;
+    reset_kv_index(db);
+#endif
+#ifdef FDB_KV_USING_ORDERED_INDEX
+    reset_kv_order(db);
+#endif
+    /* check all KV for recovery */
+    kv_iterator(db, &kv, db, NULL, check_and_recovery_kv_cb);
+    if (db->gc_request) {
+        gc_collect(db);
+        goto __retry;
+    }
+
+#ifdef FDB_KV_USING_INDEX_SNAPSHOT
+__loaded:
+#endif
+#ifdef FDB_KV_USING_INDEX
+    db->kv_index_ok = db->kv_index_num < KV_INDEX_NUM_MAX;
+#endif
+#ifdef FDB_KV_USING_CACHE
+    if (db->sector_cache_all) {
+        /* fill the empty KV address of the sectors which can be allocated, all sector info is in the cache after boot */
+        sector_iterator(db, &sector, FDB_SECTOR_STORE_EMPTY, NULL, NULL, NULL, true);
+        sector_iterator(db, &sector, FDB_SECTOR_STORE_USING, NULL, NULL, NULL, true);
+    }
+#endif
+#ifdef FDB_KV_USING_FREE_MAP
+    build_free_map(db);
+#endif
+
+    db->in_recovery_check = false;
+
+    return result;
+}
+
+#ifdef FDB_KV_USING_LAZY_LOAD
+/*
+ * Finish the KV recovery check which is deferred by the lazy load. It MUST be called before the KVDB is modified.
+ */
+static void finish_lazy_load(fdb_kvdb_t db)
+{
+    if (db->lazy_pending) {
+        db->lazy_pending = false;
+        load_kv_recovery(db);
+    }
+}
+#endif /* FDB_KV_USING_LAZY_LOAD */
+
 /**
  * Check and load the flash KV.
  *
  * @return result
  */
 static fdb_err_t _fdb_kv_load(fdb_kvdb_t db)
-{
-    fdb_err_t result = FDB_NO_ERR;
-    struct fdb_kv kv;
+{
     struct kvdb_sec_info sector;
     size_t check_failed_count = 0;
 
@@ -1670,21 +4118,20 @@ static fdb_err_t _fdb_kv_load(fdb_kvdb_t db)
         FDB_INFO("All sector header is incorrect. Set it to default.\n");
         fdb_kv_set_default(db);
     }
+    db->in_recovery_check = false;
 
-    /* check all sector header for recovery GC */
-    sector_iterator(db, &sector, FDB_SECTOR_STORE_UNUSED, db, NULL, check_and_recovery_gc_cb, false);
-
-__retry:
-    /* check all KV for recovery */
-    kv_iterator(db, &kv, db, NULL, check_and_recovery_kv_cb);
-    if (db->gc_request) {
-        gc_collect(db);
-        goto __retry;
+#ifdef FDB_KV_USING_LAZY_LOAD
+    if (db->lazy_load) {
+        /* the KV is found on flash by name until the recovery check is done */
+        db->lazy_pending = true;
+#ifdef FDB_KV_USING_ORDERED_INDEX
+        db->kv_order_ok = false;
+#endif
+        return FDB_NO_ERR;
     }
+#endif /* FDB_KV_USING_LAZY_LOAD */
 
-    db->in_recovery_check = false;
-
-    return result;
+    return load_kv_recovery(db);
 }
 
 /**
@@ -1748,6 +4195,78 @@ void fdb_kvdb_control(fdb_kvdb_t db, int cmd, void *arg)
         FDB_ASSERT(db->parent.init_ok == false);
         db->parent.not_formatable = *(bool *)arg;
         break;
+    case FDB_KVDB_CTRL_SET_GC_BUDGET:
+#ifdef FDB_KV_USING_INCREMENTAL_GC
+        db->gc_budget = *(size_t *)arg;
+        db->gc_budget_set = true;
+#else
+        FDB_INFO("Error: set GC budget Failed. Please defined the FDB_KV_USING_INCREMENTAL_GC macro.");
+#endif
+        break;
+    case FDB_KVDB_CTRL_SET_SNAPSHOT:
+#ifdef FDB_KV_USING_INDEX_SNAPSHOT
+        /* this change MUST before database initialization */
+        FDB_ASSERT(db->parent.init_ok == false);
+        db->snapshot = *(bool *)arg;
+#else
+        FDB_INFO("Error: set index snapshot Failed. Please defined the FDB_KV_USING_INDEX_SNAPSHOT macro.");
+#endif
+        break;
+    case FDB_KVDB_CTRL_SET_LAZY_LOAD:
+#ifdef FDB_KV_USING_LAZY_LOAD
+        /* this change MUST before database initialization */
+        FDB_ASSERT(db->parent.init_ok == false);
+        db->lazy_load = *(bool *)arg;
+#else
+        FDB_INFO("Error: set lazy load Failed. Please defined the FDB_KV_USING_LAZY_LOAD macro.");
+#endif
+        break;
+    case FDB_KVDB_CTRL_SET_RDLOCK:
+#ifdef FDB_KV_USING_RW_LOCK
+#if !defined(__ARMCC_VERSION) && defined(__GNUC__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpedantic"
+#endif
+        db->parent.rdlock = (void (*)(fdb_db_t db)) arg;
+#if !defined(__ARMCC_VERSION) && defined(__GNUC__)
+#pragma GCC diagnostic pop
+#endif
+#else
+        FDB_INFO("Error: set read lock Failed. Please defined the FDB_KV_USING_RW_LOCK macro.");
+#endif
+        break;
+    case FDB_KVDB_CTRL_SET_RDUNLOCK:
+#ifdef FDB_KV_USING_RW_LOCK
+#if !defined(__ARMCC_VERSION) && defined(__GNUC__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpedantic"
+#endif
+        db->parent.rdunlock = (void (*)(fdb_db_t db)) arg;
+#if !defined(__ARMCC_VERSION) && defined(__GNUC__)
+#pragma GCC diagnostic pop
+#endif
+#else
+        FDB_INFO("Error: set read unlock Failed. Please defined the FDB_KV_USING_RW_LOCK macro.");
+#endif
+        break;
+    case FDB_KVDB_CTRL_SET_COMPRESS:
+#ifdef FDB_KV_USING_COMPRESS
+        /* this change will take effect on the next set KV */
+        db->compress = *(bool *)arg;
+#else
+        FDB_INFO("Error: set compress Failed. Please defined the FDB_KV_USING_COMPRESS macro.");
+#endif
+        break;
+    case FDB_KVDB_CTRL_SET_SEC_CACHE:
+#ifdef FDB_KV_USING_CACHE
+        /* this change MUST before database initialization */
+        FDB_ASSERT(db->parent.init_ok == false);
+        db->sector_cache_all = ((struct fdb_kvdb_sec_cache *)arg)->table;
+        db->sector_cache_all_num = ((struct fdb_kvdb_sec_cache *)arg)->num;
+#else
+        FDB_INFO("Error: set sector cache Failed. Please defined the FDB_KV_CACHE_TABLE_SIZE and FDB_SECTOR_CACHE_TABLE_SIZE macro.");
+#endif
+        break;
     }
 }
 
@@ -1792,6 +4311,44 @@ fdb_err_t fdb_kvdb_init(fdb_kvdb_t db, const char *name, const char *path, struc
         db->default_kvs.kvs = NULL;
     }
 
+#ifdef FDB_KV_USING_CACHE
+    if (db->sector_cache_all && db->sector_cache_all_num < SECTOR_NUM) {
+        FDB_INFO("Warning: the sector cache (%" PRIu32 ") is less than the sector number (%" PRIu32 "), it will NOT be used.\n",
+                (uint32_t)db->sector_cache_all_num, (uint32_t)SECTOR_NUM);
+        db->sector_cache_all = NULL;
+    }
+    /* the cache MUST be cleaned before the sector is read */
+    for (i = 0; db->sector_cache_all && i < db->sector_cache_all_num; i++) {
+        db->sector_cache_all[i].check_ok = false;
+        db->sector_cache_all[i].empty_kv = FAILED_ADDR;
+        db->sector_cache_all[i].addr = FDB_DATA_UNUSED;
+    }
+    for (i = 0; i < FDB_SECTOR_CACHE_TABLE_SIZE; i++) {
+        db->sector_cache_table[i].check_ok = false;
+        db->sector_cache_table[i].empty_kv = FAILED_ADDR;
+        db->sector_cache_table[i].addr = FDB_DATA_UNUSED;
+    }
+    for (i = 0; i < FDB_KV_CACHE_TABLE_SIZE; i++) {
+        db->kv_cache_table[i].addr = FDB_DATA_UNUSED;
+    }
+#endif /* FDB_KV_USING_CACHE */
+#ifdef FDB_KV_USING_INDEX_SNAPSHOT
+    db->snap_file = -1;
+    db->snap_valid = false;
+    db->snap_loaded = false;
+    db->snap_seq = 0;
+    if (db->snapshot) {
+        uint32_t snap_size = 0;
+        /* the snapshot file name is db_name.fdb.idx */
+        if (db->parent.file_mode) {
+            db->snap_file = _fdb_file_ext_open((fdb_db_t)db, "idx", &snap_size);
+        } else {
+            FDB_INFO("Warning: The KV index snapshot only supports the file mode.\n");
+        }
+        db->snap_valid = db->snap_file >= 0 && snap_size > 0;
+    }
+#endif
+
     { /* find the oldest sector address */
         uint32_t sector_oldest_addr = 0;
         fdb_sector_store_status_t last_sector_status = FDB_SECTOR_STORE_UNUSED;
@@ -1805,16 +4362,37 @@ fdb_err_t fdb_kvdb_init(fdb_kvdb_t db, const char *name, const char *path, struc
     /* there is at least one empty sector for GC. */
     FDB_ASSERT((FDB_GC_EMPTY_SEC_THRESHOLD > 0 && FDB_GC_EMPTY_SEC_THRESHOLD < SECTOR_NUM))
 
-#ifdef FDB_KV_USING_CACHE
-    for (i = 0; i < FDB_SECTOR_CACHE_TABLE_SIZE; i++) {
-        db->sector_cache_table[i].check_ok = false;
-        db->sector_cache_table[i].empty_kv = FAILED_ADDR;
-        db->sector_cache_table[i].addr = FDB_DATA_UNUSED;
+#ifdef FDB_KV_USING_INDEX
+    db->kv_index_ok = false;
+    reset_kv_index(db);
+#endif
+#ifdef FDB_KV_USING_ORDERED_INDEX
+    reset_kv_order(db);
+#endif
+#ifdef FDB_KV_USING_FREE_MAP
+    /* the free-space map is built after the KV is loaded */
+    db->free_map_ok = false;
+#endif
+#ifdef FDB_KV_CRC_VERIFY_ONCE
+    FDB_ASSERT(KV_HDR_DATA_SIZE > KV_VERIFIED_UNIT);
+    memset(db->kv_verified_map, 0, sizeof(db->kv_verified_map));
+#endif
+#ifdef FDB_KV_USING_GC_COST_BENEFIT
+    for (i = 0; i < FDB_KV_GC_SEC_NUM_MAX; i++) {
+        reset_sec_stat(db, i * db_sec_size(db), true);
     }
-    for (i = 0; i < FDB_KV_CACHE_TABLE_SIZE; i++) {
-        db->kv_cache_table[i].addr = FDB_DATA_UNUSED;
+    /* the write sequence is lost after boot, the sectors are aged by the ring order from the oldest one */
+    db->sec_seq = 0;
+    for (i = 0; i < SECTOR_NUM; i++) {
+        sec_stat_use_sector(db, (uint32_t)((db_oldest_addr(db) / db_sec_size(db) + i) % SECTOR_NUM) * db_sec_size(db));
     }
-#endif /* FDB_KV_USING_CACHE */
+#endif
+#ifdef FDB_KV_USING_INCREMENTAL_GC
+    db->gc_sec_addr = FAILED_ADDR;
+#endif
+#ifdef FDB_KV_USING_LAZY_LOAD
+    db->lazy_pending = false;
+#endif
 
     FDB_DEBUG("KVDB size is %" PRIu32 " bytes.\n", db_max_size(db));
     db_unlock(db);
@@ -1847,6 +4425,19 @@ __exit:
  */
 fdb_err_t fdb_kvdb_deinit(fdb_kvdb_t db)
 {
+#ifdef FDB_KV_USING_INDEX_SNAPSHOT
+    if (db->snapshot && db->snap_file >= 0) {
+        /* save the snapshot when the KVDB is shutdown cleanly */
+        if (db_init_ok(db)) {
+            db_lock(db);
+            save_kv_snapshot(db);
+            db_unlock(db);
+        }
+        _fdb_file_ext_close(db->snap_file);
+        db->snap_file = -1;
+    }
+#endif
+
     _fdb_deinit((fdb_db_t) db);
 
     return FDB_NO_ERR;
@@ -1874,15 +4465,10 @@ fdb_kv_iterator_t fdb_kv_iterator_init(fdb_kvdb_t db, fdb_kv_iterator_t itr)
     return itr;
 }
 
-/**
- * The KV database iterator.
- *
- * @param db database object
- * @param itr the iterator structure
- *
- * @return false if iteration is ended, true if iteration is not ended.
+/*
+ * Get the next valid KV on flash order, the iterator statistics is not changed.
  */
-bool fdb_kv_iterate(fdb_kvdb_t db, fdb_kv_iterator_t itr)
+static bool iterate_next_kv(fdb_kvdb_t db, fdb_kv_iterator_t itr)
 {
     struct kvdb_sec_info sector;
     fdb_kv_t kv = &(itr->curr_kv);
@@ -1899,12 +4485,9 @@ bool fdb_kv_iterate(fdb_kvdb_t db, fdb_kv_iterator_t itr)
                 }
                 do {
                     read_kv(db, kv);
-                    if (kv->status == FDB_KV_WRITE && kv->crc_is_ok == true) {
+                    /* the chunk KV is a part of the large KV value, it's NOT iterated */
+                    if (kv->status == FDB_KV_WRITE && kv->crc_is_ok == true && !kv_attr_is_set(kv->attr, KV_ATTR_CHUNK)) {
                         /* We got a valid kv here. */
-                        /* If iterator statistics is needed */
-                        itr->iterated_cnt++;
-                        itr->iterated_obj_bytes += kv->len;
-                        itr->iterated_value_bytes += kv->value_len;
                         return true;
                     }
                 } while ((kv->addr.start = get_next_kv_addr(db, &sector, kv)) != FAILED_ADDR);
@@ -1920,6 +4503,161 @@ bool fdb_kv_iterate(fdb_kvdb_t db, fdb_kv_iterator_t itr)
     return false;
 }
 
+/**
+ * The KV database iterator.
+ *
+ * @param db database object
+ * @param itr the iterator structure
+ *
+ * @return false if iteration is ended, true if iteration is not ended.
+ */
+bool fdb_kv_iterate(fdb_kvdb_t db, fdb_kv_iterator_t itr)
+{
+    fdb_kv_t kv = &(itr->curr_kv);
+
+    if (iterate_next_kv(db, itr)) {
+        /* If iterator statistics is needed */
+        itr->iterated_cnt++;
+        itr->iterated_obj_bytes += kv->len;
+        itr->iterated_value_bytes += kv->value_len;
+        return true;
+    }
+
+    return false;
+}
+
+/*
+ * Check the KV name has the prefix, or it's in the range [from, to]. The NULL from or to is unlimited.
+ */
+static bool kv_name_is_matched(fdb_kv_t kv, const char *prefix, const char *from, const char *to)
+{
+    if (prefix) {
+        return !strncmp(kv->name, prefix, strlen(prefix));
+    }
+
+    return (!from || strcmp(kv->name, from) >= 0) && (!to || strcmp(kv->name, to) <= 0);
+}
+
+#ifdef FDB_KV_USING_ORDERED_INDEX
+/*
+ * Check the ordered index node is behind all matched KVs. The saved name prefix is checked first.
+ */
+static bool kv_order_is_behind(fdb_kvdb_t db, kv_order_node_t node, const char *prefix, const char *to)
+{
+    size_t len;
+
+    if (prefix) {
+        len = strlen(prefix);
+        return memcmp(node->key, prefix, len < FDB_KV_ORDER_KEY_LEN ? len : FDB_KV_ORDER_KEY_LEN) != 0;
+    } else if (to) {
+        return kv_order_cmp(db, node, to, strlen(to)) > 0;
+    }
+
+    return false;
+}
+
+/*
+ * Get the next matched KV by the ordered index, it's start from the first matched KV, or behind the current KV.
+ */
+static bool iterate_next_kv_by_order(fdb_kvdb_t db, fdb_kv_iterator_t itr, const char *prefix, const char *from,
+        const char *to)
+{
+    fdb_kv_t kv = &(itr->curr_kv);
+    const char *start = prefix ? prefix : (from ? from : "");
+    size_t pos;
+    bool found;
+
+    if (itr->iterated_cnt == 0) {
+        pos = kv_order_lower_bound(db, start, strlen(start), &found);
+    } else {
+        pos = kv_order_lower_bound(db, kv->name, kv->name_len, &found);
+        pos = found ? pos + 1 : pos;
+    }
+    for (; pos < db->kv_order_num && !kv_order_is_behind(db, &db->kv_order_table[pos], prefix, to); pos++) {
+        kv->addr.start = db->kv_order_table[pos].addr;
+        read_kv(db, kv);
+        if (kv->status != FDB_KV_WRITE || !kv->crc_is_ok || kv_attr_is_set(kv->attr, KV_ATTR_CHUNK)) {
+            continue;
+        } else if (kv_name_is_matched(kv, prefix, from, to)) {
+            return true;
+        } else {
+            /* the name is longer than the saved prefix, all matched KVs are iterated */
+            break;
+        }
+    }
+
+    return false;
+}
+#endif /* FDB_KV_USING_ORDERED_INDEX */
+
+static bool iterate_kv_by_name(fdb_kvdb_t db, fdb_kv_iterator_t itr, const char *prefix, const char *from,
+        const char *to)
+{
+    fdb_kv_t kv = &(itr->curr_kv);
+    bool found = false;
+
+    /* lock the KV cache */
+    db_rdlock(db);
+
+#ifdef FDB_KV_USING_ORDERED_INDEX
+    if (db->kv_order_ok) {
+        found = iterate_next_kv_by_order(db, itr, prefix, from, to);
+    } else
+#endif
+    {
+        /* not all KVs are in the ordered index, iterate all KVs on flash */
+        do {
+            found = iterate_next_kv(db, itr);
+        } while (found && !kv_name_is_matched(kv, prefix, from, to));
+    }
+    if (found) {
+        /* If iterator statistics is needed */
+        itr->iterated_cnt++;
+        itr->iterated_obj_bytes += kv->len;
+        itr->iterated_value_bytes += kv->value_len;
+    }
+
+    /* unlock the KV cache */
+    db_rdunlock(db);
+
+    return found;
+}
+
+/**
+ * The KV database iterator for the KVs which name has the prefix.
+ * The KVs are iterated in name order when FDB_KV_USING_ORDERED_INDEX is enabled and all KVs are in the ordered index,
+ * otherwise they're iterated in flash order.
+ *
+ * @param db database object
+ * @param itr the iterator structure, it's initialized by fdb_kv_iterator_init
+ * @param prefix KV name prefix
+ *
+ * @return false if iteration is ended, true if iteration is not ended.
+ */
+bool fdb_kv_iterate_prefix(fdb_kvdb_t db, fdb_kv_iterator_t itr, const char *prefix)
+{
+    FDB_ASSERT(prefix);
+
+    return iterate_kv_by_name(db, itr, prefix, NULL, NULL);
+}
+
+/**
+ * The KV database iterator for the KVs which name is in the range [from, to] by byte order.
+ * The KVs are iterated in name order when FDB_KV_USING_ORDERED_INDEX is enabled and all KVs are in the ordered index,
+ * otherwise they're iterated in flash order.
+ *
+ * @param db database object
+ * @param itr the iterator structure, it's initialized by fdb_kv_iterator_init
+ * @param from the minimum KV name, NULL: unlimited
+ * @param to the maximum KV name, NULL: unlimited
+ *
+ * @return false if iteration is ended, true if iteration is not ended.
+ */
+bool fdb_kv_iterate_range(fdb_kvdb_t db, fdb_kv_iterator_t itr, const char *from, const char *to)
+{
+    return iterate_kv_by_name(db, itr, NULL, from, to);
+}
+
 /**
  * The database inergrity check
  *
@@ -1954,7 +4692,8 @@ fdb_err_t fdb_kvdb_check(fdb_kvdb_t db)
                 kv.addr.start = sector.addr + SECTOR_HDR_DATA_SIZE;
                 /* search all KV */
                 do {
-                    result = read_kv(db, &kv);
+                    /* the CRC32 is always checked, it's the scrub for FDB_KV_CRC_VERIFY_ONCE */
+                    result = read_kv_ex(db, &kv, true);
                 } while ((kv.addr.start = get_next_kv_addr(db, &sector, &kv)) != FAILED_ADDR && result == FDB_NO_ERR);
             }
         }
@@ -1966,4 +4705,97 @@ fdb_err_t fdb_kvdb_check(fdb_kvdb_t db)
     return result;
 }
 
+#ifdef FDB_KV_USING_LAZY_LOAD
+/**
+ * Finish the KV recovery check which is deferred by the lazy load, e.g. in the idle time after boot.
+ * It's also done by the first modification of the KVDB, such as set, delete or GC step.
+ *
+ * @param db database object
+ *
+ * @return result
+ */
+fdb_err_t fdb_kvdb_finish_load(fdb_kvdb_t db)
+{
+    if (!db_init_ok(db)) {
+        FDB_INFO("Error: KV (%s) isn't initialize OK.\n", db_name(db));
+        return FDB_INIT_FAILED;
+    }
+
+    /* lock the KV cache */
+    db_lock(db);
+
+    finish_lazy_load(db);
+
+    /* unlock the KV cache */
+    db_unlock(db);
+
+    return FDB_NO_ERR;
+}
+#endif /* FDB_KV_USING_LAZY_LOAD */
+
+#ifdef FDB_KV_USING_INDEX_SNAPSHOT
+/**
+ * Save the KV index snapshot to the snapshot file, it's also saved when the KVDB is deinitialized.
+ * The KVDB is loaded by the snapshot when boot, only the KVs which are written after it are checked.
+ *
+ * @param db database object
+ *
+ * @return result
+ */
+fdb_err_t fdb_kvdb_save_snapshot(fdb_kvdb_t db)
+{
+    fdb_err_t result;
+
+    if (!db_init_ok(db)) {
+        FDB_INFO("Error: KV (%s) isn't initialize OK.\n", db_name(db));
+        return FDB_INIT_FAILED;
+    }
+
+    /* lock the KV cache */
+    db_lock(db);
+
+    result = save_kv_snapshot(db);
+
+    /* unlock the KV cache */
+    db_unlock(db);
+
+    return result;
+}
+#endif /* FDB_KV_USING_INDEX_SNAPSHOT */
+
+#ifdef FDB_KV_USING_INCREMENTAL_GC
+/**
+ * Do an incremental GC step, it's recommended to call it in the idle time.
+ * The GC is only done when the remain empty sectors are NOT enough.
+ *
+ * @param db database object
+ * @param budget the moved KV bytes budget of this step, at least one KV is moved
+ *
+ * @return true: the GC is NOT finished, it needs more steps
+ */
+bool fdb_kvdb_gc_step(fdb_kvdb_t db, size_t budget)
+{
+    bool result;
+
+    if (!db_init_ok(db)) {
+        FDB_INFO("Error: KV (%s) isn't initialize OK.\n", db_name(db));
+        return false;
+    }
+
+    /* lock the KV cache */
+    db_lock(db);
+
+#ifdef FDB_KV_USING_LAZY_LOAD
+    finish_lazy_load(db);
+#endif
+
+    result = gc_collect_step(db, budget ? budget : 1);
+
+    /* unlock the KV cache */
+    db_unlock(db);
+
+    return result;
+}
+#endif /* FDB_KV_USING_INCREMENTAL_GC */
+
 #endif /* defined(FDB_USING_KVDB) */
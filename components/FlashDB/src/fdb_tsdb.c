@@ -29,14 +29,42 @@
 #error "Flash 64 or 128 bits write granularity is not supported in TSDB yet!"
 #endif
 
+#if defined(FDB_TSDB_USING_SECTOR_POOL) && defined(FDB_TSDB_USING_TIME_DELTA)
+/* magic word(`T`, `S`, `L`, `3`), the sector header saves the pool owner and the TSL index saves the timestamp delta */
+#define SECTOR_MAGIC_WORD                        0x334C5354
+#elif defined(FDB_TSDB_USING_SECTOR_POOL)
+/* magic word(`T`, `S`, `L`, `2`), the sector header saves the pool owner */
+#define SECTOR_MAGIC_WORD                        0x324C5354
+#elif defined(FDB_TSDB_USING_TIME_DELTA)
+/* magic word(`T`, `S`, `L`, `1`), the TSL index saves the timestamp delta from sector start time */
+#define SECTOR_MAGIC_WORD                        0x314C5354
+#else
 /* magic word(`T`, `S`, `L`, `0`) */
 #define SECTOR_MAGIC_WORD                        0x304C5354
+#endif
+
+#ifdef FDB_TSDB_USING_TIME_DELTA
+/* the maximum timestamp delta in a sector, the newer TSL will be saved to the next sector */
+#define TSL_TIME_DELTA_MAX                       UINT32_MAX
+#endif
+
+#ifdef FDB_USING_TIMESTAMP_64BIT
+#define TSL_TIME_MIN                             INT64_MIN
+#define TSL_TIME_MAX                             INT64_MAX
+#else
+#define TSL_TIME_MIN                             INT32_MIN
+#define TSL_TIME_MAX                             INT32_MAX
+#endif
 
 #define TSL_STATUS_TABLE_SIZE                    FDB_STATUS_TABLE_SIZE(FDB_TSL_STATUS_NUM)
 
 #define SECTOR_HDR_DATA_SIZE                     (FDB_WG_ALIGN(sizeof(struct sector_hdr_data)))
 #define LOG_IDX_DATA_SIZE                        (FDB_WG_ALIGN(sizeof(struct log_idx_data)))
+#ifdef FDB_TSDB_USING_TIME_DELTA
+#define LOG_IDX_TS_OFFSET                        ((unsigned long)(&((struct log_idx_data *)0)->time_delta))
+#else
 #define LOG_IDX_TS_OFFSET                        ((unsigned long)(&((struct log_idx_data *)0)->time))
+#endif
 #define SECTOR_MAGIC_OFFSET                      ((unsigned long)(&((struct sector_hdr_data *)0)->magic))
 #define SECTOR_START_TIME_OFFSET                 ((unsigned long)(&((struct sector_hdr_data *)0)->start_time))
 #define SECTOR_END0_TIME_OFFSET                  ((unsigned long)(&((struct sector_hdr_data *)0)->end_info[0].time))
@@ -45,6 +73,22 @@
 #define SECTOR_END1_TIME_OFFSET                  ((unsigned long)(&((struct sector_hdr_data *)0)->end_info[1].time))
 #define SECTOR_END1_IDX_OFFSET                   ((unsigned long)(&((struct sector_hdr_data *)0)->end_info[1].index))
 #define SECTOR_END1_STATUS_OFFSET                ((unsigned long)(&((struct sector_hdr_data *)0)->end_info[1].status))
+#ifdef FDB_TSDB_USING_ARCHIVE
+/* magic word(`T`, `S`, `A`, `0`) */
+#define ARC_BLK_MAGIC_WORD                       0x30415354
+#define ARC_BLK_HDR_SIZE                         (sizeof(struct arc_blk_hdr))
+/* the block length is saved at the block end, the reverse iterator walks the archive file by it */
+#define ARC_BLK_TAIL_SIZE                        (sizeof(uint32_t))
+#define ARC_TSL_IDX_SIZE                         (sizeof(struct arc_tsl_idx))
+#endif
+#ifdef FDB_TSDB_USING_SECTOR_POOL
+#define SECTOR_OWNER_OFFSET                      ((unsigned long)(&((struct sector_hdr_data *)0)->owner))
+#define SECTOR_SEQ_OFFSET                        ((unsigned long)(&((struct sector_hdr_data *)0)->seq))
+/* the sector isn't owned by any TSDB in the pool */
+#define POOL_OWNER_FREE                          0xFFFFFFFF
+/* the end of the sector chain */
+#define POOL_SEC_NONE                            0xFFFF
+#endif
 
 /* the next address is get failed */
 #define FAILED_ADDR                              0xFFFFFFFF
@@ -86,6 +130,10 @@ struct sector_hdr_data {
         uint32_t index;                          /**< the last end node's index */
         uint8_t status[TSL_STATUS_TABLE_SIZE];   /**< end node status, @see fdb_tsl_status_t */
     } end_info[2];
+#ifdef FDB_TSDB_USING_SECTOR_POOL
+    uint32_t owner;                              /**< owner TSDB tag in the sector pool */
+    uint32_t seq;                                /**< allocation sequence number in the sector pool */
+#endif
     uint32_t reserved;
 };
 typedef struct sector_hdr_data *sector_hdr_data_t;
@@ -93,7 +141,11 @@ typedef struct sector_hdr_data *sector_hdr_data_t;
 /* time series log node index data */
 struct log_idx_data {
     uint8_t status_table[TSL_STATUS_TABLE_SIZE]; /**< node status, @see fdb_tsl_status_t */
+#ifdef FDB_TSDB_USING_TIME_DELTA
+    uint32_t time_delta;                         /**< node timestamp delta from the sector start timestamp */
+#else
     fdb_time_t time;                             /**< node timestamp */
+#endif
     uint32_t log_len;                            /**< node total length (header + name + value), must align by FDB_WRITE_GRAN */
     uint32_t log_addr;                           /**< node address */
 };
@@ -104,6 +156,74 @@ struct query_count_args {
     size_t count;
 };
 
+/* the TSDB status which is captured at the iterator start */
+struct tsdb_snapshot {
+    bool locked;                                 /**< the database is locked during the iteration */
+    uint32_t oldest_addr;                        /**< the oldest sector address */
+    struct tsdb_sec_info cur_sec;                /**< the current using sector, the newer TSL is out of the snapshot */
+    uint32_t recycled_num;                       /**< the recycled sectors number */
+#ifdef FDB_TSDB_USING_SECTOR_POOL
+    uint32_t cur_seq;                            /**< the current using sector sequence number in the pool */
+#endif
+#ifdef FDB_TSDB_USING_ARCHIVE
+    uint32_t arc_size;                           /**< the archive file size */
+    fdb_time_t arc_end_time;                     /**< the newest archived TSL timestamp */
+#endif
+};
+typedef struct tsdb_snapshot *tsdb_snapshot_t;
+
+#ifdef FDB_TSDB_USING_ARCHIVE
+/* the block header in the archive file, the block is saved as: header + payload + block length */
+struct arc_blk_hdr {
+    uint32_t magic;                              /**< magic word(`T`, `S`, `A`, `0`) */
+    uint32_t count;                              /**< TSL number */
+    fdb_time_t start_time;                       /**< the first TSL timestamp */
+    fdb_time_t end_time;                         /**< the last TSL timestamp */
+    uint32_t raw_len;                            /**< raw data length */
+    uint32_t comp_len;                           /**< payload length, it's equal to raw_len when the payload is not compressed */
+    uint32_t crc32;                              /**< payload CRC32 */
+};
+
+/* the TSL index in the block raw data, all TSL data are saved after the indexes, and from the raw data end */
+struct arc_tsl_idx {
+    fdb_time_t time_delta;                       /**< timestamp delta from the previous TSL */
+    uint32_t log_len;                            /**< log length */
+    uint32_t status;                             /**< TSL status, @see fdb_tsl_status_t */
+};
+
+/* the block which is building in the archive raw data buffer */
+struct arc_builder {
+    uint32_t count;
+    uint32_t data_pos;                           /**< the TSL data is saved from the buffer end */
+    fdb_time_t start_time;
+    fdb_time_t end_time;
+};
+
+#endif /* FDB_TSDB_USING_ARCHIVE */
+
+/* the TSL cursor by timestamp, it's used by the time iterator and the merge iterator */
+struct tsl_cursor {
+    fdb_tsdb_t db;
+    tsdb_snapshot_t snap;
+    fdb_time_t from;
+    fdb_time_t to;
+    uint32_t start_addr;                         /**< the first searched sector address */
+    uint32_t sec_addr;                           /**< the next sector address, FAILED_ADDR: finished */
+    uint32_t traversed_len;
+    uint32_t next_idx;                           /**< the next TSL index address, FAILED_ADDR: in the next sector */
+    bool found_start_tsl;
+    struct tsdb_sec_info sector;                 /**< the current sector */
+    struct fdb_tsl tsl;                          /**< the current TSL */
+#ifdef FDB_TSDB_USING_ARCHIVE
+    bool arc_walk;                               /**< the archive is walked before the sectors on forward, after them on reverse */
+    uint32_t arc_addr;                           /**< the next block address on forward, the next block end on reverse */
+    uint32_t arc_blk;                            /**< the current block address */
+    uint32_t arc_left;                           /**< the TSL number which is not walked in the current block */
+    struct arc_blk_hdr arc_hdr;                  /**< the current block header */
+#endif
+};
+typedef struct tsl_cursor *tsl_cursor_t;
+
 struct check_sec_hdr_cb_args {
     fdb_tsdb_t db;
     bool check_failed;
@@ -111,9 +231,17 @@ struct check_sec_hdr_cb_args {
     uint32_t empty_addr;
 };
 
-static fdb_err_t read_tsl(fdb_tsdb_t db, fdb_tsl_t tsl)
+static uint32_t get_sec_gen(fdb_tsdb_t db, uint32_t sec_addr);
+#ifdef FDB_TSDB_USING_ARCHIVE
+static bool tsl_iter_arc(fdb_tsdb_t db, tsdb_snapshot_t snap, bool reverse, fdb_tsl_cb cb, void *cb_arg);
+static bool arc_has_tsl(tsdb_snapshot_t snap, fdb_tsl_t tsl);
+#endif
+
+static fdb_err_t read_tsl(fdb_tsdb_t db, tsdb_sec_info_t sector, fdb_tsl_t tsl)
 {
     struct log_idx_data idx;
+    /* the generation is got before the read, so the sector which is recycled after it is found by the blob read */
+    tsl->sec_gen = get_sec_gen(db, sector->addr);
     /* read TSL index raw data */
     _fdb_flash_read((fdb_db_t)db, tsl->addr.index, (uint32_t *) &idx, sizeof(struct log_idx_data));
     tsl->status = (fdb_tsl_status_t) _fdb_get_status(idx.status_table, FDB_TSL_STATUS_NUM);
@@ -124,15 +252,92 @@ static fdb_err_t read_tsl(fdb_tsdb_t db, fdb_tsl_t tsl)
     } else {
         tsl->log_len = idx.log_len;
         tsl->addr.log = idx.log_addr;
+#ifdef FDB_TSDB_USING_TIME_DELTA
+        tsl->time = sector->start_time + idx.time_delta;
+#else
         tsl->time = idx.time;
+#endif
     }
 
     return FDB_NO_ERR;
 }
 
+#ifdef FDB_TSDB_USING_SECTOR_POOL
+#define pool_lock(pool)                                                        \
+    do {                                                                       \
+        if ((pool)->lock) (pool)->lock(pool);                                  \
+    } while(0);
+
+#define pool_unlock(pool)                                                      \
+    do {                                                                       \
+        if ((pool)->unlock) (pool)->unlock(pool);                              \
+    } while(0);
+
+static struct fdb_tsdb_pool_sec *pool_sec(fdb_tsdb_t db, uint32_t addr)
+{
+    return &db->pool->sec_table[addr / db_sec_size(db)];
+}
+
+/*
+ * Get the oldest sector of the TSDB, it's the head of its chain. The pool lock MUST be held.
+ */
+static uint32_t pool_head_addr(fdb_tsdb_t db)
+{
+    uint32_t i;
+
+    for (i = 0; i < db->pool->sec_num; i++) {
+        if (db->pool->sec_table[i].owner == db->owner && db->pool->sec_table[i].prev == POOL_SEC_NONE) {
+            return i * db_sec_size(db);
+        }
+    }
+
+    return FAILED_ADDR;
+}
+
+static uint32_t pool_next_sector_addr(fdb_tsdb_t db, uint32_t addr)
+{
+    struct fdb_tsdb_pool_sec *sec = pool_sec(db, addr);
+    uint32_t next_addr;
+
+    pool_lock(db->pool);
+    if (sec->owner != db->owner) {
+        /* the sector is recycled by the pool, continue from the oldest sector */
+        next_addr = pool_head_addr(db);
+    } else if (sec->next == POOL_SEC_NONE) {
+        next_addr = FAILED_ADDR;
+    } else {
+        next_addr = sec->next * db_sec_size(db);
+    }
+    pool_unlock(db->pool);
+
+    return next_addr;
+}
+
+static uint32_t pool_last_sector_addr(fdb_tsdb_t db, uint32_t addr)
+{
+    struct fdb_tsdb_pool_sec *sec = pool_sec(db, addr);
+    uint32_t last_addr;
+
+    pool_lock(db->pool);
+    if (sec->owner != db->owner || sec->prev == POOL_SEC_NONE) {
+        last_addr = FAILED_ADDR;
+    } else {
+        last_addr = sec->prev * db_sec_size(db);
+    }
+    pool_unlock(db->pool);
+
+    return last_addr;
+}
+#endif /* FDB_TSDB_USING_SECTOR_POOL */
+
 static uint32_t get_next_sector_addr(fdb_tsdb_t db, tsdb_sec_info_t pre_sec, uint32_t traversed_len)
 {
     if (traversed_len + db_sec_size(db) <= db_max_size(db)) {
+#ifdef FDB_TSDB_USING_SECTOR_POOL
+        if (db->pool) {
+            return pool_next_sector_addr(db, pre_sec->addr);
+        }
+#endif
         if (pre_sec->addr + db_sec_size(db) < db_max_size(db)) {
             return pre_sec->addr + db_sec_size(db);
         } else {
@@ -183,6 +388,11 @@ static uint32_t get_last_tsl_addr(tsdb_sec_info_t sector, fdb_tsl_t pre_tsl)
 static uint32_t get_last_sector_addr(fdb_tsdb_t db, tsdb_sec_info_t pre_sec, uint32_t traversed_len)
 {
     if (traversed_len + db_sec_size(db) <= db_max_size(db)) {
+#ifdef FDB_TSDB_USING_SECTOR_POOL
+        if (db->pool) {
+            return pool_last_sector_addr(db, pre_sec->addr);
+        }
+#endif
         if (pre_sec->addr >= db_sec_size(db)) {
             /* the next sector is previous sector */
             return pre_sec->addr - db_sec_size(db);
@@ -237,7 +447,7 @@ static fdb_err_t read_sector_info(fdb_tsdb_t db, uint32_t addr, tsdb_sec_info_t
         struct fdb_tsl tsl;
 
         tsl.addr.index = sector->empty_idx;
-        while (read_tsl(db, &tsl) == FDB_NO_ERR) {
+        while (read_tsl(db, sector, &tsl) == FDB_NO_ERR) {
             if (tsl.status == FDB_TSL_UNUSED) {
                 break;
             }
@@ -301,176 +511,1015 @@ static void sector_iterator(fdb_tsdb_t db, tsdb_sec_info_t sector, fdb_sector_st
     } while ((sec_addr = get_next_sector_addr(db, sector, traversed_len)) != FAILED_ADDR);
 }
 
-static fdb_err_t write_tsl(fdb_tsdb_t db, fdb_blob_t blob, fdb_time_t time)
+#ifdef FDB_TSDB_USING_SECTOR_POOL
+static fdb_tsdb_t pool_find_db(fdb_tsdb_pool_t pool, uint32_t owner)
 {
-    fdb_err_t result = FDB_NO_ERR;
-    struct log_idx_data idx;
-    uint32_t idx_addr = db->cur_sec.empty_idx;
+    size_t i;
 
-    idx.log_len = blob->size;
-    idx.time = time;
-    idx.log_addr = db->cur_sec.empty_data - FDB_WG_ALIGN(idx.log_len);
-    /* write the status will by write granularity */
-    _FDB_WRITE_STATUS(db, idx_addr, idx.status_table, FDB_TSL_STATUS_NUM, FDB_TSL_PRE_WRITE, false);
-    /* write other index info */
-    FLASH_WRITE(db, idx_addr + LOG_IDX_TS_OFFSET, &idx.time,  sizeof(struct log_idx_data) - LOG_IDX_TS_OFFSET, false);
-    /* write blob data */
-    FLASH_WRITE(db, idx.log_addr, blob->buf, blob->size, false);
-    /* write the status will by write granularity */
-    _FDB_WRITE_STATUS(db, idx_addr, idx.status_table, FDB_TSL_STATUS_NUM, FDB_TSL_WRITE, true);
+    for (i = 0; i < FDB_TSDB_POOL_DB_MAX; i++) {
+        if (pool->db_table[i] && pool->db_table[i]->owner == owner) {
+            return pool->db_table[i];
+        }
+    }
 
-    return result;
+    return NULL;
 }
 
-static fdb_err_t update_sec_status(fdb_tsdb_t db, tsdb_sec_info_t sector, fdb_blob_t blob, fdb_time_t cur_time)
+/*
+ * Check the sector can be recycled for other TSDB. The pool lock MUST be held.
+ * The tail of each chain is the current using sector of its owner, and the TSDB which is not rollover keeps its sectors.
+ */
+static bool pool_sec_is_recyclable(fdb_tsdb_pool_t pool, uint32_t index)
 {
-    fdb_err_t result = FDB_NO_ERR;
-    uint8_t status[FDB_STORE_STATUS_TABLE_SIZE];
+    struct fdb_tsdb_pool_sec *sec = &pool->sec_table[index];
+    fdb_tsdb_t owner_db;
 
-    if (sector->status == FDB_SECTOR_STORE_USING && sector->remain < LOG_IDX_DATA_SIZE + FDB_WG_ALIGN(blob->size)) {
-        uint8_t end_status[TSL_STATUS_TABLE_SIZE];
-        uint32_t end_index = sector->empty_idx - LOG_IDX_DATA_SIZE, new_sec_addr, cur_sec_addr = sector->addr;
-        /* save the end node index and timestamp */
-        if (sector->end_info_stat[0] == FDB_TSL_UNUSED) {
-            _FDB_WRITE_STATUS(db, cur_sec_addr + SECTOR_END0_STATUS_OFFSET, end_status, FDB_TSL_STATUS_NUM, FDB_TSL_PRE_WRITE, false);
-            FLASH_WRITE(db, cur_sec_addr + SECTOR_END0_TIME_OFFSET, (uint32_t * )&db->last_time, sizeof(fdb_time_t), false);
-            FLASH_WRITE(db, cur_sec_addr + SECTOR_END0_IDX_OFFSET, &end_index, sizeof(end_index), false);
-            _FDB_WRITE_STATUS(db, cur_sec_addr + SECTOR_END0_STATUS_OFFSET, end_status, FDB_TSL_STATUS_NUM, FDB_TSL_WRITE, true);
-        } else if (sector->end_info_stat[1] == FDB_TSL_UNUSED) {
-            _FDB_WRITE_STATUS(db, cur_sec_addr + SECTOR_END1_STATUS_OFFSET, end_status, FDB_TSL_STATUS_NUM, FDB_TSL_PRE_WRITE, false);
-            FLASH_WRITE(db, cur_sec_addr + SECTOR_END1_TIME_OFFSET, (uint32_t * )&db->last_time, sizeof(fdb_time_t), false);
-            FLASH_WRITE(db, cur_sec_addr + SECTOR_END1_IDX_OFFSET, &end_index, sizeof(end_index), false);
-            _FDB_WRITE_STATUS(db, cur_sec_addr + SECTOR_END1_STATUS_OFFSET, end_status, FDB_TSL_STATUS_NUM, FDB_TSL_WRITE, true);
+    if (sec->owner == POOL_OWNER_FREE || sec->next == POOL_SEC_NONE) {
+        return false;
+    }
+    owner_db = pool_find_db(pool, sec->owner);
+
+    return owner_db == NULL || owner_db->rollover;
+}
+
+/*
+ * Remove the sector from the owner's chain. The pool lock MUST be held.
+ * Only the sector table is changed for other owner, it gets its oldest sector from the table under its own lock.
+ */
+static void pool_unlink(fdb_tsdb_t db, uint32_t index)
+{
+    fdb_tsdb_pool_t pool = db->pool;
+    struct fdb_tsdb_pool_sec *sec = &pool->sec_table[index];
+
+    if (sec->prev != POOL_SEC_NONE) {
+        pool->sec_table[sec->prev].next = sec->next;
+    }
+    if (sec->next != POOL_SEC_NONE) {
+        pool->sec_table[sec->next].prev = sec->prev;
+        if (sec->owner == db->owner && sec->prev == POOL_SEC_NONE) {
+            db_oldest_addr(db) = sec->next * db_sec_size(db);
         }
-        /* change current sector to full */
-        _FDB_WRITE_STATUS(db, cur_sec_addr, status, FDB_SECTOR_STORE_STATUS_NUM, FDB_SECTOR_STORE_FULL, true);
-        sector->status = FDB_SECTOR_STORE_FULL;
-        /* calculate next sector address */
-        if (sector->addr + db_sec_size(db) < db_max_size(db)) {
-            new_sec_addr = sector->addr + db_sec_size(db);
+    }
+    /* the snapshot iterator checks the owner after read, so it MUST be changed before format */
+    sec->owner = POOL_OWNER_FREE;
+    sec->prev = POOL_SEC_NONE;
+    sec->next = POOL_SEC_NONE;
+}
+
+/*
+ * Allocate an empty sector from the pool and append it to the TSDB's chain. The pool lock MUST be held.
+ * The free sector is used first, then the oldest recyclable sector in the pool is recycled when rollover.
+ */
+static fdb_err_t pool_alloc_sector(fdb_tsdb_t db, uint32_t *addr)
+{
+    fdb_err_t result = FDB_NO_ERR;
+    fdb_tsdb_pool_t pool = db->pool;
+    struct fdb_tsdb_pool_sec *sec;
+    uint32_t i, index = POOL_SEC_NONE;
+
+    for (i = 0; i < pool->sec_num; i++) {
+        if (pool->sec_table[i].owner == POOL_OWNER_FREE) {
+            index = i;
+            break;
         }
-        else if (db->rollover) {
-            new_sec_addr = 0;
-        } else {
-            /* not rollover */
+    }
+    if (index == POOL_SEC_NONE) {
+        if (!db->rollover) {
             return FDB_SAVED_FULL;
         }
-        read_sector_info(db, new_sec_addr, &db->cur_sec, false);
-        if (sector->status != FDB_SECTOR_STORE_EMPTY) {
-            /* calculate the oldest sector address */
-            if (new_sec_addr + db_sec_size(db) < db_max_size(db)) {
-                db_oldest_addr(db) = new_sec_addr + db_sec_size(db);
-            } else {
-                db_oldest_addr(db) = 0;
+        /* the oldest sector is always the head of its owner's chain */
+        for (i = 0; i < pool->sec_num; i++) {
+            if (!pool_sec_is_recyclable(pool, i)) {
+                continue;
+            }
+            if (index == POOL_SEC_NONE || pool->sec_table[i].seq < pool->sec_table[index].seq) {
+                index = i;
             }
-            format_sector(db, new_sec_addr);
-            read_sector_info(db, new_sec_addr, &db->cur_sec, false);
         }
-    } else if (sector->status == FDB_SECTOR_STORE_FULL) {
-        /* database full */
-        return FDB_SAVED_FULL;
+        if (index == POOL_SEC_NONE) {
+            return FDB_SAVED_FULL;
+        }
+        pool_unlink(db, index);
+        result = format_sector(db, index * db_sec_size(db));
+        if (result != FDB_NO_ERR) {
+            return result;
+        }
     }
-
-    if (sector->status == FDB_SECTOR_STORE_EMPTY) {
-        /* change the sector to using */
-        sector->status = FDB_SECTOR_STORE_USING;
-        sector->start_time = cur_time;
-        _FDB_WRITE_STATUS(db, sector->addr, status, FDB_SECTOR_STORE_STATUS_NUM, FDB_SECTOR_STORE_USING, true);
-        /* save the start timestamp */
-        FLASH_WRITE(db, sector->addr + SECTOR_START_TIME_OFFSET, (uint32_t *)&cur_time, sizeof(fdb_time_t), true);
+    /* link the sector to the tail of the chain, the owner and sequence number are saved when it's used */
+    sec = &pool->sec_table[index];
+    sec->owner = db->owner;
+    sec->seq = pool->next_seq++;
+    sec->next = POOL_SEC_NONE;
+    if (db->cur_sec.addr != FDB_DATA_UNUSED) {
+        sec->prev = db->cur_sec.addr / db_sec_size(db);
+        pool->sec_table[sec->prev].next = index;
+    } else {
+        sec->prev = POOL_SEC_NONE;
+        db_oldest_addr(db) = index * db_sec_size(db);
     }
+    *addr = index * db_sec_size(db);
 
     return result;
 }
 
-static fdb_err_t tsl_append(fdb_tsdb_t db, fdb_blob_t blob, fdb_time_t *timestamp)
+/*
+ * Load the owner and sequence number of all sectors, then link the sectors of each owner by the sequence number.
+ */
+static fdb_err_t pool_load(fdb_tsdb_t db)
 {
     fdb_err_t result = FDB_NO_ERR;
-    fdb_time_t cur_time = timestamp == NULL ? db->get_time() : *timestamp;
-
-    /* check the append length, MUST less than the db->max_len */
-    if(blob->size > db->max_len)
-    {
-        FDB_INFO("Warning: append length (%" PRIdMAX ") is more than the db->max_len (%" PRIdMAX "). This tsl will be dropped.\n", 
-                (intmax_t)blob->size, (intmax_t)(db->max_len));
-        return FDB_WRITE_ERR;
-    }
-
-    /* check the current timestamp, MUST more than the last save timestamp */
-    if (cur_time <= db->last_time) {
-        FDB_INFO("Warning: current timestamp (%" PRIdMAX ") is less than or equal to the last save timestamp (%" PRIdMAX "). This tsl will be dropped.\n",
-                (intmax_t )cur_time, (intmax_t )(db->last_time));
-        return FDB_WRITE_ERR;
+    fdb_tsdb_pool_t pool = db->pool;
+    struct sector_hdr_data sec_hdr;
+    fdb_sector_store_status_t status;
+    uint32_t i, j, prev, addr;
+
+    pool->sec_num = db_max_size(db) / db_sec_size(db);
+    pool->next_seq = 0;
+    FDB_ASSERT(pool->sec_num <= FDB_TSDB_POOL_SEC_MAX);
+
+    for (i = 0; i < pool->sec_num; i++) {
+        struct fdb_tsdb_pool_sec *sec = &pool->sec_table[i];
+
+        addr = i * db_sec_size(db);
+        _fdb_flash_read((fdb_db_t)db, addr, (uint32_t *)&sec_hdr, sizeof(struct sector_hdr_data));
+        status = (fdb_sector_store_status_t) _fdb_get_status(sec_hdr.status, FDB_SECTOR_STORE_STATUS_NUM);
+        sec->prev = POOL_SEC_NONE;
+        sec->next = POOL_SEC_NONE;
+        if (sec_hdr.magic == SECTOR_MAGIC_WORD && (status == FDB_SECTOR_STORE_USING || status == FDB_SECTOR_STORE_FULL)
+                && sec_hdr.owner != POOL_OWNER_FREE) {
+            sec->owner = sec_hdr.owner;
+            sec->seq = sec_hdr.seq;
+            if (sec->seq >= pool->next_seq) {
+                pool->next_seq = sec->seq + 1;
+            }
+        } else {
+            if (sec_hdr.magic != SECTOR_MAGIC_WORD || status != FDB_SECTOR_STORE_EMPTY
+                    || sec_hdr.owner != POOL_OWNER_FREE || sec_hdr.seq != POOL_OWNER_FREE) {
+                /* the header is incorrect or the power is lost during the sector allocation */
+                FDB_INFO("Sector (0x%08" PRIX32 ") header info is incorrect.\n", addr);
+                if (db->parent.not_formatable) {
+                    return FDB_READ_ERR;
+                }
+                result = format_sector(db, addr);
+                if (result != FDB_NO_ERR) {
+                    return result;
+                }
+            }
+            sec->owner = POOL_OWNER_FREE;
+        }
     }
 
-    result = update_sec_status(db, &db->cur_sec, blob, cur_time);
-    if (result != FDB_NO_ERR) {
-        FDB_INFO("Error: update the sector status failed (%d)", result);
-        return result;
-    }
-    /* write the TSL node */
-    result = write_tsl(db, blob, cur_time);
-    if (result != FDB_NO_ERR) {
-        FDB_INFO("Error: write tsl failed (%d)", result);
-        return result;
+    for (i = 0; i < pool->sec_num; i++) {
+        if (pool->sec_table[i].owner == POOL_OWNER_FREE) {
+            continue;
+        }
+        /* the previous sector has the maximum sequence number which is less than this one */
+        prev = POOL_SEC_NONE;
+        for (j = 0; j < pool->sec_num; j++) {
+            if (pool->sec_table[j].owner == pool->sec_table[i].owner && pool->sec_table[j].seq < pool->sec_table[i].seq
+                    && (prev == POOL_SEC_NONE || pool->sec_table[j].seq > pool->sec_table[prev].seq)) {
+                prev = j;
+            }
+        }
+        pool->sec_table[i].prev = prev;
+        if (prev != POOL_SEC_NONE) {
+            pool->sec_table[prev].next = i;
+        }
     }
-
-    /* recalculate the current using sector info */
-    db->cur_sec.end_idx = db->cur_sec.empty_idx;
-    db->cur_sec.end_time = cur_time;
-    db->cur_sec.empty_idx += LOG_IDX_DATA_SIZE;
-    db->cur_sec.empty_data -= FDB_WG_ALIGN(blob->size);
-    db->cur_sec.remain -= LOG_IDX_DATA_SIZE + FDB_WG_ALIGN(blob->size);
-    db->last_time = cur_time;
+    pool->loaded = true;
 
     return result;
 }
 
-/**
- * Append a new log to TSDB.
- *
- * @param db database object
- * @param blob log blob data
- *
- * @return result
+/*
+ * Attach the TSDB to the pool, the oldest sector is the head of its chain and the current using sector is the tail.
  */
-fdb_err_t fdb_tsl_append(fdb_tsdb_t db, fdb_blob_t blob)
+static fdb_err_t pool_attach(fdb_tsdb_t db)
 {
     fdb_err_t result = FDB_NO_ERR;
+    fdb_tsdb_pool_t pool = db->pool;
+    uint32_t i, head = POOL_SEC_NONE, tail = POOL_SEC_NONE, addr;
+
+    db->owner = fdb_calc_crc32(0, db_name(db), strlen(db_name(db)));
+    FDB_ASSERT(db->owner != POOL_OWNER_FREE);
+    pool_lock(pool);
+    if (!pool->loaded) {
+        result = pool_load(db);
+        if (result != FDB_NO_ERR) {
+            goto __exit;
+        }
+    }
+    /* all TSDBs in the pool MUST use the same partition and sector size */
+    FDB_ASSERT(pool->sec_num == db_max_size(db) / db_sec_size(db));
+    FDB_ASSERT(pool_find_db(pool, db->owner) == NULL);
+    for (i = 0; i < FDB_TSDB_POOL_DB_MAX; i++) {
+        if (pool->db_table[i] == NULL) {
+            pool->db_table[i] = db;
+            break;
+        }
+    }
+    if (i == FDB_TSDB_POOL_DB_MAX) {
+        FDB_INFO("Error: the TSDB number is more than FDB_TSDB_POOL_DB_MAX.\n");
+        result = FDB_INIT_FAILED;
+        goto __exit;
+    }
 
-    if (!db_init_ok(db)) {
-        FDB_INFO("Error: TSL (%s) isn't initialize OK.\n", db_name(db));
-        return FDB_INIT_FAILED;
+    for (i = 0; i < pool->sec_num; i++) {
+        if (pool->sec_table[i].owner == db->owner) {
+            if (pool->sec_table[i].prev == POOL_SEC_NONE) {
+                head = i;
+            }
+            if (pool->sec_table[i].next == POOL_SEC_NONE) {
+                tail = i;
+            }
+        }
+    }
+    if (tail != POOL_SEC_NONE) {
+        db_oldest_addr(db) = head * db_sec_size(db);
+        db->cur_sec.addr = tail * db_sec_size(db);
+        read_sector_info(db, db->cur_sec.addr, &db->cur_sec, true);
+        if (db->cur_sec.status != FDB_SECTOR_STORE_EMPTY) {
+            db->last_time = db->cur_sec.end_time;
+        } else if (pool->sec_table[tail].prev != POOL_SEC_NONE) {
+            struct tsdb_sec_info sec;
+
+            read_sector_info(db, pool->sec_table[tail].prev * db_sec_size(db), &sec, false);
+            db->last_time = sec.end_time;
+        }
+    }
+    if (tail == POOL_SEC_NONE || db->cur_sec.status == FDB_SECTOR_STORE_FULL) {
+        /* the empty sector will be the current using sector */
+        result = pool_alloc_sector(db, &addr);
+        if (result == FDB_SAVED_FULL && tail != POOL_SEC_NONE) {
+            /* the TSDB is full when not rollover */
+            result = FDB_NO_ERR;
+        } else if (result != FDB_NO_ERR) {
+            goto __exit;
+        } else {
+            db->cur_sec.addr = addr;
+            read_sector_info(db, db->cur_sec.addr, &db->cur_sec, false);
+        }
     }
+    FDB_DEBUG("TSDB (%s) oldest sectors is 0x%08" PRIX32 ", current using sector is 0x%08" PRIX32 " in the pool.\n", db_name(db),
+            db_oldest_addr(db), db->cur_sec.addr);
 
-    db_lock(db);
-    result = tsl_append(db, blob, NULL);
-    db_unlock(db);
+__exit:
+    pool_unlock(pool);
 
     return result;
 }
 
-/**
- * Append a new log to TSDB with specific timestamp.
- *
- * @param db database object
- * @param blob log blob data
- *
- * @return result
- */
-fdb_err_t fdb_tsl_append_with_ts(fdb_tsdb_t db, fdb_blob_t blob, fdb_time_t timestamp)
+static void pool_detach(fdb_tsdb_t db)
 {
-    fdb_err_t result = FDB_NO_ERR;
+    size_t i;
 
-    if (!db_init_ok(db)) {
-        FDB_INFO("Error: TSL (%s) isn't initialize OK.\n", db_name(db));
-        return FDB_INIT_FAILED;
+    pool_lock(db->pool);
+    for (i = 0; i < FDB_TSDB_POOL_DB_MAX; i++) {
+        if (db->pool->db_table[i] == db) {
+            db->pool->db_table[i] = NULL;
+        }
+    }
+    pool_unlock(db->pool);
+}
+
+/*
+ * Release all sectors of the TSDB to the pool, then allocate a new current using sector.
+ */
+static void pool_format_all(fdb_tsdb_t db)
+{
+    fdb_tsdb_pool_t pool = db->pool;
+    uint32_t i;
+
+    pool_lock(pool);
+    for (i = 0; i < pool->sec_num; i++) {
+        if (pool->sec_table[i].owner == db->owner) {
+            pool->sec_table[i].owner = POOL_OWNER_FREE;
+            pool->sec_table[i].prev = POOL_SEC_NONE;
+            pool->sec_table[i].next = POOL_SEC_NONE;
+            format_sector(db, i * db_sec_size(db));
+        }
+    }
+    db->cur_sec.addr = FDB_DATA_UNUSED;
+    /* there is a free sector at least */
+    pool_alloc_sector(db, &db->cur_sec.addr);
+    pool_unlock(pool);
+}
+#endif /* FDB_TSDB_USING_SECTOR_POOL */
+
+#ifdef FDB_TSDB_USING_ARCHIVE
+/*
+ * Compress the block raw data and append it to the archive file.
+ */
+static fdb_err_t arc_flush(fdb_tsdb_t db, struct arc_builder *builder)
+{
+    fdb_err_t result = FDB_NO_ERR;
+    struct arc_blk_hdr hdr;
+    uint8_t *payload = db->arc_comp_buf + ARC_BLK_HDR_SIZE;
+    uint32_t idx_len = builder->count * ARC_TSL_IDX_SIZE, blk_len;
+
+    if (builder->count == 0) {
+        return result;
+    }
+    /* move the TSL data to the end of indexes */
+    memmove(db->arc_buf + idx_len, db->arc_buf + builder->data_pos, FDB_TSDB_ARC_BLOCK_SIZE - builder->data_pos);
+    hdr.magic = ARC_BLK_MAGIC_WORD;
+    hdr.count = builder->count;
+    hdr.start_time = builder->start_time;
+    hdr.end_time = builder->end_time;
+    hdr.raw_len = idx_len + FDB_TSDB_ARC_BLOCK_SIZE - builder->data_pos;
+    hdr.comp_len = _fdb_lz_compress(db->arc_buf, hdr.raw_len, payload, hdr.raw_len - 1);
+    if (hdr.comp_len == 0) {
+        /* the raw data is saved when it can't be compressed */
+        memcpy(payload, db->arc_buf, hdr.raw_len);
+        hdr.comp_len = hdr.raw_len;
+    }
+    hdr.crc32 = fdb_calc_crc32(0, payload, hdr.comp_len);
+    memcpy(db->arc_comp_buf, &hdr, ARC_BLK_HDR_SIZE);
+    blk_len = ARC_BLK_HDR_SIZE + hdr.comp_len + ARC_BLK_TAIL_SIZE;
+    memcpy(payload + hdr.comp_len, &blk_len, ARC_BLK_TAIL_SIZE);
+    /* append the block by one write */
+    result = _fdb_file_ext_write(db->arc_file, db->arc_size, db->arc_comp_buf, blk_len);
+    if (result != FDB_NO_ERR) {
+        /* drop the unfinished block */
+        _fdb_file_ext_truncate(db->arc_file, db->arc_size);
+        return result;
+    }
+    db->arc_size += blk_len;
+    db->arc_end_time = builder->end_time;
+    builder->count = 0;
+    builder->data_pos = FDB_TSDB_ARC_BLOCK_SIZE;
+
+    return result;
+}
+
+/*
+ * Archive all TSL of the sector before it's recycled, the deleted TSL is dropped.
+ */
+static fdb_err_t arc_sector(fdb_tsdb_t db, uint32_t addr)
+{
+    fdb_err_t result = FDB_NO_ERR;
+    struct tsdb_sec_info sector;
+    struct arc_builder builder = { 0, FDB_TSDB_ARC_BLOCK_SIZE, 0, 0 };
+    struct arc_tsl_idx idx;
+    struct fdb_tsl tsl;
+
+    /* the block is built in the archive raw data buffer */
+    db->arc_blk_addr = FAILED_ADDR;
+    if (read_sector_info(db, addr, &sector, true) != FDB_NO_ERR
+            || (sector.status != FDB_SECTOR_STORE_USING && sector.status != FDB_SECTOR_STORE_FULL)) {
+        return result;
+    }
+    for (tsl.addr.index = sector.addr + SECTOR_HDR_DATA_SIZE; tsl.addr.index <= sector.end_idx; tsl.addr.index += LOG_IDX_DATA_SIZE) {
+        read_tsl(db, &sector, &tsl);
+        /* the TSL which is older than archive end time was archived before power lost */
+        if (tsl.status == FDB_TSL_UNUSED || tsl.status == FDB_TSL_PRE_WRITE || tsl.status == FDB_TSL_DELETED
+                || tsl.time <= db->arc_end_time) {
+            continue;
+        }
+        if ((builder.count + 1) * ARC_TSL_IDX_SIZE + tsl.log_len > builder.data_pos) {
+            result = arc_flush(db, &builder);
+            if (result != FDB_NO_ERR) {
+                return result;
+            }
+        }
+        if (builder.count == 0) {
+            builder.start_time = builder.end_time = tsl.time;
+        }
+        idx.time_delta = tsl.time - builder.end_time;
+        idx.log_len = tsl.log_len;
+        idx.status = tsl.status;
+        builder.data_pos -= tsl.log_len;
+        _fdb_flash_read((fdb_db_t)db, tsl.addr.log, db->arc_buf + builder.data_pos, tsl.log_len);
+        memcpy(db->arc_buf + builder.count * ARC_TSL_IDX_SIZE, &idx, ARC_TSL_IDX_SIZE);
+        builder.count++;
+        builder.end_time = tsl.time;
+    }
+
+    return arc_flush(db, &builder);
+}
+
+/*
+ * Read the header of the block which is end at the offset.
+ */
+static fdb_err_t arc_read_last_blk_hdr(fdb_tsdb_t db, uint32_t end, uint32_t *blk_addr, struct arc_blk_hdr *hdr)
+{
+    uint32_t blk_len;
+
+    if (end < ARC_BLK_HDR_SIZE + ARC_BLK_TAIL_SIZE
+            || _fdb_file_ext_read(db->arc_file, end - ARC_BLK_TAIL_SIZE, &blk_len, ARC_BLK_TAIL_SIZE) != FDB_NO_ERR
+            || blk_len < ARC_BLK_HDR_SIZE + ARC_BLK_TAIL_SIZE || blk_len > end
+            || _fdb_file_ext_read(db->arc_file, end - blk_len, hdr, ARC_BLK_HDR_SIZE) != FDB_NO_ERR
+            || hdr->magic != ARC_BLK_MAGIC_WORD || ARC_BLK_HDR_SIZE + hdr->comp_len + ARC_BLK_TAIL_SIZE != blk_len) {
+        return FDB_READ_ERR;
+    }
+    *blk_addr = end - blk_len;
+
+    return FDB_NO_ERR;
+}
+
+/*
+ * Read the block payload and decompress it to the archive raw data buffer.
+ */
+static fdb_err_t arc_read_blk(fdb_tsdb_t db, uint32_t blk_addr, struct arc_blk_hdr *hdr)
+{
+    uint8_t *payload = hdr->comp_len == hdr->raw_len ? db->arc_buf : db->arc_comp_buf;
+
+    if (hdr->raw_len > FDB_TSDB_ARC_BLOCK_SIZE || hdr->comp_len > hdr->raw_len
+            || _fdb_file_ext_read(db->arc_file, blk_addr + ARC_BLK_HDR_SIZE, payload, hdr->comp_len) != FDB_NO_ERR
+            || fdb_calc_crc32(0, payload, hdr->comp_len) != hdr->crc32) {
+        FDB_INFO("Error: the archive block (0x%08" PRIX32 ") is broken.\n", blk_addr);
+        return FDB_READ_ERR;
+    }
+    if (payload != db->arc_buf && _fdb_lz_decompress(payload, hdr->comp_len, db->arc_buf, hdr->raw_len) != hdr->raw_len) {
+        FDB_INFO("Error: the archive block (0x%08" PRIX32 ") decompress failed.\n", blk_addr);
+        return FDB_READ_ERR;
+    }
+
+    return FDB_NO_ERR;
+}
+
+/*
+ * Open the archive file and find the archive end. The broken block at the file end is dropped.
+ */
+static fdb_err_t arc_load(fdb_tsdb_t db)
+{
+    struct arc_blk_hdr hdr;
+    uint32_t file_size, addr, blk_len;
+
+    FDB_ASSERT(ARC_BLK_HDR_SIZE + ARC_BLK_TAIL_SIZE <= sizeof(db->arc_comp_buf) - sizeof(db->arc_buf));
+
+    db->arc_size = 0;
+    db->arc_end_time = 0;
+    db->arc_blk_addr = FAILED_ADDR;
+    db->arc_file = _fdb_file_ext_open((fdb_db_t)db, "arc", &file_size);
+    if (db->arc_file < 0) {
+        return FDB_INIT_FAILED;
+    }
+    /* the last block is checked only when the archive file is good */
+    if (file_size == 0 || arc_read_last_blk_hdr(db, file_size, &addr, &hdr) == FDB_NO_ERR) {
+        db->arc_size = file_size;
+        db->arc_end_time = file_size ? hdr.end_time : 0;
+        return FDB_NO_ERR;
+    }
+    for (addr = 0; addr + ARC_BLK_HDR_SIZE + ARC_BLK_TAIL_SIZE <= file_size; addr += blk_len) {
+        if (_fdb_file_ext_read(db->arc_file, addr, &hdr, ARC_BLK_HDR_SIZE) != FDB_NO_ERR || hdr.magic != ARC_BLK_MAGIC_WORD) {
+            break;
+        }
+        blk_len = ARC_BLK_HDR_SIZE + hdr.comp_len + ARC_BLK_TAIL_SIZE;
+        if (arc_read_last_blk_hdr(db, addr + blk_len, &addr, &hdr) != FDB_NO_ERR) {
+            break;
+        }
+        db->arc_end_time = hdr.end_time;
+    }
+    FDB_INFO("Warning: the archive file is broken at 0x%08" PRIX32 ", the data after it will be dropped.\n", addr);
+    db->arc_size = addr;
+
+    return _fdb_file_ext_truncate(db->arc_file, addr);
+}
+
+/*
+ * Load the block to the archive raw data buffer when it's not there.
+ * The buffer is shared by the appender and the iterators, so it MUST be used with the lock held.
+ */
+static fdb_err_t arc_load_blk(fdb_tsdb_t db, uint32_t blk_addr)
+{
+    struct arc_blk_hdr hdr;
+
+    if (db->arc_blk_addr == blk_addr) {
+        return FDB_NO_ERR;
+    }
+    db->arc_blk_addr = FAILED_ADDR;
+    if (_fdb_file_ext_read(db->arc_file, blk_addr, &hdr, ARC_BLK_HDR_SIZE) != FDB_NO_ERR || hdr.magic != ARC_BLK_MAGIC_WORD
+            || arc_read_blk(db, blk_addr, &hdr) != FDB_NO_ERR) {
+        return FDB_READ_ERR;
+    }
+    db->arc_blk_addr = blk_addr;
+
+    return FDB_NO_ERR;
+}
+
+/*
+ * The TSL in the sector which is archived before power lost is skipped, it's iterated in the archive.
+ */
+static bool arc_has_tsl(tsdb_snapshot_t snap, fdb_tsl_t tsl)
+{
+    return snap->arc_size && tsl->time <= snap->arc_end_time && tsl->status != FDB_TSL_UNUSED
+            && tsl->status != FDB_TSL_PRE_WRITE && tsl->status != FDB_TSL_DELETED;
+}
+
+size_t _fdb_tsl_arc_blob_read(fdb_db_t db, fdb_blob_t blob, size_t offset, size_t len)
+{
+    fdb_tsdb_t tsdb = (fdb_tsdb_t)db;
+    /* the iterator which is NOT in snapshot read mode holds the lock in the callback */
+    bool locked = tsdb->arc_locked > 0;
+
+    if (blob->saved.addr + offset + len > FDB_TSDB_ARC_BLOCK_SIZE) {
+        return 0;
+    }
+    if (!locked) {
+        db_lock(db);
+    }
+    if (arc_load_blk(tsdb, blob->saved.meta_addr & ~FDB_TSL_ARC_INDEX) == FDB_NO_ERR) {
+        memcpy(blob->buf, tsdb->arc_buf + blob->saved.addr + offset, len);
+    } else {
+        len = 0;
+    }
+    if (!locked) {
+        db_unlock(db);
+    }
+
+    return len;
+}
+#endif /* FDB_TSDB_USING_ARCHIVE */
+
+static fdb_err_t write_tsl(fdb_tsdb_t db, fdb_blob_t blob, fdb_time_t time)
+{
+    fdb_err_t result = FDB_NO_ERR;
+    struct log_idx_data idx;
+    uint32_t idx_addr = db->cur_sec.empty_idx;
+
+    idx.log_len = blob->size;
+#ifdef FDB_TSDB_USING_TIME_DELTA
+    idx.time_delta = (uint32_t)(time - db->cur_sec.start_time);
+#else
+    idx.time = time;
+#endif
+    idx.log_addr = db->cur_sec.empty_data - FDB_WG_ALIGN(idx.log_len);
+    /* write the status will by write granularity */
+    _FDB_WRITE_STATUS(db, idx_addr, idx.status_table, FDB_TSL_STATUS_NUM, FDB_TSL_PRE_WRITE, false);
+    /* write other index info */
+    FLASH_WRITE(db, idx_addr + LOG_IDX_TS_OFFSET, (uint8_t *)&idx + LOG_IDX_TS_OFFSET, sizeof(struct log_idx_data) - LOG_IDX_TS_OFFSET, false);
+    /* write blob data */
+    FLASH_WRITE(db, idx.log_addr, blob->buf, blob->size, false);
+    /* write the status will by write granularity */
+    _FDB_WRITE_STATUS(db, idx_addr, idx.status_table, FDB_TSL_STATUS_NUM, FDB_TSL_WRITE, true);
+
+    return result;
+}
+
+static bool sector_is_full(tsdb_sec_info_t sector, fdb_blob_t blob, fdb_time_t cur_time)
+{
+    if (sector->remain < LOG_IDX_DATA_SIZE + FDB_WG_ALIGN(blob->size)) {
+        return true;
+    }
+#ifdef FDB_TSDB_USING_TIME_DELTA
+    /* the timestamp delta is out of the index range */
+    if (cur_time - sector->start_time > (fdb_time_t)TSL_TIME_DELTA_MAX) {
+        return true;
+    }
+#else
+    (void)cur_time;
+#endif
+
+    return false;
+}
+
+static fdb_err_t update_sec_status(fdb_tsdb_t db, tsdb_sec_info_t sector, fdb_blob_t blob, fdb_time_t cur_time)
+{
+    fdb_err_t result = FDB_NO_ERR;
+    uint8_t status[FDB_STORE_STATUS_TABLE_SIZE];
+
+    if (sector->status == FDB_SECTOR_STORE_USING && sector_is_full(sector, blob, cur_time)) {
+        uint8_t end_status[TSL_STATUS_TABLE_SIZE];
+        uint32_t end_index = sector->empty_idx - LOG_IDX_DATA_SIZE, new_sec_addr, cur_sec_addr = sector->addr;
+        /* save the end node index and timestamp */
+        if (sector->end_info_stat[0] == FDB_TSL_UNUSED) {
+            _FDB_WRITE_STATUS(db, cur_sec_addr + SECTOR_END0_STATUS_OFFSET, end_status, FDB_TSL_STATUS_NUM, FDB_TSL_PRE_WRITE, false);
+            FLASH_WRITE(db, cur_sec_addr + SECTOR_END0_TIME_OFFSET, (uint32_t * )&db->last_time, sizeof(fdb_time_t), false);
+            FLASH_WRITE(db, cur_sec_addr + SECTOR_END0_IDX_OFFSET, &end_index, sizeof(end_index), false);
+            _FDB_WRITE_STATUS(db, cur_sec_addr + SECTOR_END0_STATUS_OFFSET, end_status, FDB_TSL_STATUS_NUM, FDB_TSL_WRITE, true);
+        } else if (sector->end_info_stat[1] == FDB_TSL_UNUSED) {
+            _FDB_WRITE_STATUS(db, cur_sec_addr + SECTOR_END1_STATUS_OFFSET, end_status, FDB_TSL_STATUS_NUM, FDB_TSL_PRE_WRITE, false);
+            FLASH_WRITE(db, cur_sec_addr + SECTOR_END1_TIME_OFFSET, (uint32_t * )&db->last_time, sizeof(fdb_time_t), false);
+            FLASH_WRITE(db, cur_sec_addr + SECTOR_END1_IDX_OFFSET, &end_index, sizeof(end_index), false);
+            _FDB_WRITE_STATUS(db, cur_sec_addr + SECTOR_END1_STATUS_OFFSET, end_status, FDB_TSL_STATUS_NUM, FDB_TSL_WRITE, true);
+        }
+        /* change current sector to full */
+        _FDB_WRITE_STATUS(db, cur_sec_addr, status, FDB_SECTOR_STORE_STATUS_NUM, FDB_SECTOR_STORE_FULL, true);
+        sector->status = FDB_SECTOR_STORE_FULL;
+        /* calculate next sector address */
+#ifdef FDB_TSDB_USING_SECTOR_POOL
+        if (db->pool) {
+            /* the sector from the pool is always empty */
+            pool_lock(db->pool);
+            result = pool_alloc_sector(db, &new_sec_addr);
+            pool_unlock(db->pool);
+            if (result != FDB_NO_ERR) {
+                return result;
+            }
+        } else
+#endif
+        if (sector->addr + db_sec_size(db) < db_max_size(db)) {
+            new_sec_addr = sector->addr + db_sec_size(db);
+        }
+        else if (db->rollover) {
+            new_sec_addr = 0;
+        } else {
+            /* not rollover */
+            return FDB_SAVED_FULL;
+        }
+        read_sector_info(db, new_sec_addr, &db->cur_sec, false);
+        if (sector->status != FDB_SECTOR_STORE_EMPTY) {
+            /* calculate the oldest sector address */
+            if (new_sec_addr + db_sec_size(db) < db_max_size(db)) {
+                db_oldest_addr(db) = new_sec_addr + db_sec_size(db);
+            } else {
+                db_oldest_addr(db) = 0;
+            }
+#ifdef FDB_TSDB_USING_ARCHIVE
+            if (db->archive && arc_sector(db, new_sec_addr) != FDB_NO_ERR) {
+                FDB_INFO("Warning: archive the sector (0x%08" PRIX32 ") failed, its TSL will be lost.\n", new_sec_addr);
+            }
+#endif
+            /* notify the snapshot iterator before the oldest sector is recycled */
+            db->recycled_num++;
+            format_sector(db, new_sec_addr);
+            read_sector_info(db, new_sec_addr, &db->cur_sec, false);
+        }
+    } else if (sector->status == FDB_SECTOR_STORE_FULL) {
+        /* database full */
+        return FDB_SAVED_FULL;
+    }
+
+    if (sector->status == FDB_SECTOR_STORE_EMPTY) {
+        /* change the sector to using */
+        sector->status = FDB_SECTOR_STORE_USING;
+        sector->start_time = cur_time;
+#ifdef FDB_TSDB_USING_SECTOR_POOL
+        if (db->pool) {
+            /* save the owner before using, the sector is recycled at next boot when power lost during it */
+            struct fdb_tsdb_pool_sec *sec = pool_sec(db, sector->addr);
+            FLASH_WRITE(db, sector->addr + SECTOR_OWNER_OFFSET, &sec->owner, sizeof(sec->owner), false);
+            FLASH_WRITE(db, sector->addr + SECTOR_SEQ_OFFSET, &sec->seq, sizeof(sec->seq), true);
+        }
+#endif
+        _FDB_WRITE_STATUS(db, sector->addr, status, FDB_SECTOR_STORE_STATUS_NUM, FDB_SECTOR_STORE_USING, true);
+        /* save the start timestamp */
+        FLASH_WRITE(db, sector->addr + SECTOR_START_TIME_OFFSET, (uint32_t *)&cur_time, sizeof(fdb_time_t), true);
+    }
+
+    return result;
+}
+
+/*
+ * Notify the subscribers and wake up the waiters after the new TSL is committed. It's called with the database locked,
+ * so the TSL is NOT recycled by the other appender before the subscriber reads it.
+ */
+static void tsl_publish(fdb_tsdb_t db, fdb_tsl_t tsl)
+{
+    size_t i;
+
+    for (i = 0; i < FDB_TSL_SUB_MAX; i++) {
+        /* the subscription is canceled when callback return true */
+        if (db->sub[i].cb && db->sub[i].cb(tsl, db->sub[i].arg)) {
+            db->sub[i].cb = NULL;
+        }
+    }
+    if (db->notify) {
+        db->notify((fdb_db_t)db);
+    }
+}
+
+static fdb_err_t tsl_append(fdb_tsdb_t db, fdb_blob_t blob, fdb_time_t *timestamp)
+{
+    fdb_err_t result = FDB_NO_ERR;
+    struct fdb_tsl tsl;
+    fdb_time_t cur_time = timestamp == NULL ? db->get_time() : *timestamp;
+
+    /* check the append length, MUST less than the db->max_len */
+    if(blob->size > db->max_len)
+    {
+        FDB_INFO("Warning: append length (%" PRIdMAX ") is more than the db->max_len (%" PRIdMAX "). This tsl will be dropped.\n", 
+                (intmax_t)blob->size, (intmax_t)(db->max_len));
+        return FDB_WRITE_ERR;
+    }
+
+    /* check the current timestamp, MUST more than the last save timestamp */
+    if (cur_time <= db->last_time) {
+        FDB_INFO("Warning: current timestamp (%" PRIdMAX ") is less than or equal to the last save timestamp (%" PRIdMAX "). This tsl will be dropped.\n",
+                (intmax_t )cur_time, (intmax_t )(db->last_time));
+        return FDB_WRITE_ERR;
+    }
+
+    result = update_sec_status(db, &db->cur_sec, blob, cur_time);
+    if (result != FDB_NO_ERR) {
+        FDB_INFO("Error: update the sector status failed (%d)", result);
+        return result;
+    }
+    /* write the TSL node */
+    result = write_tsl(db, blob, cur_time);
+    if (result != FDB_NO_ERR) {
+        FDB_INFO("Error: write tsl failed (%d)", result);
+        return result;
+    }
+
+    tsl.status = FDB_TSL_WRITE;
+    tsl.time = cur_time;
+    tsl.log_len = blob->size;
+    tsl.addr.index = db->cur_sec.empty_idx;
+    tsl.addr.log = db->cur_sec.empty_data - FDB_WG_ALIGN(blob->size);
+    tsl.sec_gen = get_sec_gen(db, db->cur_sec.addr);
+
+    /* recalculate the current using sector info */
+    db->cur_sec.end_idx = db->cur_sec.empty_idx;
+    db->cur_sec.end_time = cur_time;
+    db->cur_sec.empty_idx += LOG_IDX_DATA_SIZE;
+    db->cur_sec.empty_data -= FDB_WG_ALIGN(blob->size);
+    db->cur_sec.remain -= LOG_IDX_DATA_SIZE + FDB_WG_ALIGN(blob->size);
+    db->last_time = cur_time;
+    tsl_publish(db, &tsl);
+
+    return result;
+}
+
+/**
+ * Append a new log to TSDB.
+ *
+ * @param db database object
+ * @param blob log blob data
+ *
+ * @return result
+ */
+fdb_err_t fdb_tsl_append(fdb_tsdb_t db, fdb_blob_t blob)
+{
+    fdb_err_t result = FDB_NO_ERR;
+
+    if (!db_init_ok(db)) {
+        FDB_INFO("Error: TSL (%s) isn't initialize OK.\n", db_name(db));
+        return FDB_INIT_FAILED;
+    }
+
+    db_lock(db);
+    result = tsl_append(db, blob, NULL);
+    db_unlock(db);
+
+    return result;
+}
+
+/**
+ * Append a new log to TSDB with specific timestamp.
+ *
+ * @param db database object
+ * @param blob log blob data
+ *
+ * @return result
+ */
+fdb_err_t fdb_tsl_append_with_ts(fdb_tsdb_t db, fdb_blob_t blob, fdb_time_t timestamp)
+{
+    fdb_err_t result = FDB_NO_ERR;
+
+    if (!db_init_ok(db)) {
+        FDB_INFO("Error: TSL (%s) isn't initialize OK.\n", db_name(db));
+        return FDB_INIT_FAILED;
+    }
+
+    db_lock(db);
+    result = tsl_append(db, blob, &timestamp);
+    db_unlock(db);
+
+    return result;
+}
+
+/**
+ * Subscribe the new TSL of TSDB. The callback is called with the database locked after the new TSL is committed,
+ * so it MUST NOT append TSL. The subscription is canceled when the callback return true.
+ *
+ * @param db database object
+ * @param cb callback
+ * @param arg callback argument
+ *
+ * @return result, FDB_SAVED_FULL: the subscribers number is more than FDB_TSL_SUB_MAX
+ */
+fdb_err_t fdb_tsl_subscribe(fdb_tsdb_t db, fdb_tsl_cb cb, void *arg)
+{
+    fdb_err_t result = FDB_SAVED_FULL;
+    size_t i;
+
+    FDB_ASSERT(cb);
+
+    db_lock(db);
+    for (i = 0; i < FDB_TSL_SUB_MAX; i++) {
+        if (db->sub[i].cb == NULL) {
+            db->sub[i].cb = cb;
+            db->sub[i].arg = arg;
+            result = FDB_NO_ERR;
+            break;
+        }
+    }
+    db_unlock(db);
+
+    return result;
+}
+
+/**
+ * Cancel the subscription of the new TSL.
+ *
+ * @param db database object
+ * @param cb callback
+ * @param arg callback argument
+ *
+ * @return result, FDB_READ_ERR: the subscription is not found
+ */
+fdb_err_t fdb_tsl_unsubscribe(fdb_tsdb_t db, fdb_tsl_cb cb, void *arg)
+{
+    fdb_err_t result = FDB_READ_ERR;
+    size_t i;
+
+    db_lock(db);
+    for (i = 0; i < FDB_TSL_SUB_MAX; i++) {
+        if (db->sub[i].cb == cb && db->sub[i].arg == arg) {
+            db->sub[i].cb = NULL;
+            result = FDB_NO_ERR;
+            break;
+        }
+    }
+    db_unlock(db);
+
+    return result;
+}
+
+/**
+ * Wait for the TSL which is newer than the last timestamp.
+ * It returns at once when the wait function is not set, @see FDB_TSDB_CTRL_SET_WAIT
+ *
+ * @param db database object
+ * @param last_time the last timestamp which is read by the caller
+ * @param timeout the total timeout, the wait function updates it to the remaining time after each wakeup
+ *
+ * @return true: there is newer TSL, false: timeout
+ */
+bool fdb_tsl_wait_newer(fdb_tsdb_t db, fdb_time_t last_time, int32_t timeout)
+{
+    bool newer;
+
+    if (!db_init_ok(db)) {
+        FDB_INFO("Error: TSL (%s) isn't initialize OK.\n", db_name(db));
+        return false;
+    }
+
+    db_lock(db);
+    /* the wait function unlocks the database when waiting, so the condition is checked again after wakeup,
+     * and the next wait only has the remaining time */
+    while (!(newer = db->last_time > last_time) && db->wait) {
+        if (!db->wait((fdb_db_t)db, &timeout)) {
+            newer = db->last_time > last_time;
+            break;
+        }
+    }
+    db_unlock(db);
+
+    return newer;
+}
+
+/*
+ * Capture the snapshot and lock the database for the iterator.
+ * The database is unlocked at once in snapshot read mode, the appender only writes after the snapshot end.
+ */
+static void iter_lock(fdb_tsdb_t db, tsdb_snapshot_t snap)
+{
+    db_lock(db);
+#ifdef FDB_TSDB_USING_SECTOR_POOL
+    if (db->pool) {
+        uint32_t head_addr;
+
+        pool_lock(db->pool);
+        /* the oldest sectors maybe recycled by other TSDBs in the pool */
+        if ((head_addr = pool_head_addr(db)) != FAILED_ADDR) {
+            db_oldest_addr(db) = head_addr;
+        }
+        snap->cur_seq = pool_sec(db, db->cur_sec.addr)->seq;
+        pool_unlock(db->pool);
+    }
+#endif
+    snap->locked = !db->snapshot_read;
+#ifdef FDB_TSDB_USING_ARCHIVE
+    if (snap->locked) {
+        db->arc_locked++;
+    }
+#endif
+    snap->oldest_addr = db_oldest_addr(db);
+    snap->cur_sec = db->cur_sec;
+    snap->recycled_num = db->recycled_num;
+#ifdef FDB_TSDB_USING_ARCHIVE
+    snap->arc_size = db->arc_size;
+    snap->arc_end_time = db->arc_end_time;
+#endif
+    if (!snap->locked) {
+        db_unlock(db);
+    }
+}
+
+static void iter_unlock(fdb_tsdb_t db, tsdb_snapshot_t snap)
+{
+    if (snap->locked) {
+#ifdef FDB_TSDB_USING_ARCHIVE
+        db->arc_locked--;
+#endif
+        db_unlock(db);
+    }
+}
+
+/*
+ * Check the sector is still in the snapshot.
+ * The appender recycles the sectors from the oldest, so the first N sectors of the snapshot are invalid
+ * after N sectors recycled, and the sectors after the snapshot current sector are newer than the snapshot.
+ */
+static bool snapshot_has_sector(fdb_tsdb_t db, tsdb_snapshot_t snap, uint32_t sec_addr)
+{
+    uint32_t pos, cur_pos, recycled_num;
+
+#ifdef FDB_TSDB_USING_SECTOR_POOL
+    if (db->pool) {
+        /* the recycled sector is owned by other TSDB, or allocated again with a newer sequence number.
+         * Other TSDBs recycle the sectors without this TSDB lock, so it's checked even when locked. */
+        struct fdb_tsdb_pool_sec *sec = pool_sec(db, sec_addr);
+        bool has_sector;
+
+        pool_lock(db->pool);
+        has_sector = sec->owner == db->owner && sec->seq <= snap->cur_seq;
+        pool_unlock(db->pool);
+
+        return has_sector;
+    }
+#endif
+    if (snap->locked) {
+        return true;
+    }
+    recycled_num = db->recycled_num - snap->recycled_num;
+    pos = (sec_addr + db_max_size(db) - snap->oldest_addr) % db_max_size(db) / db_sec_size(db);
+    cur_pos = (snap->cur_sec.addr + db_max_size(db) - snap->oldest_addr) % db_max_size(db) / db_sec_size(db);
+
+    return pos >= recycled_num && pos <= cur_pos;
+}
+
+/*
+ * Get the sector generation for the TSL read. It's the sector sequence number in the pool, otherwise it's the recycled
+ * sectors number, and the sectors are recycled from the oldest one by one.
+ */
+static uint32_t get_sec_gen(fdb_tsdb_t db, uint32_t sec_addr)
+{
+#ifdef FDB_TSDB_USING_SECTOR_POOL
+    if (db->pool) {
+        return pool_sec(db, sec_addr)->seq;
+    }
+#endif
+    (void)sec_addr;
+
+    return db->recycled_num;
+}
+
+/**
+ * Check the sector of the TSL blob is NOT recycled after the TSL is read, it's called after the blob data is read.
+ * The appender recycles the sectors without the iterator lock in snapshot read mode or by other TSDBs in the pool.
+ *
+ * @param db database object
+ * @param blob the TSL blob
+ *
+ * @return true: the blob data is valid
+ */
+bool _fdb_tsl_blob_check(fdb_db_t db, fdb_blob_t blob)
+{
+    fdb_tsdb_t tsdb = (fdb_tsdb_t)db;
+    uint32_t sec_addr = FDB_ALIGN_DOWN(blob->saved.addr, db_sec_size(tsdb)), recycled_num, pos, sec_num;
+
+#ifdef FDB_TSDB_USING_SECTOR_POOL
+    if (tsdb->pool) {
+        struct fdb_tsdb_pool_sec *sec = pool_sec(tsdb, sec_addr);
+        bool valid;
+
+        pool_lock(tsdb->pool);
+        valid = sec->owner == tsdb->owner && sec->seq == blob->saved.sec_gen;
+        pool_unlock(tsdb->pool);
+
+        return valid;
+    }
+#endif
+    if (!tsdb->snapshot_read || (recycled_num = tsdb->recycled_num - blob->saved.sec_gen) == 0) {
+        return true;
+    }
+    /* the recycled sectors are the newest sectors now */
+    sec_num = db_max_size(tsdb) / db_sec_size(tsdb);
+    pos = (sec_addr + db_max_size(tsdb) - db_oldest_addr(tsdb)) % db_max_size(tsdb) / db_sec_size(tsdb);
+
+    return recycled_num < sec_num && pos < sec_num - recycled_num;
+}
+
+/*
+ * Read the sector info for the iterator. The current using sector info is copied from the snapshot.
+ */
+static fdb_err_t read_iter_sector_info(fdb_tsdb_t db, tsdb_snapshot_t snap, uint32_t addr, tsdb_sec_info_t sector)
+{
+    fdb_err_t result = read_sector_info(db, addr, sector, false);
+
+    if (result == FDB_NO_ERR) {
+        if (!snapshot_has_sector(db, snap, addr)) {
+            result = FDB_READ_ERR;
+        } else if (addr == snap->cur_sec.addr) {
+            /* copy the current using sector status */
+            *sector = snap->cur_sec;
+        }
     }
 
-    db_lock(db);
-    result = tsl_append(db, blob, &timestamp);
-    db_unlock(db);
-
     return result;
 }
 
@@ -484,6 +1533,7 @@ fdb_err_t fdb_tsl_append_with_ts(fdb_tsdb_t db, fdb_blob_t blob, fdb_time_t time
 void fdb_tsl_iter(fdb_tsdb_t db, fdb_tsl_cb cb, void *arg)
 {
     struct tsdb_sec_info sector;
+    struct tsdb_snapshot snap;
     uint32_t sec_addr, traversed_len = 0;
     struct fdb_tsl tsl;
 
@@ -495,33 +1545,45 @@ void fdb_tsl_iter(fdb_tsdb_t db, fdb_tsl_cb cb, void *arg)
         return;
     }
 
-    sec_addr = db_oldest_addr(db);
-	db_lock(db);
+    iter_lock(db, &snap);
+#ifdef FDB_TSDB_USING_ARCHIVE
+    /* the archived TSL are older than the TSL in the sectors */
+    if (tsl_iter_arc(db, &snap, false, cb, arg)) {
+        iter_unlock(db, &snap);
+        return;
+    }
+#endif
+    sec_addr = snap.oldest_addr;
     /* search all sectors */
     do {
         traversed_len += db_sec_size(db);
-        if (read_sector_info(db, sec_addr, &sector, false) != FDB_NO_ERR) {
+        if (read_iter_sector_info(db, &snap, sec_addr, &sector) != FDB_NO_ERR) {
             continue;
         }
         /* sector has TSL */
         if (sector.status == FDB_SECTOR_STORE_USING || sector.status == FDB_SECTOR_STORE_FULL) {
-            if (sector.status == FDB_SECTOR_STORE_USING) {
-                /* copy the current using sector status  */
-                sector = db->cur_sec;
-            }
             tsl.addr.index = sector.addr + SECTOR_HDR_DATA_SIZE;
             /* search all TSL */
             do {
-                read_tsl(db, &tsl);
+                read_tsl(db, &sector, &tsl);
+                if (!snapshot_has_sector(db, &snap, sector.addr)) {
+                    /* this sector is recycled, skip forward to the next sector */
+                    break;
+                }
+#ifdef FDB_TSDB_USING_ARCHIVE
+                if (arc_has_tsl(&snap, &tsl)) {
+                    continue;
+                }
+#endif
                 /* iterator is interrupted when callback return true */
                 if (cb(&tsl, arg)) {
-                    db_unlock(db);
+                    iter_unlock(db, &snap);
                     return;
                 }
             } while ((tsl.addr.index = get_next_tsl_addr(&sector, &tsl)) != FAILED_ADDR);
         }
     } while ((sec_addr = get_next_sector_addr(db, &sector, traversed_len)) != FAILED_ADDR);
-    db_unlock(db);
+    iter_unlock(db, &snap);
 }
 
 /**
@@ -534,6 +1596,7 @@ void fdb_tsl_iter(fdb_tsdb_t db, fdb_tsl_cb cb, void *arg)
 void fdb_tsl_iter_reverse(fdb_tsdb_t db, fdb_tsl_cb cb, void *cb_arg)
 {
     struct tsdb_sec_info sector;
+    struct tsdb_snapshot snap;
     uint32_t sec_addr, traversed_len = 0;
     struct fdb_tsl tsl;
 
@@ -545,67 +1608,340 @@ void fdb_tsl_iter_reverse(fdb_tsdb_t db, fdb_tsl_cb cb, void *cb_arg)
         return;
     }
 
-    sec_addr = db->cur_sec.addr;
-    db_lock(db);
+    iter_lock(db, &snap);
+    sec_addr = snap.cur_sec.addr;
     /* search all sectors */
     do {
         traversed_len += db_sec_size(db);
-        if (read_sector_info(db, sec_addr, &sector, false) != FDB_NO_ERR) {
+        if (read_iter_sector_info(db, &snap, sec_addr, &sector) != FDB_NO_ERR) {
             continue;
         }
         /* sector has TSL */
         if (sector.status == FDB_SECTOR_STORE_USING || sector.status == FDB_SECTOR_STORE_FULL) {
-            if (sector.status == FDB_SECTOR_STORE_USING) {
-                /* copy the current using sector status  */
-                sector = db->cur_sec;
-            }
             tsl.addr.index = sector.end_idx;
             /* search all TSL */
             do {
-                read_tsl(db, &tsl);
+                read_tsl(db, &sector, &tsl);
+                if (!snapshot_has_sector(db, &snap, sector.addr)) {
+                    /* this sector and the older sectors are recycled */
+                    goto __arc;
+                }
+#ifdef FDB_TSDB_USING_ARCHIVE
+                if (arc_has_tsl(&snap, &tsl)) {
+                    continue;
+                }
+#endif
                 /* iterator is interrupted when callback return true */
                 if (cb(&tsl, cb_arg)) {
                     goto __exit;
                 }
             } while ((tsl.addr.index = get_last_tsl_addr(&sector, &tsl)) != FAILED_ADDR);
-        } else if (sector.status == FDB_SECTOR_STORE_EMPTY || sector.status == FDB_SECTOR_STORE_UNUSED)
-            goto __exit;
+        } else if ((sector.status == FDB_SECTOR_STORE_EMPTY && sec_addr != snap.cur_sec.addr)
+                || sector.status == FDB_SECTOR_STORE_UNUSED) {
+            /* the current using sector is empty after it's allocated from the sector pool */
+            goto __arc;
+        }
     } while ((sec_addr = get_last_sector_addr(db, &sector, traversed_len)) != FAILED_ADDR);
 
-__exit:
-    db_unlock(db);
+__arc:
+#ifdef FDB_TSDB_USING_ARCHIVE
+    /* the archived TSL are older than the TSL in the sectors */
+    tsl_iter_arc(db, &snap, true, cb, cb_arg);
+#endif
+
+__exit:
+    iter_unlock(db, &snap);
+}
+
+/*
+ * Found the matched TSL address.
+ */
+static int search_start_tsl_addr(fdb_tsdb_t db, tsdb_sec_info_t sector, int start, int end, fdb_time_t from, fdb_time_t to)
+{
+    struct fdb_tsl tsl;
+    while (true) {
+        tsl.addr.index = start + FDB_ALIGN((end - start) / 2, LOG_IDX_DATA_SIZE);
+        read_tsl(db, sector, &tsl);
+        if (tsl.time < from) {
+            start = tsl.addr.index + LOG_IDX_DATA_SIZE;
+        } else if (tsl.time > from) {
+            end = tsl.addr.index - LOG_IDX_DATA_SIZE;
+        } else {
+            return tsl.addr.index;
+        }
+
+        if (start > end) {
+            if (from > to) {
+                if (start > (int)sector->end_idx) {
+                    /* all TSL is older than from, the slot after the end index may overlap the log data */
+                    start = sector->end_idx;
+                } else {
+                    tsl.addr.index = start;
+                    read_tsl(db, sector, &tsl);
+                    if (tsl.time > from) {
+                        start -= LOG_IDX_DATA_SIZE;
+                    }
+                }
+            }
+            break;
+        }
+    }
+    return start;
+}
+
+/*
+ * Initialize the TSL cursor by timestamp in the snapshot, the caller MUST lock the database by iter_lock.
+ */
+static void tsl_cursor_init(tsl_cursor_t cursor, fdb_tsdb_t db, tsdb_snapshot_t snap, fdb_time_t from, fdb_time_t to)
+{
+    cursor->db = db;
+    cursor->snap = snap;
+    cursor->from = from;
+    cursor->to = to;
+    cursor->start_addr = from <= to ? snap->oldest_addr : snap->cur_sec.addr;
+    cursor->sec_addr = cursor->start_addr;
+    cursor->traversed_len = 0;
+    cursor->next_idx = FAILED_ADDR;
+    cursor->found_start_tsl = false;
+#ifdef FDB_TSDB_USING_ARCHIVE
+    cursor->arc_walk = db->archive && snap->arc_size && (from <= to ? from : to) <= snap->arc_end_time;
+    cursor->arc_addr = from <= to ? 0 : snap->arc_size;
+    cursor->arc_left = 0;
+#endif
+}
+
+static bool tsl_cursor_finish(tsl_cursor_t cursor)
+{
+    cursor->sec_addr = FAILED_ADDR;
+    cursor->next_idx = FAILED_ADDR;
+
+    return false;
+}
+
+/*
+ * Move the cursor to the next TSL in the sectors.
+ */
+static bool tsl_cursor_next_in_sector(tsl_cursor_t cursor)
+{
+    fdb_tsdb_t db = cursor->db;
+    tsdb_sec_info_t sector = &cursor->sector;
+    fdb_tsl_t tsl = &cursor->tsl;
+    fdb_time_t from = cursor->from, to = cursor->to;
+    uint32_t sec_addr;
+
+    while (true) {
+        if (cursor->next_idx == FAILED_ADDR) {
+            /* search the next sector */
+            if ((sec_addr = cursor->sec_addr) == FAILED_ADDR) {
+                return false;
+            }
+            cursor->traversed_len += db_sec_size(db);
+            if (read_iter_sector_info(db, cursor->snap, sec_addr, sector) == FDB_NO_ERR) {
+                /* sector has TSL */
+                if ((sector->status == FDB_SECTOR_STORE_USING || sector->status == FDB_SECTOR_STORE_FULL)) {
+                    if ((cursor->found_start_tsl)
+                            || (!cursor->found_start_tsl &&
+                                    ((from <= to && ((sec_addr == cursor->start_addr && from <= sector->start_time) || from <= sector->end_time)) ||
+                                     (from > to  && ((sec_addr == cursor->start_addr && from >= sector->end_time) || from >= sector->start_time)))
+                                     )) {
+                        cursor->found_start_tsl = true;
+                        /* search the first start TSL address */
+                        cursor->next_idx = search_start_tsl_addr(db, sector, sector->addr + SECTOR_HDR_DATA_SIZE, sector->end_idx,
+                                from, to);
+                    }
+                } else if (sector->status == FDB_SECTOR_STORE_EMPTY && (from <= to || sec_addr != cursor->start_addr)) {
+                    return tsl_cursor_finish(cursor);
+                }
+            }
+            if (from <= to) {
+                cursor->sec_addr = get_next_sector_addr(db, sector, cursor->traversed_len);
+            } else {
+                cursor->sec_addr = get_last_sector_addr(db, sector, cursor->traversed_len);
+            }
+            continue;
+        }
+        tsl->addr.index = cursor->next_idx;
+        read_tsl(db, sector, tsl);
+        if (!snapshot_has_sector(db, cursor->snap, sector->addr)) {
+            /* this sector is recycled, skip forward to the next sector on forward iteration */
+            if (from <= to) {
+                cursor->next_idx = FAILED_ADDR;
+                continue;
+            } else {
+                return tsl_cursor_finish(cursor);
+            }
+        }
+        cursor->next_idx = from <= to ? get_next_tsl_addr(sector, tsl) : get_last_tsl_addr(sector, tsl);
+#ifdef FDB_TSDB_USING_ARCHIVE
+        if (arc_has_tsl(cursor->snap, tsl)) {
+            continue;
+        }
+#endif
+        if (tsl->status != FDB_TSL_UNUSED) {
+            if ((from <= to && tsl->time >= from && tsl->time <= to)
+                    || (from > to && tsl->time <= from && tsl->time >= to)) {
+                return true;
+            } else {
+                return tsl_cursor_finish(cursor);
+            }
+        }
+    }
+}
+
+#ifdef FDB_TSDB_USING_ARCHIVE
+/*
+ * Move the cursor to the next archived TSL.
+ * The archive file and the block buffer are only used with the lock held, so the lock is taken for each TSL
+ * in snapshot read mode, and the block is loaded again when it's changed by others between two TSL.
+ */
+static bool tsl_cursor_next_in_arc(tsl_cursor_t cursor)
+{
+    fdb_tsdb_t db = cursor->db;
+    struct arc_blk_hdr *hdr = &cursor->arc_hdr;
+    fdb_tsl_t tsl = &cursor->tsl;
+    struct arc_tsl_idx idx;
+    bool forward = cursor->from <= cursor->to, found = false;
+    fdb_time_t from = forward ? cursor->from : cursor->to, to = forward ? cursor->to : cursor->from;
+    uint32_t i;
+
+    if (!cursor->snap->locked) {
+        db_lock(db);
+    }
+    while (cursor->arc_walk && !found) {
+        if (cursor->arc_left == 0) {
+            /* search the next block in the time range, only the header is read for the block out of range */
+            if (forward) {
+                if (cursor->arc_addr >= cursor->snap->arc_size
+                        || _fdb_file_ext_read(db->arc_file, cursor->arc_addr, hdr, ARC_BLK_HDR_SIZE) != FDB_NO_ERR) {
+                    cursor->arc_walk = false;
+                    break;
+                }
+                cursor->arc_blk = cursor->arc_addr;
+                cursor->arc_addr += ARC_BLK_HDR_SIZE + hdr->comp_len + ARC_BLK_TAIL_SIZE;
+            } else {
+                if (cursor->arc_addr == 0 || arc_read_last_blk_hdr(db, cursor->arc_addr, &cursor->arc_blk, hdr) != FDB_NO_ERR) {
+                    cursor->arc_walk = false;
+                    break;
+                }
+                cursor->arc_addr = cursor->arc_blk;
+            }
+            if ((forward && hdr->start_time > to) || (!forward && hdr->end_time < from)) {
+                cursor->arc_walk = false;
+            } else if (hdr->end_time >= from && hdr->start_time <= to) {
+                cursor->arc_left = hdr->count;
+                tsl->time = forward ? hdr->start_time : hdr->end_time;
+                tsl->addr.log = forward ? hdr->raw_len : hdr->count * ARC_TSL_IDX_SIZE;
+            }
+            continue;
+        }
+        if (arc_load_blk(db, cursor->arc_blk) != FDB_NO_ERR) {
+            /* skip the broken block */
+            cursor->arc_left = 0;
+            continue;
+        }
+        i = forward ? hdr->count - cursor->arc_left : cursor->arc_left - 1;
+        cursor->arc_left--;
+        if (forward) {
+            memcpy(&idx, db->arc_buf + i * ARC_TSL_IDX_SIZE, ARC_TSL_IDX_SIZE);
+            tsl->time += idx.time_delta;
+            tsl->addr.log -= idx.log_len;
+        } else {
+            if (i + 1 < hdr->count) {
+                /* move to this TSL from the last returned TSL */
+                memcpy(&idx, db->arc_buf + (i + 1) * ARC_TSL_IDX_SIZE, ARC_TSL_IDX_SIZE);
+                tsl->addr.log += idx.log_len;
+                tsl->time -= idx.time_delta;
+            }
+            memcpy(&idx, db->arc_buf + i * ARC_TSL_IDX_SIZE, ARC_TSL_IDX_SIZE);
+        }
+        if ((forward && tsl->time > to) || (!forward && tsl->time < from)) {
+            cursor->arc_walk = false;
+        } else if (tsl->time >= from && tsl->time <= to) {
+            tsl->status = (fdb_tsl_status_t) idx.status;
+            tsl->log_len = idx.log_len;
+            tsl->addr.index = FDB_TSL_ARC_INDEX | cursor->arc_blk;
+            found = true;
+        }
+    }
+    if (!cursor->snap->locked) {
+        db_unlock(db);
+    }
+
+    return found;
+}
+#endif /* FDB_TSDB_USING_ARCHIVE */
+
+/*
+ * Move the cursor to the next TSL in the time range, the cursor->tsl is the current TSL.
+ * The archived TSL are older than the TSL in the sectors.
+ *
+ * @return false: there is no more TSL
+ */
+static bool tsl_cursor_next(tsl_cursor_t cursor)
+{
+#ifdef FDB_TSDB_USING_ARCHIVE
+    if (cursor->from <= cursor->to && cursor->arc_walk && tsl_cursor_next_in_arc(cursor)) {
+        return true;
+    }
+#endif
+    if (tsl_cursor_next_in_sector(cursor)) {
+        return true;
+    }
+#ifdef FDB_TSDB_USING_ARCHIVE
+    if (cursor->from > cursor->to && cursor->arc_walk && tsl_cursor_next_in_arc(cursor)) {
+        return true;
+    }
+#endif
+
+    return false;
+}
+
+/*
+ * Iterate the TSL by timestamp in the snapshot, the caller MUST lock the database by iter_lock.
+ */
+static void tsl_iter_by_time(fdb_tsdb_t db, tsdb_snapshot_t snap, fdb_time_t from, fdb_time_t to, fdb_tsl_cb cb, void *cb_arg)
+{
+    struct tsl_cursor cursor;
+
+    tsl_cursor_init(&cursor, db, snap, from, to);
+    while (tsl_cursor_next(&cursor)) {
+        /* iterator is interrupted when callback return true */
+        if (cb(&cursor.tsl, cb_arg)) {
+            return;
+        }
+    }
 }
 
+
+#ifdef FDB_TSDB_USING_ARCHIVE
 /*
- * Found the matched TSL address.
+ * Iterate all archived TSL for the TSL iterator.
+ *
+ * @return true: the iterator is interrupted by the callback
  */
-static int search_start_tsl_addr(fdb_tsdb_t db, int start, int end, fdb_time_t from, fdb_time_t to)
+static bool tsl_iter_arc(fdb_tsdb_t db, tsdb_snapshot_t snap, bool reverse, fdb_tsl_cb cb, void *cb_arg)
 {
-    struct fdb_tsl tsl;
-    while (true) {
-        tsl.addr.index = start + FDB_ALIGN((end - start) / 2, LOG_IDX_DATA_SIZE);
-        read_tsl(db, &tsl);
-        if (tsl.time < from) {
-            start = tsl.addr.index + LOG_IDX_DATA_SIZE;
-        } else if (tsl.time > from) {
-            end = tsl.addr.index - LOG_IDX_DATA_SIZE;
-        } else {
-            return tsl.addr.index;
-        }
+    struct tsl_cursor cursor;
 
-        if (start > end) {
-            if (from > to) {
-                tsl.addr.index = start;
-                read_tsl(db, &tsl);
-                if (tsl.time > from) {
-                    start -= LOG_IDX_DATA_SIZE;
-                }
-            }
-            break;
+    if (!db->archive || snap->arc_size == 0) {
+        return false;
+    }
+    if (reverse) {
+        tsl_cursor_init(&cursor, db, snap, TSL_TIME_MAX, TSL_TIME_MIN);
+    } else {
+        tsl_cursor_init(&cursor, db, snap, TSL_TIME_MIN, TSL_TIME_MAX);
+    }
+    /* the sectors are walked by the TSL iterator */
+    cursor.sec_addr = FAILED_ADDR;
+    while (tsl_cursor_next(&cursor)) {
+        if (cb(&cursor.tsl, cb_arg)) {
+            return true;
         }
     }
-    return start;
+
+    return false;
 }
+#endif /* FDB_TSDB_USING_ARCHIVE */
 
 /**
  * The TSDB iterator for each TSL by timestamp.
@@ -618,28 +1954,12 @@ static int search_start_tsl_addr(fdb_tsdb_t db, int start, int end, fdb_time_t f
  */
 void fdb_tsl_iter_by_time(fdb_tsdb_t db, fdb_time_t from, fdb_time_t to, fdb_tsl_cb cb, void *cb_arg)
 {
-    struct tsdb_sec_info sector;
-    uint32_t sec_addr, start_addr, traversed_len = 0;
-    struct fdb_tsl tsl;
-    bool found_start_tsl = false;
-
-    uint32_t (*get_sector_addr)(fdb_tsdb_t , tsdb_sec_info_t , uint32_t);
-    uint32_t (*get_tsl_addr)(tsdb_sec_info_t , fdb_tsl_t);
+    struct tsdb_snapshot snap;
 
     if (!db_init_ok(db)) {
         FDB_INFO("Error: TSL (%s) isn't initialize OK.\n", db_name(db));
     }
 
-    if(from <= to) {
-        start_addr = db_oldest_addr(db);
-        get_sector_addr = get_next_sector_addr;
-        get_tsl_addr = get_next_tsl_addr;
-    } else {
-        start_addr = db->cur_sec.addr;
-        get_sector_addr = get_last_sector_addr;
-        get_tsl_addr = get_last_tsl_addr;
-    }
-
 //    FDB_INFO("from %s", ctime((const time_t * )&from));
 //    FDB_INFO("to %s", ctime((const time_t * )&to));
 
@@ -647,53 +1967,100 @@ void fdb_tsl_iter_by_time(fdb_tsdb_t db, fdb_time_t from, fdb_time_t to, fdb_tsl
         return;
     }
 
-    sec_addr = start_addr;
-    db_lock(db);
-    /* search all sectors */
-    do {
-        traversed_len += db_sec_size(db);
-        if (read_sector_info(db, sec_addr, &sector, false) != FDB_NO_ERR) {
-            continue;
+    iter_lock(db, &snap);
+    tsl_iter_by_time(db, &snap, from, to, cb, cb_arg);
+    iter_unlock(db, &snap);
+}
+
+/*
+ * Check the cursor a is before the cursor b in the merge order, the earlier TSDB is first when the timestamp is same.
+ */
+static bool merge_cursor_before(tsl_cursor_t cursor, uint8_t a, uint8_t b)
+{
+    fdb_time_t time_a = cursor[a].tsl.time, time_b = cursor[b].tsl.time;
+
+    if (time_a == time_b) {
+        return a < b;
+    } else if (cursor[a].from <= cursor[a].to) {
+        return time_a < time_b;
+    } else {
+        return time_a > time_b;
+    }
+}
+
+static void merge_heap_down(tsl_cursor_t cursor, uint8_t *heap, size_t heap_num, size_t i)
+{
+    size_t child;
+    uint8_t temp;
+
+    while ((child = 2 * i + 1) < heap_num) {
+        if (child + 1 < heap_num && merge_cursor_before(cursor, heap[child + 1], heap[child])) {
+            child++;
         }
-        /* sector has TSL */
-        if ((sector.status == FDB_SECTOR_STORE_USING || sector.status == FDB_SECTOR_STORE_FULL)) {
-            if (sector.status == FDB_SECTOR_STORE_USING) {
-                /* copy the current using sector status  */
-                sector = db->cur_sec;
-            }
-            if ((found_start_tsl)
-                    || (!found_start_tsl &&
-                            ((from <= to && ((sec_addr == start_addr && from <= sector.start_time) || from <= sector.end_time)) ||
-                             (from > to  && ((sec_addr == start_addr && from >= sector.end_time) || from >= sector.start_time)))
-                             )) {
-                uint32_t start = sector.addr + SECTOR_HDR_DATA_SIZE, end = sector.end_idx;
-
-                found_start_tsl = true;
-                /* search the first start TSL address */
-                tsl.addr.index = search_start_tsl_addr(db, start, end, from, to);
-                /* search all TSL */
-                do {
-                    read_tsl(db, &tsl);
-                    if (tsl.status != FDB_TSL_UNUSED) {
-                        if ((from <= to && tsl.time >= from && tsl.time <= to)
-                                || (from > to && tsl.time <= from && tsl.time >= to)) {
-                            /* iterator is interrupted when callback return true */
-                            if (cb(&tsl, cb_arg)) {
-                                goto __exit;
-                            }
-                        } else {
-                            goto __exit;
-                        }
-                    }
-                } while ((tsl.addr.index = get_tsl_addr(&sector, &tsl)) != FAILED_ADDR);
-            }
-        } else if (sector.status == FDB_SECTOR_STORE_EMPTY) {
-            goto __exit;
+        if (!merge_cursor_before(cursor, heap[child], heap[i])) {
+            break;
         }
-    } while ((sec_addr = get_sector_addr(db, &sector, traversed_len)) != FAILED_ADDR);
+        temp = heap[i];
+        heap[i] = heap[child];
+        heap[child] = temp;
+        i = child;
+    }
+}
 
-__exit:
-    db_unlock(db);
+/**
+ * The merge iterator for the TSL of several TSDBs by timestamp. Each TSDB is searched by its own cursor,
+ * and the TSL is iterated by the global timestamp order through a heap of the cursors.
+ *
+ * @note Every TSDB is locked during the iteration when it's not in snapshot read mode, so the TSDBs MUST NOT share the same lock.
+ *
+ * @param db TSDB objects
+ * @param db_num TSDB number, it MUST less than or equal to FDB_TSL_MERGE_MAX
+ * @param from starting timestamp. It will be a reverse iterator when ending timestamp less than starting timestamp
+ * @param to ending timestamp
+ * @param cb callback, the TSDB object of the TSL is passed to read the TSL data
+ * @param cb_arg callback argument
+ */
+void fdb_tsl_iter_merge(fdb_tsdb_t db[], size_t db_num, fdb_time_t from, fdb_time_t to, fdb_tsl_merge_cb cb, void *cb_arg)
+{
+    struct tsdb_snapshot snap[FDB_TSL_MERGE_MAX];
+    struct tsl_cursor cursor[FDB_TSL_MERGE_MAX];
+    uint8_t heap[FDB_TSL_MERGE_MAX];
+    size_t heap_num = 0, i;
+
+    FDB_ASSERT(db_num <= FDB_TSL_MERGE_MAX);
+
+    if (cb == NULL) {
+        return;
+    }
+
+    for (i = 0; i < db_num; i++) {
+        if (!db_init_ok(db[i])) {
+            FDB_INFO("Error: TSL (%s) isn't initialize OK.\n", db_name(db[i]));
+        }
+        iter_lock(db[i], &snap[i]);
+        tsl_cursor_init(&cursor[i], db[i], &snap[i], from, to);
+        /* seek each TSDB to its first TSL in the range */
+        if (tsl_cursor_next(&cursor[i])) {
+            heap[heap_num++] = (uint8_t)i;
+        }
+    }
+    for (i = heap_num / 2; i-- > 0;) {
+        merge_heap_down(cursor, heap, heap_num, i);
+    }
+    while (heap_num > 0) {
+        i = heap[0];
+        /* iterator is interrupted when callback return true */
+        if (cb(db[i], &cursor[i].tsl, cb_arg)) {
+            break;
+        }
+        if (!tsl_cursor_next(&cursor[i])) {
+            heap[0] = heap[--heap_num];
+        }
+        merge_heap_down(cursor, heap, heap_num, 0);
+    }
+    for (i = db_num; i-- > 0;) {
+        iter_unlock(db[i], &snap[i]);
+    }
 }
 
 static bool query_count_cb(fdb_tsl_t tsl, void *arg)
@@ -732,6 +2099,336 @@ size_t fdb_tsl_query_count(fdb_tsdb_t db, fdb_time_t from, fdb_time_t to, fdb_ts
 
 }
 
+#ifdef FDB_TSDB_USING_AGGREGATE
+/* the aggregate query context */
+struct tsl_agg_ctx {
+    fdb_tsdb_t db;
+    tsdb_snapshot_t snap;
+    fdb_tsl_extractor_t extractor;
+    fdb_tsl_agg_spec_t spec;
+    fdb_tsl_agg_result_t result;
+    size_t field_size;
+    fdb_err_t err;
+    int64_t int64_sum;                           /**< the sum of the INT64 field, it's not summed by double */
+    size_t num;                                  /**< the TSL number in the block */
+    uint32_t field_addr[FDB_TSL_AGG_BLOCK_SIZE]; /**< the field address of each TSL */
+    uint8_t field[FDB_TSL_AGG_BLOCK_SIZE][8];    /**< the field raw data of each TSL */
+    double column[FDB_TSL_AGG_BLOCK_SIZE];       /**< the decoded field value column */
+    uint32_t buf[FDB_TSL_AGG_BUF_SIZE / 4];      /**< the log data buffer */
+};
+
+/* the field size of each fdb_tsl_field_type_t */
+static const uint8_t tsl_field_size[] = { 1, 1, 2, 2, 4, 4, 8, 4, 8 };
+
+#define AGG_DECODE_COLUMN(type)                                                \
+    do {                                                                       \
+        type value;                                                            \
+        for (i = 0; i < num; i++) {                                            \
+            memcpy(&value, field[i], sizeof(type));                            \
+            column[i] = (double)value;                                         \
+        }                                                                      \
+    } while(0)
+
+static void agg_decode_column(fdb_tsl_field_type_t type, uint8_t (*field)[8], double *column, size_t num)
+{
+    size_t i;
+
+    switch (type) {
+    case FDB_TSL_FIELD_INT8:   AGG_DECODE_COLUMN(int8_t);   break;
+    case FDB_TSL_FIELD_UINT8:  AGG_DECODE_COLUMN(uint8_t);  break;
+    case FDB_TSL_FIELD_INT16:  AGG_DECODE_COLUMN(int16_t);  break;
+    case FDB_TSL_FIELD_UINT16: AGG_DECODE_COLUMN(uint16_t); break;
+    case FDB_TSL_FIELD_INT32:  AGG_DECODE_COLUMN(int32_t);  break;
+    case FDB_TSL_FIELD_UINT32: AGG_DECODE_COLUMN(uint32_t); break;
+    case FDB_TSL_FIELD_INT64:  AGG_DECODE_COLUMN(int64_t);  break;
+    case FDB_TSL_FIELD_FLOAT:  AGG_DECODE_COLUMN(float);    break;
+    case FDB_TSL_FIELD_DOUBLE: AGG_DECODE_COLUMN(double);   break;
+    }
+}
+
+/*
+ * The reduction kernels. Every lane reduces a part of the column independently,
+ * so the compiler can vectorize the inner loop when FDB_TSL_AGG_LANES is more than 1.
+ */
+static double agg_sum(const double *column, size_t num)
+{
+    double lane[FDB_TSL_AGG_LANES] = { 0 };
+    size_t i, j;
+
+    for (i = 0; i + FDB_TSL_AGG_LANES <= num; i += FDB_TSL_AGG_LANES) {
+        for (j = 0; j < FDB_TSL_AGG_LANES; j++) {
+            lane[j] += column[i + j];
+        }
+    }
+    for (; i < num; i++) {
+        lane[0] += column[i];
+    }
+    for (j = 1; j < FDB_TSL_AGG_LANES; j++) {
+        lane[0] += lane[j];
+    }
+
+    return lane[0];
+}
+
+static double agg_min(const double *column, size_t num)
+{
+    double lane[FDB_TSL_AGG_LANES];
+    size_t i, j;
+
+    for (j = 0; j < FDB_TSL_AGG_LANES; j++) {
+        lane[j] = column[0];
+    }
+    for (i = 0; i + FDB_TSL_AGG_LANES <= num; i += FDB_TSL_AGG_LANES) {
+        for (j = 0; j < FDB_TSL_AGG_LANES; j++) {
+            lane[j] = column[i + j] < lane[j] ? column[i + j] : lane[j];
+        }
+    }
+    for (; i < num; i++) {
+        lane[0] = column[i] < lane[0] ? column[i] : lane[0];
+    }
+    for (j = 1; j < FDB_TSL_AGG_LANES; j++) {
+        lane[0] = lane[j] < lane[0] ? lane[j] : lane[0];
+    }
+
+    return lane[0];
+}
+
+static double agg_max(const double *column, size_t num)
+{
+    double lane[FDB_TSL_AGG_LANES];
+    size_t i, j;
+
+    for (j = 0; j < FDB_TSL_AGG_LANES; j++) {
+        lane[j] = column[0];
+    }
+    for (i = 0; i + FDB_TSL_AGG_LANES <= num; i += FDB_TSL_AGG_LANES) {
+        for (j = 0; j < FDB_TSL_AGG_LANES; j++) {
+            lane[j] = column[i + j] > lane[j] ? column[i + j] : lane[j];
+        }
+    }
+    for (; i < num; i++) {
+        lane[0] = column[i] > lane[0] ? column[i] : lane[0];
+    }
+    for (j = 1; j < FDB_TSL_AGG_LANES; j++) {
+        lane[0] = lane[j] > lane[0] ? lane[j] : lane[0];
+    }
+
+    return lane[0];
+}
+
+static void agg_hist(fdb_tsl_agg_spec_t spec, const double *column, size_t num)
+{
+    size_t i, bin;
+    double pos;
+
+    for (i = 0; i < num; i++) {
+        pos = (column[i] - spec->hist_min) / spec->hist_width;
+        if (!(pos >= 0)) {
+            bin = 0;
+        } else if (pos >= (double)spec->hist_num) {
+            bin = spec->hist_num - 1;
+        } else {
+            bin = (size_t)pos;
+        }
+        spec->hist[bin]++;
+    }
+}
+
+/*
+ * Read the field of each TSL in the block.
+ * The log address is descending on forward iteration, so the nearby logs in a sector are read by one flash read.
+ * The TSLs in the sector which is recycled before the read are removed from the block.
+ */
+static void agg_read_block(struct tsl_agg_ctx *ctx)
+{
+    size_t i = 0, j, num = 0;
+    uint32_t top, bottom;
+
+    while (i < ctx->num && ctx->err == FDB_NO_ERR) {
+        if (ctx->field_addr[i] == FAILED_ADDR) {
+            /* the archived field is read in the callback */
+            memmove(ctx->field[num++], ctx->field[i++], ctx->field_size);
+            continue;
+        }
+        top = ctx->field_addr[i] + ctx->field_size;
+        for (j = i + 1; j < ctx->num; j++) {
+            if (ctx->field_addr[j] == FAILED_ADDR || ctx->field_addr[j] > ctx->field_addr[j - 1]
+                    || ctx->field_addr[j] / db_sec_size(ctx->db) != ctx->field_addr[i] / db_sec_size(ctx->db)
+                    || top - ctx->field_addr[j] > FDB_TSL_AGG_BUF_SIZE) {
+                break;
+            }
+        }
+        bottom = ctx->field_addr[j - 1];
+        ctx->err = _fdb_flash_read((fdb_db_t)ctx->db, bottom, ctx->buf, top - bottom);
+        /* the fields are read after the TSL, the sector maybe recycled by the appender in snapshot read mode,
+         * then its TSLs are skipped as the iterator does */
+        if (ctx->err != FDB_NO_ERR
+                || !snapshot_has_sector(ctx->db, ctx->snap, bottom / db_sec_size(ctx->db) * db_sec_size(ctx->db))) {
+            i = j;
+            continue;
+        }
+        for (; i < j; i++) {
+            memcpy(ctx->field[num++], (uint8_t *)ctx->buf + (ctx->field_addr[i] - bottom), ctx->field_size);
+        }
+    }
+    ctx->num = num;
+}
+
+/* decode the block into the column and reduce it */
+static void agg_flush(struct tsl_agg_ctx *ctx)
+{
+    fdb_tsl_agg_spec_t spec = ctx->spec;
+    fdb_tsl_agg_result_t result = ctx->result;
+    double value;
+
+    if (ctx->num == 0) {
+        return;
+    }
+    agg_read_block(ctx);
+    if (ctx->err != FDB_NO_ERR || ctx->num == 0) {
+        ctx->num = 0;
+        return;
+    }
+    agg_decode_column(ctx->extractor->type, ctx->field, ctx->column, ctx->num);
+    if ((spec->ops & FDB_TSL_AGG_SUM) && ctx->extractor->type == FDB_TSL_FIELD_INT64) {
+        int64_t value64, sum64;
+        size_t i;
+
+        for (i = 0; i < ctx->num && !result->overflow; i++) {
+            memcpy(&value64, ctx->field[i], sizeof(value64));
+            /* added in unsigned, the sum is overflowed when it moves against the sign of the value */
+            sum64 = (int64_t)((uint64_t)ctx->int64_sum + (uint64_t)value64);
+            result->overflow = (value64 >= 0) != (sum64 >= ctx->int64_sum);
+            ctx->int64_sum = sum64;
+        }
+    }
+    if (spec->ops & FDB_TSL_AGG_SUM) {
+        /* the double sum is used by the INT64 field when the 64 bits sum is overflowed */
+        result->sum += agg_sum(ctx->column, ctx->num);
+    }
+    if (spec->ops & FDB_TSL_AGG_MIN) {
+        value = agg_min(ctx->column, ctx->num);
+        if (result->count == 0 || value < result->min) {
+            result->min = value;
+        }
+    }
+    if (spec->ops & FDB_TSL_AGG_MAX) {
+        value = agg_max(ctx->column, ctx->num);
+        if (result->count == 0 || value > result->max) {
+            result->max = value;
+        }
+    }
+    if (spec->ops & FDB_TSL_AGG_HIST) {
+        agg_hist(spec, ctx->column, ctx->num);
+    }
+    result->count += ctx->num;
+    ctx->num = 0;
+}
+
+static bool agg_collect_cb(fdb_tsl_t tsl, void *arg)
+{
+    struct tsl_agg_ctx *ctx = arg;
+
+    /* the deleted TSL and the TSL without this field are skipped */
+    if (tsl->status == FDB_TSL_PRE_WRITE || tsl->status == FDB_TSL_DELETED
+            || tsl->log_len < ctx->extractor->offset + ctx->field_size) {
+        return false;
+    }
+#ifdef FDB_TSDB_USING_ARCHIVE
+    if (FDB_TSL_IS_ARC(tsl->addr.index)) {
+        struct fdb_blob blob;
+
+        /* the archive block buffer is shared, so the archived field is read at once */
+        fdb_blob_make(&blob, ctx->field[ctx->num], ctx->field_size);
+        fdb_tsl_to_blob(tsl, &blob);
+        if (_fdb_tsl_arc_blob_read((fdb_db_t)ctx->db, &blob, ctx->extractor->offset, ctx->field_size) != ctx->field_size) {
+            ctx->err = FDB_READ_ERR;
+            return true;
+        }
+        ctx->field_addr[ctx->num++] = FAILED_ADDR;
+    } else
+#endif
+    {
+        ctx->field_addr[ctx->num++] = tsl->addr.log + ctx->extractor->offset;
+    }
+    if (ctx->num == FDB_TSL_AGG_BLOCK_SIZE) {
+        agg_flush(ctx);
+    }
+
+    return ctx->err != FDB_NO_ERR;
+}
+
+/**
+ * Aggregate a numeric field of the TSL by timestamp.
+ * The fields are decoded block by block into the column buffer, then reduced by the kernels.
+ * The deleted TSL is skipped, and the TSL in the sector which is recycled during the aggregate is skipped too.
+ *
+ * @param db database object
+ * @param from starting timestamp
+ * @param to ending timestamp
+ * @param extractor the numeric field in the TSL log
+ * @param spec aggregate specification, the histogram bins will be cleared before aggregation
+ * @param result aggregate result
+ *
+ * @return result
+ */
+fdb_err_t fdb_tsl_aggregate(fdb_tsdb_t db, fdb_time_t from, fdb_time_t to, fdb_tsl_extractor_t extractor,
+        fdb_tsl_agg_spec_t spec, fdb_tsl_agg_result_t result)
+{
+    struct tsl_agg_ctx ctx;
+    struct tsdb_snapshot snap;
+    fdb_time_t time;
+
+    FDB_ASSERT(extractor);
+    FDB_ASSERT(extractor->type <= FDB_TSL_FIELD_DOUBLE);
+    FDB_ASSERT(spec);
+    FDB_ASSERT(!(spec->ops & FDB_TSL_AGG_HIST) || (spec->hist && spec->hist_num > 0 && spec->hist_width > 0));
+    FDB_ASSERT(result);
+
+    if (!db_init_ok(db)) {
+        FDB_INFO("Error: TSL (%s) isn't initialize OK.\n", db_name(db));
+        return FDB_INIT_FAILED;
+    }
+
+    memset(result, 0, sizeof(struct fdb_tsl_agg_result));
+    if (spec->ops & FDB_TSL_AGG_HIST) {
+        memset(spec->hist, 0, spec->hist_num * sizeof(uint32_t));
+    }
+    ctx.db = db;
+    ctx.extractor = extractor;
+    ctx.spec = spec;
+    ctx.result = result;
+    ctx.field_size = tsl_field_size[extractor->type];
+    ctx.snap = &snap;
+    ctx.err = FDB_NO_ERR;
+    ctx.int64_sum = 0;
+    ctx.num = 0;
+    /* the aggregation is order independent, the forward iteration makes the log address descending */
+    if (from > to) {
+        time = from;
+        from = to;
+        to = time;
+    }
+
+    iter_lock(db, &snap);
+    tsl_iter_by_time(db, &snap, from, to, agg_collect_cb, &ctx);
+    agg_flush(&ctx);
+    iter_unlock(db, &snap);
+
+    if ((spec->ops & FDB_TSL_AGG_SUM) && extractor->type == FDB_TSL_FIELD_INT64 && !result->overflow) {
+        result->sum = (double)ctx.int64_sum;
+        if (result->count > 0) {
+            result->avg = (double)(ctx.int64_sum / (int64_t)result->count)
+                    + (double)(ctx.int64_sum % (int64_t)result->count) / result->count;
+        }
+    } else if ((spec->ops & FDB_TSL_AGG_SUM) && result->count > 0) {
+        result->avg = result->sum / result->count;
+    }
+
+    return ctx.err;
+}
+#endif /* FDB_TSDB_USING_AGGREGATE */
+
 /**
  * Set the TSL status.
  *
@@ -746,6 +2443,12 @@ fdb_err_t fdb_tsl_set_status(fdb_tsdb_t db, fdb_tsl_t tsl, fdb_tsl_status_t stat
     fdb_err_t result = FDB_NO_ERR;
     uint8_t status_table[TSL_STATUS_TABLE_SIZE];
 
+#ifdef FDB_TSDB_USING_ARCHIVE
+    if (FDB_TSL_IS_ARC(tsl->addr.index)) {
+        /* the archived TSL is read only */
+        return FDB_WRITE_ERR;
+    }
+#endif
     /* write the status will by write granularity */
     _FDB_WRITE_STATUS(db, tsl->addr.index, status_table, FDB_TSL_STATUS_NUM, status, true);
 
@@ -765,6 +2468,7 @@ fdb_blob_t fdb_tsl_to_blob(fdb_tsl_t tsl, fdb_blob_t blob)
     blob->saved.addr = tsl->addr.log;
     blob->saved.meta_addr = tsl->addr.index;
     blob->saved.len = tsl->log_len;
+    blob->saved.sec_gen = tsl->sec_gen;
 
     return blob;
 }
@@ -809,6 +2513,26 @@ static void tsl_format_all(fdb_tsdb_t db)
 {
     struct tsdb_sec_info sector;
 
+    /* all sectors will be recycled */
+    db->recycled_num += db_max_size(db) / db_sec_size(db);
+#ifdef FDB_TSDB_USING_ARCHIVE
+    if (db->archive && db->arc_file >= 0) {
+        _fdb_file_ext_truncate(db->arc_file, 0);
+        db->arc_size = 0;
+        db->arc_end_time = 0;
+        db->arc_blk_addr = FAILED_ADDR;
+    }
+#endif
+#ifdef FDB_TSDB_USING_SECTOR_POOL
+    if (db->pool) {
+        /* only the sectors of this TSDB are formatted */
+        pool_format_all(db);
+        db->last_time = 0;
+        read_sector_info(db, db->cur_sec.addr, &db->cur_sec, false);
+        FDB_INFO("All sector format finished.\n");
+        return;
+    }
+#endif
     sector.addr = 0;
     sector_iterator(db, &sector, FDB_SECTOR_STORE_UNUSED, db, NULL, format_all_cb, false);
     db_oldest_addr(db) = 0;
@@ -872,6 +2596,26 @@ void fdb_tsdb_control(fdb_tsdb_t db, int cmd, void *arg)
         db->parent.unlock = (void (*)(fdb_db_t db))arg;
 #if !defined(__ARMCC_VERSION) && defined(__GNUC__)
 #pragma GCC diagnostic pop
+#endif
+        break;
+    case FDB_TSDB_CTRL_SET_WAIT:
+#if !defined(__ARMCC_VERSION) && defined(__GNUC__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpedantic"
+#endif
+        db->wait = (bool (*)(fdb_db_t db, int32_t *timeout))arg;
+#if !defined(__ARMCC_VERSION) && defined(__GNUC__)
+#pragma GCC diagnostic pop
+#endif
+        break;
+    case FDB_TSDB_CTRL_SET_NOTIFY:
+#if !defined(__ARMCC_VERSION) && defined(__GNUC__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpedantic"
+#endif
+        db->notify = (void (*)(fdb_db_t db))arg;
+#if !defined(__ARMCC_VERSION) && defined(__GNUC__)
+#pragma GCC diagnostic pop
 #endif
         break;
     case FDB_TSDB_CTRL_SET_ROLLOVER:
@@ -906,6 +2650,38 @@ void fdb_tsdb_control(fdb_tsdb_t db, int cmd, void *arg)
         FDB_ASSERT(db->parent.init_ok == false);
         db->parent.not_formatable = *(bool *)arg;
         break;
+    case FDB_TSDB_CTRL_SET_SNAPSHOT_READ:
+        /* this change will take effect on the next iteration */
+        db->snapshot_read = *(bool *)arg;
+        break;
+    case FDB_TSDB_CTRL_GET_SNAPSHOT_READ:
+        *(bool *)arg = db->snapshot_read;
+        break;
+    case FDB_TSDB_CTRL_SET_POOL:
+#ifdef FDB_TSDB_USING_SECTOR_POOL
+        /* this change MUST before database initialization */
+        FDB_ASSERT(db->parent.init_ok == false);
+        db->pool = (fdb_tsdb_pool_t)arg;
+#else
+        FDB_INFO("Error: set sector pool Failed. Please defined the FDB_TSDB_USING_SECTOR_POOL macro.");
+#endif
+        break;
+    case FDB_TSDB_CTRL_SET_ARCHIVE:
+#ifdef FDB_TSDB_USING_ARCHIVE
+        /* this change MUST before database initialization */
+        FDB_ASSERT(db->parent.init_ok == false);
+        db->archive = *(bool *)arg;
+#else
+        FDB_INFO("Error: set archive mode Failed. Please defined the FDB_TSDB_USING_ARCHIVE macro.");
+#endif
+        break;
+    case FDB_TSDB_CTRL_GET_ARCHIVE_SIZE:
+#ifdef FDB_TSDB_USING_ARCHIVE
+        *(uint32_t *)arg = db->arc_size;
+#else
+        *(uint32_t *)arg = 0;
+#endif
+        break;
     }
 }
 
@@ -943,9 +2719,30 @@ fdb_err_t fdb_tsdb_init(fdb_tsdb_t db, const char *name, const char *path, fdb_g
     db->rollover = true;
     db_oldest_addr(db) = FDB_DATA_UNUSED;
     db->cur_sec.addr = FDB_DATA_UNUSED;
+#ifdef FDB_TSDB_USING_ARCHIVE
+    db->arc_file = -1;
+    db->arc_locked = 0;
+#endif
     /* must less than sector size */
     FDB_ASSERT(max_len < db_sec_size(db));
 
+#ifdef FDB_TSDB_USING_SECTOR_POOL
+    if (db->pool) {
+#ifdef FDB_USING_FILE_MODE
+        if (db->parent.file_mode) {
+            FDB_INFO("Error: the sector pool is only supported in FAL mode.\n");
+            result = FDB_INIT_FAILED;
+        } else
+#endif
+        {
+            /* the sectors are shared with other TSDBs, only the sector chain of this TSDB is loaded */
+            result = pool_attach(db);
+        }
+        db_unlock(db);
+        goto __exit;
+    }
+#endif
+
     /* check all sector header */
     sector.addr = 0;
     sector_iterator(db, &sector, FDB_SECTOR_STORE_UNUSED, &check_sec_arg, NULL, check_sec_hdr_cb, true);
@@ -997,6 +2794,22 @@ fdb_err_t fdb_tsdb_init(fdb_tsdb_t db, const char *name, const char *path, fdb_g
         db->last_time = sec.end_time;
     }
 
+#ifdef FDB_TSDB_USING_ARCHIVE
+    if (db->archive) {
+        FDB_ASSERT(max_len + ARC_TSL_IDX_SIZE <= FDB_TSDB_ARC_BLOCK_SIZE);
+        if (!db->parent.file_mode) {
+            FDB_INFO("Error: the archive is only supported in file mode.\n");
+            result = FDB_INIT_FAILED;
+        } else {
+            result = arc_load(db);
+            /* the new TSL MUST be newer than the archived TSL */
+            if (db->last_time < db->arc_end_time) {
+                db->last_time = db->arc_end_time;
+            }
+        }
+    }
+#endif
+
     /* unlock the TSDB */
     db_unlock(db);
 
@@ -1016,6 +2829,19 @@ __exit:
  */
 fdb_err_t fdb_tsdb_deinit(fdb_tsdb_t db)
 {
+#ifdef FDB_TSDB_USING_SECTOR_POOL
+    if (db->pool) {
+        db_lock(db);
+        pool_detach(db);
+        db_unlock(db);
+    }
+#endif
+#ifdef FDB_TSDB_USING_ARCHIVE
+    if (db->archive) {
+        _fdb_file_ext_close(db->arc_file);
+        db->arc_file = -1;
+    }
+#endif
     _fdb_deinit((fdb_db_t) db);
 
     return FDB_NO_ERR;
@@ -14,6 +14,7 @@
 
 #include "utest.h"
 #include <flashdb.h>
+#include <fdb_low_lvl.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <inttypes.h>
@@ -25,6 +26,7 @@
 #else
 #include <dfs_file.h>
 #include <unistd.h>
+#include <fcntl.h>
 #endif
 
 #define TEST_TS_PART_NAME             "fdb_kvdb1"
@@ -52,6 +54,18 @@ static struct fdb_kvdb test_kvdb;
 
 static void test_fdb_kvdb_deinit(void);
 
+/* the version KV which is saved by FDB_KV_AUTO_UPDATE is in the KV number too */
+static size_t test_kv_ver_num_cnt(void)
+{
+#ifdef FDB_KV_AUTO_UPDATE
+    struct fdb_kv kv;
+
+    return fdb_kv_get_obj(&test_kvdb, "__ver_num__", &kv) ? 1 : 0;
+#else
+    return 0;
+#endif
+}
+
 static rt_err_t dir_delete(const char* path)
 {
     DIR* dir = NULL;
@@ -127,6 +141,13 @@ static void test_fdb_kvdb_init_by_sector_num(size_t sector_num)
     fdb_kvdb_control(&(test_kvdb), FDB_KVDB_CTRL_SET_SEC_SIZE, &sec_size);
     fdb_kvdb_control(&(test_kvdb), FDB_KVDB_CTRL_SET_FILE_MODE, &file_mode);
     fdb_kvdb_control(&(test_kvdb), FDB_KVDB_CTRL_SET_MAX_SIZE, &db_size);
+#ifdef FDB_KV_USING_INCREMENTAL_GC
+    {
+        /* the GC testcases check the sector layout after the whole sectors are collected when set KV */
+        size_t gc_budget = 0;
+        fdb_kvdb_control(&(test_kvdb), FDB_KVDB_CTRL_SET_GC_BUDGET, &gc_budget);
+    }
+#endif
 
     uassert_true(fdb_kvdb_init(&test_kvdb, "test_kv", TEST_TS_PART_NAME, NULL, NULL) == FDB_NO_ERR);
 }
@@ -175,6 +196,13 @@ static void test_fdb_create_kv_blob(void)
     read_len = fdb_blob_read((fdb_db_t)&test_kvdb, fdb_kv_to_blob(&kv_obj, &blob));
     uassert_int_equal(read_len, sizeof(value_buf));
     uassert_buf_equal(&tick, value_buf, sizeof(value_buf));
+
+    /* read a part of the blob */
+    memset(value_buf, 0, sizeof(value_buf));
+    read_len = fdb_blob_read_at((fdb_db_t)&test_kvdb, &blob, 1, sizeof(value_buf));
+    uassert_int_equal(read_len, sizeof(value_buf) - 1);
+    uassert_buf_equal((uint8_t *)&tick + 1, value_buf, read_len);
+    uassert_int_equal(fdb_blob_read_at((fdb_db_t)&test_kvdb, &blob, sizeof(value_buf), 1), 0);
 }
 
 static void test_fdb_change_kv_blob(void)
@@ -294,6 +322,253 @@ static void test_fdb_del_kv(void)
     }
 }
 
+/* the KV names which are the prefix of others, the cache is matched by name CRC32 and length */
+static void test_fdb_kv_cache_name(void)
+{
+    char *read_value;
+
+    uassert_true(fdb_kv_set(&test_kvdb, "cache_kv", "0") == FDB_NO_ERR);
+    uassert_true(fdb_kv_set(&test_kvdb, "cache_kv1", "1") == FDB_NO_ERR);
+    uassert_true(fdb_kv_set(&test_kvdb, "cache_kv12", "12") == FDB_NO_ERR);
+
+    read_value = fdb_kv_get(&test_kvdb, "cache_kv1");
+    uassert_not_null(read_value);
+    uassert_str_equal(read_value, "1");
+    read_value = fdb_kv_get(&test_kvdb, "cache_kv");
+    uassert_not_null(read_value);
+    uassert_str_equal(read_value, "0");
+
+    uassert_true(fdb_kv_del(&test_kvdb, "cache_kv1") == FDB_NO_ERR);
+    uassert_null(fdb_kv_get(&test_kvdb, "cache_kv1"));
+    read_value = fdb_kv_get(&test_kvdb, "cache_kv12");
+    uassert_not_null(read_value);
+    uassert_str_equal(read_value, "12");
+
+    uassert_true(fdb_kv_del(&test_kvdb, "cache_kv") == FDB_NO_ERR);
+    uassert_true(fdb_kv_del(&test_kvdb, "cache_kv12") == FDB_NO_ERR);
+}
+
+#if defined(FDB_KV_CRC_VERIFY_ONCE) && defined(FDB_USING_FILE_POSIX_MODE)
+static void test_fdb_kv_verify_once(void)
+{
+    struct fdb_kv kv;
+    char path[64], ch = 'X';
+    int fd;
+
+    uassert_true(fdb_kv_set(&test_kvdb, "verify_kv", "abcdef") == FDB_NO_ERR);
+    uassert_not_null(fdb_kv_get_obj(&test_kvdb, "verify_kv", &kv));
+    uassert_true(fdb_kvdb_check(&test_kvdb) == FDB_NO_ERR);
+
+    /* damage the value on flash after verified */
+    rt_snprintf(path, sizeof(path), "%s/test_kv.fdb.%d", TEST_TS_PART_NAME, (int)(kv.addr.value / TEST_KVDB_SECTOR_SIZE));
+    fd = open(path, O_RDWR);
+    uassert_true(fd >= 0);
+    lseek(fd, kv.addr.value % TEST_KVDB_SECTOR_SIZE, SEEK_SET);
+    uassert_true(write(fd, &ch, 1) == 1);
+    close(fd);
+
+    /* the verified KV is read without CRC32 check */
+    uassert_not_null(fdb_kv_get(&test_kvdb, "verify_kv"));
+    /* the scrub finds it */
+    uassert_true(fdb_kvdb_check(&test_kvdb) == FDB_READ_ERR);
+    uassert_null(fdb_kv_get(&test_kvdb, "verify_kv"));
+
+    fdb_kv_set_default(&test_kvdb);
+}
+#endif /* defined(FDB_KV_CRC_VERIFY_ONCE) && defined(FDB_USING_FILE_POSIX_MODE) */
+
+#ifdef FDB_USING_FILE_POSIX_MODE
+static void test_fdb_kv_scan_magic(void)
+{
+    struct fdb_blob blob;
+    struct fdb_kv kv;
+    struct fdb_kv_iterator iterator;
+    char path[64], value[300], ch = 'X';
+    bool found = false;
+    int fd;
+
+    /* the value is longer than the scan buffer, so the scanning crosses several windows */
+    memset(value, 'a', sizeof(value));
+    uassert_true(fdb_kv_set_blob(&test_kvdb, "scan_kv0", fdb_blob_make(&blob, value, sizeof(value))) == FDB_NO_ERR);
+    uassert_true(fdb_kv_set(&test_kvdb, "scan_kv1", "abcdef") == FDB_NO_ERR);
+    uassert_not_null(fdb_kv_get_obj(&test_kvdb, "scan_kv0", &kv));
+
+    /* damage the first KV on flash, then the next KV is found by magic word */
+    rt_snprintf(path, sizeof(path), "%s/test_kv.fdb.%d", TEST_TS_PART_NAME, (int)(kv.addr.value / TEST_KVDB_SECTOR_SIZE));
+    fd = open(path, O_RDWR);
+    uassert_true(fd >= 0);
+    lseek(fd, kv.addr.value % TEST_KVDB_SECTOR_SIZE, SEEK_SET);
+    uassert_true(write(fd, &ch, 1) == 1);
+    close(fd);
+
+    fdb_kv_iterator_init(&test_kvdb, &iterator);
+    while (fdb_kv_iterate(&test_kvdb, &iterator)) {
+        if (!strcmp(iterator.curr_kv.name, "scan_kv1")) {
+            found = true;
+        }
+    }
+    uassert_true(found);
+
+    fdb_kv_set_default(&test_kvdb);
+}
+#endif /* FDB_USING_FILE_POSIX_MODE */
+
+static void test_fdb_kv_batch_check(const char *key, const char *value)
+{
+    char buf[16] = { 0 };
+    struct fdb_blob blob;
+
+    if (value) {
+        uassert_true(fdb_kv_get_blob(&test_kvdb, key, fdb_blob_make(&blob, buf, sizeof(buf))) == strlen(value));
+        uassert_str_equal(buf, value);
+    } else {
+        uassert_null(fdb_kv_get(&test_kvdb, key));
+    }
+}
+
+#ifdef FDB_USING_FILE_POSIX_MODE
+/* change the KV status on file directly, it's used to simulate the power down */
+static void test_fdb_kv_batch_set_status(uint32_t addr, fdb_kv_status_t status)
+{
+    uint8_t status_table[FDB_STATUS_TABLE_SIZE(FDB_KV_STATUS_NUM)];
+    char path[64];
+    int fd;
+
+    _fdb_set_status(status_table, FDB_KV_STATUS_NUM, status);
+    rt_snprintf(path, sizeof(path), "%s/test_kv.fdb.%d", TEST_TS_PART_NAME, (int)(addr / TEST_KVDB_SECTOR_SIZE));
+    fd = open(path, O_RDWR);
+    uassert_true(fd >= 0);
+    lseek(fd, addr % TEST_KVDB_SECTOR_SIZE, SEEK_SET);
+    uassert_true(write(fd, status_table, sizeof(status_table)) == sizeof(status_table));
+    close(fd);
+}
+#endif /* FDB_USING_FILE_POSIX_MODE */
+
+static void test_fdb_kv_set_batch(void)
+{
+    const char *keys[] = { "batch0", "batch1", "batch2" };
+    const char *dup_keys[] = { "batch0", "batch0" };
+    struct fdb_blob blobs[3];
+
+    fdb_kv_set_default(&test_kvdb);
+    uassert_true(fdb_kv_set(&test_kvdb, "batch0", "old0") == FDB_NO_ERR);
+    fdb_blob_make(&blobs[0], "new0", 4);
+    fdb_blob_make(&blobs[1], "new1", 4);
+    fdb_blob_make(&blobs[2], "new2", 4);
+    uassert_true(fdb_kv_set_batch(&test_kvdb, keys, blobs, 3) == FDB_NO_ERR);
+    test_fdb_kv_batch_check("batch0", "new0");
+    test_fdb_kv_batch_check("batch1", "new1");
+    test_fdb_kv_batch_check("batch2", "new2");
+    /* the duplicated KV name is not supported */
+    uassert_true(fdb_kv_set_batch(&test_kvdb, dup_keys, blobs, 2) == FDB_KV_NAME_ERR);
+    test_fdb_kv_batch_check("batch0", "new0");
+    fdb_reboot();
+    test_fdb_kv_batch_check("batch0", "new0");
+    test_fdb_kv_batch_check("batch1", "new1");
+    test_fdb_kv_batch_check("batch2", "new2");
+
+#ifdef FDB_USING_FILE_POSIX_MODE
+    {
+        struct fdb_kv old_kv, new_kv0, new_kv1;
+        struct fdb_kv_iterator iterator;
+        uint32_t batch_addr;
+        int count = 0;
+
+        fdb_kv_set_default(&test_kvdb);
+        uassert_true(fdb_kv_set(&test_kvdb, "batch0", "old0") == FDB_NO_ERR);
+        uassert_not_null(fdb_kv_get_obj(&test_kvdb, "batch0", &old_kv));
+        /* the batch record is behind the old KV */
+        batch_addr = old_kv.addr.start + old_kv.len;
+        uassert_true(fdb_kv_set_batch(&test_kvdb, keys, blobs, 2) == FDB_NO_ERR);
+        uassert_not_null(fdb_kv_get_obj(&test_kvdb, "batch0", &new_kv0));
+        uassert_not_null(fdb_kv_get_obj(&test_kvdb, "batch1", &new_kv1));
+
+        /* power down before the batch is committed, none of the KVs is saved */
+        test_fdb_kv_batch_set_status(old_kv.addr.start, FDB_KV_WRITE);
+        test_fdb_kv_batch_set_status(batch_addr, FDB_KV_PRE_WRITE);
+        test_fdb_kv_batch_set_status(new_kv0.addr.start, FDB_KV_PRE_WRITE);
+        test_fdb_kv_batch_set_status(new_kv1.addr.start, FDB_KV_PRE_WRITE);
+        fdb_reboot();
+        test_fdb_kv_batch_check("batch0", "old0");
+        test_fdb_kv_batch_check("batch1", NULL);
+
+        /* power down after the batch is committed, all KVs are saved */
+        test_fdb_kv_batch_set_status(batch_addr, FDB_KV_WRITE);
+        test_fdb_kv_batch_set_status(new_kv0.addr.start, FDB_KV_PRE_WRITE);
+        test_fdb_kv_batch_set_status(new_kv1.addr.start, FDB_KV_PRE_WRITE);
+        fdb_reboot();
+        test_fdb_kv_batch_check("batch0", "new0");
+        test_fdb_kv_batch_check("batch1", "new1");
+        fdb_kv_iterator_init(&test_kvdb, &iterator);
+        while (fdb_kv_iterate(&test_kvdb, &iterator)) {
+            count++;
+        }
+        uassert_int_equal(count, 2 + test_kv_ver_num_cnt());
+    }
+#endif /* FDB_USING_FILE_POSIX_MODE */
+
+    fdb_kv_set_default(&test_kvdb);
+}
+
+static void test_fdb_kv_iterate_by_name(void)
+{
+    const char *names[] = { "pad/b", "calibration_N", "pa", "pad/a", "calibration_A", "pad_x", "calibration_M",
+            "pad/c", "calibration_Z", "calibration_C" };
+    struct fdb_kv_iterator iterator;
+    char last_name[FDB_KV_NAME_MAX + 1];
+    size_t i, count;
+
+    fdb_kv_set_default(&test_kvdb);
+    for (i = 0; i < FDB_ARRAY_SIZE(names); i++) {
+        uassert_true(fdb_kv_set(&test_kvdb, names[i], names[i]) == FDB_NO_ERR);
+    }
+    /* delete and change some KVs, the ordered index is updated */
+    uassert_true(fdb_kv_set(&test_kvdb, "pad/c", "changed") == FDB_NO_ERR);
+    uassert_true(fdb_kv_set(&test_kvdb, "pad/d", "pad/d") == FDB_NO_ERR);
+    uassert_true(fdb_kv_del(&test_kvdb, "pad/d") == FDB_NO_ERR);
+
+    for (count = 0; count < 2; count++) {
+        i = 0;
+        last_name[0] = '\0';
+        fdb_kv_iterator_init(&test_kvdb, &iterator);
+        while (fdb_kv_iterate_prefix(&test_kvdb, &iterator, "pad/")) {
+            uassert_true(!strncmp(iterator.curr_kv.name, "pad/", 4));
+#ifdef FDB_KV_USING_ORDERED_INDEX
+            uassert_true(strcmp(last_name, iterator.curr_kv.name) < 0);
+#endif
+            strcpy(last_name, iterator.curr_kv.name);
+            i++;
+        }
+        uassert_int_equal(i, 3);
+        uassert_int_equal(iterator.iterated_cnt, 3);
+
+        i = 0;
+        last_name[0] = '\0';
+        fdb_kv_iterator_init(&test_kvdb, &iterator);
+        while (fdb_kv_iterate_range(&test_kvdb, &iterator, "calibration_A", "calibration_M")) {
+            uassert_true(strcmp(iterator.curr_kv.name, "calibration_A") >= 0);
+            uassert_true(strcmp(iterator.curr_kv.name, "calibration_M") <= 0);
+#ifdef FDB_KV_USING_ORDERED_INDEX
+            uassert_true(strcmp(last_name, iterator.curr_kv.name) < 0);
+#endif
+            strcpy(last_name, iterator.curr_kv.name);
+            i++;
+        }
+        uassert_int_equal(i, 3);
+
+        i = 0;
+        fdb_kv_iterator_init(&test_kvdb, &iterator);
+        while (fdb_kv_iterate_range(&test_kvdb, &iterator, NULL, NULL)) {
+            i++;
+        }
+        uassert_int_equal(i, FDB_ARRAY_SIZE(names) + test_kv_ver_num_cnt());
+        /* the ordered index is rebuilt after reboot */
+        fdb_reboot();
+    }
+
+    fdb_kv_set_default(&test_kvdb);
+}
+
 static int iter_all_kv(fdb_kvdb_t db, struct test_kv *kv_tbl, size_t len)
 {
     struct fdb_kv_iterator iterator;
@@ -863,6 +1138,835 @@ static void test_fdb_scale_up(void)
     test_check_fdb_by_kvs(old_kv_tbl, FDB_ARRAY_SIZE(old_kv_tbl));
 }
 
+#ifdef FDB_KV_USING_INDEX
+#define TEST_KV_INDEX_NUM              60
+
+static void test_fdb_kv_index_check(int round)
+{
+    char name[16];
+    int i, value;
+    size_t read_len;
+    struct fdb_blob blob;
+
+    for (i = 0; i < TEST_KV_INDEX_NUM; i++) {
+        rt_snprintf(name, sizeof(name), "idx%d", i);
+        value = -1;
+        read_len = fdb_kv_get_blob(&test_kvdb, name, fdb_blob_make(&blob, &value, sizeof(value)));
+        /* every 3rd KV is deleted */
+        if (i % 3 == 0) {
+            uassert_true(read_len == 0);
+        } else {
+            uassert_true(read_len == sizeof(value));
+            uassert_int_equal(value, round * 1000 + i);
+        }
+    }
+    /* the prefix of KV name is not matched */
+    uassert_null(fdb_kv_get(&test_kvdb, "idx"));
+    uassert_null(fdb_kv_get(&test_kvdb, "idx10x"));
+    uassert_true(test_kvdb.kv_index_ok);
+    uassert_true(test_kvdb.kv_index_num == TEST_KV_INDEX_NUM - (TEST_KV_INDEX_NUM + 2) / 3 + test_kv_ver_num_cnt());
+}
+
+static void test_fdb_kv_index(void)
+{
+    char name[16];
+    int i, round, value;
+    struct fdb_blob blob;
+
+    fdb_kv_set_default(&test_kvdb);
+    uassert_true(test_kvdb.kv_index_num == 0);
+    /* the KV is moved by GC many times */
+    for (round = 0; round < 8; round++) {
+        for (i = 0; i < TEST_KV_INDEX_NUM; i++) {
+            rt_snprintf(name, sizeof(name), "idx%d", i);
+            value = round * 1000 + i;
+            uassert_true(fdb_kv_set_blob(&test_kvdb, name, fdb_blob_make(&blob, &value, sizeof(value))) == FDB_NO_ERR);
+        }
+        for (i = 0; i < TEST_KV_INDEX_NUM; i += 3) {
+            rt_snprintf(name, sizeof(name), "idx%d", i);
+            uassert_true(fdb_kv_del(&test_kvdb, name) == FDB_NO_ERR);
+        }
+        test_fdb_kv_index_check(round);
+    }
+    /* the index is rebuilt when reboot */
+    fdb_reboot();
+    test_fdb_kv_index_check(round - 1);
+    fdb_kv_set_default(&test_kvdb);
+}
+#endif /* FDB_KV_USING_INDEX */
+
+#ifdef FDB_KV_USING_GC_COST_BENEFIT
+static void test_fdb_gc_cost_benefit(void)
+{
+    struct fdb_kv kv;
+    /*
+     * +---------------------------------------------------------+
+     * |   sector0    |   sector1   |   sector2    |   sector3   |
+     * |    using     |    using    |    using     |    empty    |
+     * +---------------------------------------------------------+
+     * |    kv0 new   |  kv3 delete |   kv3 new    |             |
+     * |    kv1 new   |  kv4 delete |   kv4 new    |             |
+     * |    kv2 delete|  kv5 delete |   kv5 new    |             |
+     * +---------------------------------------------------------+
+     */
+    static const struct test_kv kv_tbl[] = {
+        {"kv0", "0", TEST_KV_VALUE_LEN, 0, 0, 1},
+        {"kv1", "1", TEST_KV_VALUE_LEN, 0, 0, 1},
+        {"kv2", "2", TEST_KV_VALUE_LEN, 0, 0, 1},
+        {"kv3", "3", TEST_KV_VALUE_LEN, 1, 0, 1},
+        {"kv4", "4", TEST_KV_VALUE_LEN, 1, 0, 1},
+        {"kv5", "5", TEST_KV_VALUE_LEN, 1, 0, 1},
+        {"kv3", "33", TEST_KV_VALUE_LEN, 2, 0, 1},
+        {"kv4", "44", TEST_KV_VALUE_LEN, 2, 0, 1},
+        {"kv5", "55", TEST_KV_VALUE_LEN, 2, 0, 1},
+    };
+    static const struct test_kv new_kv_tbl[] = {
+        {"kv6", "6", TEST_KV_VALUE_LEN, 1, 0, 1},
+    };
+
+    fdb_kv_set_default(&test_kvdb);
+    test_save_fdb_by_kvs(kv_tbl, FDB_ARRAY_SIZE(kv_tbl));
+    uassert_true(fdb_kv_del(&test_kvdb, "kv2") == FDB_NO_ERR);
+    /* the sector1 is all garbage, it's collected before the older sector0 which is 2/3 live */
+    test_save_fdb_by_kvs(new_kv_tbl, FDB_ARRAY_SIZE(new_kv_tbl));
+    uassert_not_null(fdb_kv_get_obj(&test_kvdb, "kv0", &kv));
+    uassert_true(RT_ALIGN_DOWN(kv.addr.start, TEST_KVDB_SECTOR_SIZE) == TEST_KVDB_SECTOR_SIZE * 0);
+    uassert_not_null(fdb_kv_get_obj(&test_kvdb, "kv1", &kv));
+    uassert_true(RT_ALIGN_DOWN(kv.addr.start, TEST_KVDB_SECTOR_SIZE) == TEST_KVDB_SECTOR_SIZE * 0);
+    /* the collected sector1 is the first empty sector from the oldest one, the kv6 is saved in it */
+    uassert_not_null(fdb_kv_get_obj(&test_kvdb, "kv6", &kv));
+    uassert_true(RT_ALIGN_DOWN(kv.addr.start, TEST_KVDB_SECTOR_SIZE) == TEST_KVDB_SECTOR_SIZE * 1);
+    uassert_true(test_kvdb.sec_stat_table[1].live == kv.len && test_kvdb.sec_stat_table[1].garbage == 0);
+    uassert_true(test_kvdb.sec_stat_table[0].garbage == test_kvdb.sec_stat_table[0].live / 2);
+    /* the collected sector1 is NOT the oldest, the oldest sector is still sector0 */
+    uassert_true(test_kvdb.parent.oldest_addr == TEST_KVDB_SECTOR_SIZE * 0);
+    /* the sector is aged by the write sequence, the reused sector1 is the newest one */
+    uassert_true(test_kvdb.sec_stat_table[0].seq < test_kvdb.sec_stat_table[2].seq);
+    uassert_true(test_kvdb.sec_stat_table[2].seq < test_kvdb.sec_stat_table[1].seq);
+
+    fdb_kv_set_default(&test_kvdb);
+}
+#endif /* FDB_KV_USING_GC_COST_BENEFIT */
+
+#ifdef FDB_KV_USING_FREE_MAP
+static void test_fdb_kv_free_map(void)
+{
+    struct kv_free_node free_map[TEST_KVDB_SECTOR_NUM];
+    char name[16], value[100];
+    int i, round;
+
+    fdb_kv_set_default(&test_kvdb);
+    uassert_true(test_kvdb.free_map_ok);
+    memset(value, 'm', sizeof(value) - 1);
+    value[sizeof(value) - 1] = '\0';
+    for (round = 0; round < 10; round++) {
+        for (i = 0; i < 10; i++) {
+            rt_snprintf(name, sizeof(name), "map%d", i);
+            value[0] = '0' + round;
+            uassert_true(fdb_kv_set(&test_kvdb, name, value) == FDB_NO_ERR);
+        }
+    }
+    /* the map is same as the sectors status which is rebuilt after reboot */
+    memcpy(free_map, test_kvdb.free_map, sizeof(free_map));
+    fdb_reboot();
+    for (i = 0; i < TEST_KVDB_SECTOR_NUM; i++) {
+        uassert_int_equal(free_map[i].store, test_kvdb.free_map[i].store);
+        uassert_int_equal(free_map[i].dirty, test_kvdb.free_map[i].dirty);
+    }
+    for (i = 0; i < 10; i++) {
+        rt_snprintf(name, sizeof(name), "map%d", i);
+        value[0] = '9';
+        uassert_str_equal(fdb_kv_get(&test_kvdb, name), value);
+    }
+
+    fdb_kv_set_default(&test_kvdb);
+}
+#endif /* FDB_KV_USING_FREE_MAP */
+
+#ifdef FDB_KV_USING_CACHE
+static struct kvdb_sec_info test_sec_cache_table[TEST_KVDB_SECTOR_NUM];
+
+static void test_fdb_kv_set_sec_cache(struct kvdb_sec_info *table, size_t num)
+{
+    struct fdb_kvdb_sec_cache sec_cache = { table, num };
+
+    test_fdb_kvdb_deinit();
+    fdb_kvdb_control(&test_kvdb, FDB_KVDB_CTRL_SET_SEC_CACHE, &sec_cache);
+    test_fdb_kvdb_init();
+}
+
+static void test_fdb_kv_sec_cache(void)
+{
+    struct kvdb_sec_info sec_info[TEST_KVDB_SECTOR_NUM];
+    char name[16], value[100];
+    int i, round;
+
+    test_fdb_kv_set_sec_cache(test_sec_cache_table, TEST_KVDB_SECTOR_NUM);
+    uassert_true(test_kvdb.sector_cache_all == test_sec_cache_table);
+    fdb_kv_set_default(&test_kvdb);
+#ifdef FDB_KV_AUTO_UPDATE
+    /* the version KV is saved on the first boot after set default, it's NOT saved on the reboot below */
+    fdb_reboot();
+#endif
+    memset(value, 'c', sizeof(value) - 1);
+    value[sizeof(value) - 1] = '\0';
+    for (round = 0; round < 10; round++) {
+        for (i = 0; i < 10; i++) {
+            rt_snprintf(name, sizeof(name), "sec%d", i);
+            value[0] = '0' + round;
+            uassert_true(fdb_kv_set(&test_kvdb, name, value) == FDB_NO_ERR);
+        }
+    }
+    /* the cache is same as the sectors header which is read from flash after reboot */
+    memcpy(sec_info, test_sec_cache_table, sizeof(sec_info));
+    fdb_reboot();
+    for (i = 0; i < TEST_KVDB_SECTOR_NUM; i++) {
+        uassert_true(test_sec_cache_table[i].check_ok);
+        uassert_int_equal(sec_info[i].addr, i * TEST_KVDB_SECTOR_SIZE);
+        uassert_int_equal(sec_info[i].addr, test_sec_cache_table[i].addr);
+        uassert_int_equal(sec_info[i].status.store, test_sec_cache_table[i].status.store);
+        uassert_int_equal(sec_info[i].status.dirty, test_sec_cache_table[i].status.dirty);
+        if (sec_info[i].status.store == FDB_SECTOR_STORE_EMPTY || sec_info[i].status.store == FDB_SECTOR_STORE_USING) {
+            uassert_int_equal(sec_info[i].empty_kv, test_sec_cache_table[i].empty_kv);
+            uassert_int_equal(sec_info[i].remain, test_sec_cache_table[i].remain);
+        }
+    }
+    for (i = 0; i < 10; i++) {
+        rt_snprintf(name, sizeof(name), "sec%d", i);
+        value[0] = '9';
+        uassert_str_equal(fdb_kv_get(&test_kvdb, name), value);
+    }
+    /* the cache is NOT used when it can't cover all sectors */
+    test_fdb_kv_set_sec_cache(test_sec_cache_table, TEST_KVDB_SECTOR_NUM - 1);
+    uassert_null(test_kvdb.sector_cache_all);
+
+    test_fdb_kv_set_sec_cache(NULL, 0);
+    fdb_kv_set_default(&test_kvdb);
+}
+#endif /* FDB_KV_USING_CACHE */
+
+#ifdef FDB_KV_USING_INDEX_SNAPSHOT
+static void test_fdb_kv_set_snapshot(bool snapshot)
+{
+    test_fdb_kvdb_deinit();
+    fdb_kvdb_control(&test_kvdb, FDB_KVDB_CTRL_SET_SNAPSHOT, &snapshot);
+    test_fdb_kvdb_init();
+}
+
+/* reboot without saving the snapshot, as the power down */
+static void test_fdb_kv_snapshot_power_down(void)
+{
+    _fdb_file_ext_close(test_kvdb.snap_file);
+    test_kvdb.snap_file = -1;
+    fdb_reboot();
+}
+
+static void test_fdb_kv_snapshot_check(int round, int deleted)
+{
+    char name[16], value[16];
+    int i;
+
+    for (i = 0; i < 20; i++) {
+        rt_snprintf(name, sizeof(name), "snap%d", i);
+        if (i < deleted) {
+            uassert_null(fdb_kv_get(&test_kvdb, name));
+        } else {
+            rt_snprintf(value, sizeof(value), "%d", round * 100 + i);
+            uassert_str_equal(fdb_kv_get(&test_kvdb, name), value);
+        }
+    }
+}
+
+static void test_fdb_kv_snapshot_set(int round)
+{
+    char name[16], value[16];
+    int i;
+
+    for (i = 0; i < 20; i++) {
+        rt_snprintf(name, sizeof(name), "snap%d", i);
+        rt_snprintf(value, sizeof(value), "%d", round * 100 + i);
+        uassert_true(fdb_kv_set(&test_kvdb, name, value) == FDB_NO_ERR);
+    }
+}
+
+static void test_fdb_kv_snapshot(void)
+{
+    uint32_t garbage = 0;
+    int round;
+
+    test_fdb_kv_set_snapshot(true);
+    fdb_kv_set_default(&test_kvdb);
+    test_fdb_kv_snapshot_set(0);
+    /* the snapshot is saved when deinit */
+    fdb_reboot();
+    uassert_true(test_kvdb.snap_loaded);
+    test_fdb_kv_snapshot_check(0, 0);
+    /* the snapshot is consumed by the load, it's NOT loaded when power down */
+    test_fdb_kv_snapshot_power_down();
+    uassert_false(test_kvdb.snap_loaded);
+    test_fdb_kv_snapshot_check(0, 0);
+    /* the KVs which are changed after the snapshot are checked when boot */
+    uassert_true(fdb_kvdb_save_snapshot(&test_kvdb) == FDB_NO_ERR);
+    test_fdb_kv_snapshot_set(1);
+    uassert_true(fdb_kv_del(&test_kvdb, "snap0") == FDB_NO_ERR);
+    test_fdb_kv_snapshot_power_down();
+    uassert_true(test_kvdb.snap_loaded);
+    test_fdb_kv_snapshot_check(1, 1);
+    /* the snapshot is cleaned when the sector is erased by GC */
+    uassert_true(fdb_kvdb_save_snapshot(&test_kvdb) == FDB_NO_ERR);
+    for (round = 2; round < 40; round++) {
+        test_fdb_kv_snapshot_set(round);
+    }
+    test_fdb_kv_snapshot_power_down();
+    uassert_false(test_kvdb.snap_loaded);
+    test_fdb_kv_snapshot_check(round - 1, 0);
+    /* the snapshot which is broken is NOT loaded */
+    uassert_true(fdb_kvdb_save_snapshot(&test_kvdb) == FDB_NO_ERR);
+    _fdb_file_ext_write(test_kvdb.snap_file, sizeof(uint32_t) * 8, &garbage, sizeof(garbage));
+    test_fdb_kv_snapshot_power_down();
+    uassert_false(test_kvdb.snap_loaded);
+    test_fdb_kv_snapshot_check(round - 1, 0);
+    fdb_reboot();
+    uassert_true(test_kvdb.snap_loaded);
+    test_fdb_kv_snapshot_check(round - 1, 0);
+    /* the snapshot is NOT loaded after the sectors are erased by the session without the snapshot mode */
+    test_fdb_kv_set_snapshot(false);
+    for (round = 40; round < 80; round++) {
+        test_fdb_kv_snapshot_set(round);
+    }
+    test_fdb_kv_set_snapshot(true);
+    uassert_false(test_kvdb.snap_loaded);
+    test_fdb_kv_snapshot_check(round - 1, 0);
+
+    test_fdb_kv_set_snapshot(false);
+    fdb_kv_set_default(&test_kvdb);
+}
+#endif /* FDB_KV_USING_INDEX_SNAPSHOT */
+
+#ifdef FDB_KV_USING_LAZY_LOAD
+static void test_fdb_kv_set_lazy_load(bool lazy_load)
+{
+    test_fdb_kvdb_deinit();
+    fdb_kvdb_control(&test_kvdb, FDB_KVDB_CTRL_SET_LAZY_LOAD, &lazy_load);
+    test_fdb_kvdb_init();
+}
+
+static void test_fdb_kv_lazy_load(void)
+{
+    test_fdb_kv_set_lazy_load(true);
+    fdb_kv_set_default(&test_kvdb);
+#ifdef FDB_KV_AUTO_UPDATE
+    /* the version KV is saved on the first boot after set default, it finishes the lazy load */
+    fdb_reboot();
+#endif
+    uassert_true(fdb_kv_set(&test_kvdb, "lazy0", "old0") == FDB_NO_ERR);
+    uassert_true(fdb_kv_set(&test_kvdb, "lazy0", "new0") == FDB_NO_ERR);
+    uassert_true(fdb_kv_set(&test_kvdb, "lazy1", "new1") == FDB_NO_ERR);
+    fdb_reboot();
+    /* the KV is read before the recovery check */
+    uassert_true(test_kvdb.lazy_pending);
+    test_fdb_kv_batch_check("lazy0", "new0");
+    test_fdb_kv_batch_check("lazy1", "new1");
+    test_fdb_kv_batch_check("lazy2", NULL);
+    uassert_true(test_kvdb.lazy_pending);
+    /* the recovery check is done by the first modification */
+    uassert_true(fdb_kv_set(&test_kvdb, "lazy2", "new2") == FDB_NO_ERR);
+    uassert_false(test_kvdb.lazy_pending);
+    test_fdb_kv_batch_check("lazy0", "new0");
+    test_fdb_kv_batch_check("lazy2", "new2");
+
+#ifdef FDB_USING_FILE_POSIX_MODE
+    {
+        const char *keys[] = { "lazy0", "lazy1" };
+        struct fdb_kv old_kv, new_kv0, new_kv1;
+        struct fdb_blob blobs[2];
+        uint32_t batch_addr;
+
+        /* power down when the KV is changing, the old value is read until it's recovered */
+        fdb_kv_set_default(&test_kvdb);
+#ifdef FDB_KV_AUTO_UPDATE
+        fdb_reboot();
+#endif
+        uassert_true(fdb_kv_set(&test_kvdb, "lazy0", "old0") == FDB_NO_ERR);
+        uassert_not_null(fdb_kv_get_obj(&test_kvdb, "lazy0", &old_kv));
+        uassert_true(fdb_kv_set(&test_kvdb, "lazy0", "new0") == FDB_NO_ERR);
+        uassert_not_null(fdb_kv_get_obj(&test_kvdb, "lazy0", &new_kv0));
+        test_fdb_kv_batch_set_status(old_kv.addr.start, FDB_KV_PRE_DELETE);
+        test_fdb_kv_batch_set_status(new_kv0.addr.start, FDB_KV_PRE_WRITE);
+        fdb_reboot();
+        test_fdb_kv_batch_check("lazy0", "old0");
+        uassert_true(fdb_kvdb_finish_load(&test_kvdb) == FDB_NO_ERR);
+        uassert_false(test_kvdb.lazy_pending);
+        test_fdb_kv_batch_check("lazy0", "old0");
+
+        /* power down after the batch is committed, the new values are read */
+        fdb_kv_set_default(&test_kvdb);
+#ifdef FDB_KV_AUTO_UPDATE
+        fdb_reboot();
+#endif
+        uassert_true(fdb_kv_set(&test_kvdb, "lazy0", "old0") == FDB_NO_ERR);
+        uassert_not_null(fdb_kv_get_obj(&test_kvdb, "lazy0", &old_kv));
+        batch_addr = old_kv.addr.start + old_kv.len;
+        fdb_blob_make(&blobs[0], "new0", 4);
+        fdb_blob_make(&blobs[1], "new1", 4);
+        uassert_true(fdb_kv_set_batch(&test_kvdb, keys, blobs, 2) == FDB_NO_ERR);
+        uassert_not_null(fdb_kv_get_obj(&test_kvdb, "lazy0", &new_kv0));
+        uassert_not_null(fdb_kv_get_obj(&test_kvdb, "lazy1", &new_kv1));
+        test_fdb_kv_batch_set_status(old_kv.addr.start, FDB_KV_WRITE);
+        test_fdb_kv_batch_set_status(batch_addr, FDB_KV_WRITE);
+        test_fdb_kv_batch_set_status(new_kv0.addr.start, FDB_KV_PRE_WRITE);
+        test_fdb_kv_batch_set_status(new_kv1.addr.start, FDB_KV_PRE_WRITE);
+        fdb_reboot();
+        uassert_true(test_kvdb.lazy_pending);
+        test_fdb_kv_batch_check("lazy0", "new0");
+        test_fdb_kv_batch_check("lazy1", "new1");
+        uassert_true(fdb_kvdb_finish_load(&test_kvdb) == FDB_NO_ERR);
+        test_fdb_kv_batch_check("lazy0", "new0");
+        test_fdb_kv_batch_check("lazy1", "new1");
+    }
+#endif /* FDB_USING_FILE_POSIX_MODE */
+
+    test_fdb_kv_set_lazy_load(false);
+    fdb_kv_set_default(&test_kvdb);
+}
+#endif /* FDB_KV_USING_LAZY_LOAD */
+
+#ifdef FDB_KV_USING_COUNTER
+static void test_fdb_kv_counter(void)
+{
+    static uint8_t buf[TEST_KV_VALUE_LEN];
+    struct fdb_blob blob;
+    struct fdb_kv kv;
+    uint32_t value = 0, addr, i;
+
+    fdb_kv_set_default(&test_kvdb);
+    uassert_true(fdb_kv_counter_get(&test_kvdb, "cnt", &value) == FDB_KV_NAME_ERR);
+    /* the counter is created by the first increment */
+    uassert_true(fdb_kv_counter_inc(&test_kvdb, "cnt", &value) == FDB_NO_ERR);
+    uassert_int_equal(value, 1);
+    uassert_not_null(fdb_kv_get_obj(&test_kvdb, "cnt", &kv));
+    addr = kv.addr.start;
+    /* the counter is increased in place until all steps are used */
+    for (i = 1; i <= FDB_KV_COUNTER_STEPS; i++) {
+        uassert_true(fdb_kv_counter_inc(&test_kvdb, "cnt", &value) == FDB_NO_ERR);
+        uassert_int_equal(value, i + 1);
+        uassert_not_null(fdb_kv_get_obj(&test_kvdb, "cnt", &kv));
+        uassert_true(kv.addr.start == addr);
+    }
+    uassert_true(fdb_kv_counter_inc(&test_kvdb, "cnt", &value) == FDB_NO_ERR);
+    uassert_int_equal(value, FDB_KV_COUNTER_STEPS + 2);
+    uassert_not_null(fdb_kv_get_obj(&test_kvdb, "cnt", &kv));
+    uassert_true(kv.addr.start != addr);
+    uassert_true(fdb_kv_counter_inc(&test_kvdb, "cnt", NULL) == FDB_NO_ERR);
+    fdb_reboot();
+    uassert_true(fdb_kv_counter_get(&test_kvdb, "cnt", &value) == FDB_NO_ERR);
+    uassert_int_equal(value, FDB_KV_COUNTER_STEPS + 3);
+
+    /* the used steps are kept when the counter is moved by GC */
+    uassert_not_null(fdb_kv_get_obj(&test_kvdb, "cnt", &kv));
+    addr = kv.addr.start;
+    for (i = 0; i < 100 && kv.addr.start == addr; i++) {
+        uassert_true(fdb_kv_set_blob(&test_kvdb, "cnt_fill", fdb_blob_make(&blob, buf, sizeof(buf))) == FDB_NO_ERR);
+        uassert_not_null(fdb_kv_get_obj(&test_kvdb, "cnt", &kv));
+    }
+    uassert_true(kv.addr.start != addr);
+    uassert_true(fdb_kv_counter_get(&test_kvdb, "cnt", &value) == FDB_NO_ERR);
+    uassert_int_equal(value, FDB_KV_COUNTER_STEPS + 3);
+    uassert_true(fdb_kv_counter_inc(&test_kvdb, "cnt", &value) == FDB_NO_ERR);
+    uassert_int_equal(value, FDB_KV_COUNTER_STEPS + 4);
+    fdb_reboot();
+    uassert_true(fdb_kv_counter_get(&test_kvdb, "cnt", &value) == FDB_NO_ERR);
+    uassert_int_equal(value, FDB_KV_COUNTER_STEPS + 4);
+
+    /* set the counter value */
+    uassert_true(fdb_kv_counter_set(&test_kvdb, "cnt", 1000) == FDB_NO_ERR);
+    uassert_true(fdb_kv_counter_inc(&test_kvdb, "cnt", &value) == FDB_NO_ERR);
+    uassert_int_equal(value, 1001);
+    /* the KV which is NOT a counter */
+    uassert_true(fdb_kv_set(&test_kvdb, "cnt_str", "1") == FDB_NO_ERR);
+    uassert_true(fdb_kv_counter_inc(&test_kvdb, "cnt_str", &value) == FDB_KV_NAME_ERR);
+    uassert_true(fdb_kv_counter_get(&test_kvdb, "cnt_str", &value) == FDB_KV_NAME_ERR);
+    uassert_true(fdb_kv_del(&test_kvdb, "cnt") == FDB_NO_ERR);
+    uassert_true(fdb_kv_counter_get(&test_kvdb, "cnt", &value) == FDB_KV_NAME_ERR);
+
+    fdb_kv_set_default(&test_kvdb);
+}
+#endif /* FDB_KV_USING_COUNTER */
+
+#ifdef FDB_KV_USING_LARGE_BLOB
+#define TEST_KV_LARGE_LEN              4500 /* bigger than a sector */
+
+static void test_fdb_kv_large_blob_write(const char *key, uint8_t seed, size_t len, bool end)
+{
+    static struct fdb_kv_blob_writer writer;
+    uint8_t buf[100];
+    size_t i, size;
+
+    uassert_true(fdb_kv_set_blob_begin(&test_kvdb, key, &writer) == FDB_NO_ERR);
+    for (i = 0; i < len; i += size) {
+        /* the odd size is written across the chunk KVs */
+        for (size = 0; size < 77 && i + size < len; size++) {
+            buf[size] = (uint8_t)((i + size) * 7 + seed);
+        }
+        uassert_true(fdb_kv_set_blob_write(&test_kvdb, &writer, buf, size) == FDB_NO_ERR);
+    }
+    if (end) {
+        uassert_true(fdb_kv_set_blob_end(&test_kvdb, &writer) == FDB_NO_ERR);
+    }
+}
+
+static void test_fdb_kv_large_blob_check(const char *key, uint8_t seed, size_t len)
+{
+    static uint8_t value[TEST_KV_LARGE_LEN];
+    struct fdb_blob blob;
+    size_t i;
+
+    memset(value, 0, sizeof(value));
+    uassert_int_equal(fdb_kv_get_blob(&test_kvdb, key, fdb_blob_make(&blob, value, sizeof(value))), len);
+    uassert_int_equal(blob.saved.len, len);
+    for (i = 0; i < len; i++) {
+        if (value[i] != (uint8_t)(i * 7 + seed)) {
+            break;
+        }
+    }
+    uassert_int_equal(i, len);
+}
+
+static void test_fdb_kv_large_blob(void)
+{
+    struct fdb_kv_iterator iterator;
+    struct fdb_blob blob;
+    uint8_t buf[100];
+    size_t i, num;
+    char value[8];
+
+    fdb_kv_set_default(&test_kvdb);
+    test_fdb_kv_large_blob_write("large", 1, TEST_KV_LARGE_LEN, true);
+    test_fdb_kv_large_blob_check("large", 1, TEST_KV_LARGE_LEN);
+    /* read a part of the value */
+    uassert_int_equal(fdb_kv_read_blob_at(&test_kvdb, "large", 1000, buf, sizeof(buf)), sizeof(buf));
+    for (i = 0; i < sizeof(buf) && buf[i] == (uint8_t)((1000 + i) * 7 + 1); i++);
+    uassert_int_equal(i, sizeof(buf));
+    uassert_int_equal(fdb_kv_read_blob_at(&test_kvdb, "large", TEST_KV_LARGE_LEN - 50, buf, sizeof(buf)), 50);
+    uassert_int_equal(fdb_kv_read_blob_at(&test_kvdb, "large", TEST_KV_LARGE_LEN, buf, sizeof(buf)), 0);
+    /* the chunk KVs are NOT iterated */
+    fdb_kv_iterator_init(&test_kvdb, &iterator);
+    for (num = 0; fdb_kv_iterate(&test_kvdb, &iterator);) {
+        num += !strncmp(iterator.curr_kv.name, "large", 5);
+    }
+    uassert_int_equal(num, 1);
+
+    /* replace the value, then reboot */
+    test_fdb_kv_large_blob_write("large", 2, TEST_KV_LARGE_LEN - 1000, true);
+    test_fdb_kv_large_blob_check("large", 2, TEST_KV_LARGE_LEN - 1000);
+    fdb_reboot();
+    test_fdb_kv_large_blob_check("large", 2, TEST_KV_LARGE_LEN - 1000);
+
+    /* the old value is kept when the writing is NOT ended */
+    test_fdb_kv_large_blob_write("large", 3, TEST_KV_LARGE_LEN, false);
+    test_fdb_kv_large_blob_check("large", 2, TEST_KV_LARGE_LEN - 1000);
+    fdb_reboot();
+    test_fdb_kv_large_blob_check("large", 2, TEST_KV_LARGE_LEN - 1000);
+    /* the chunk KVs of the unfinished writing are dropped */
+    test_fdb_kv_large_blob_write("large", 4, TEST_KV_LARGE_LEN, true);
+    test_fdb_kv_large_blob_check("large", 4, TEST_KV_LARGE_LEN);
+
+    /* the large KV is replaced by a normal KV, and deleted with its chunk KVs */
+    uassert_true(fdb_kv_set(&test_kvdb, "large", "small") == FDB_NO_ERR);
+    uassert_int_equal(fdb_kv_read_blob_at(&test_kvdb, "large", 1, value, sizeof(value)), 4);
+    uassert_true(!memcmp(value, "mall", 4));
+    test_fdb_kv_large_blob_write("large", 5, TEST_KV_LARGE_LEN, true);
+    test_fdb_kv_large_blob_check("large", 5, TEST_KV_LARGE_LEN);
+    uassert_true(fdb_kv_del(&test_kvdb, "large") == FDB_NO_ERR);
+    uassert_int_equal(fdb_kv_get_blob(&test_kvdb, "large", fdb_blob_make(&blob, buf, sizeof(buf))), 0);
+    /* the chunk KV name is the large KV name + 0x1F + generation + chunk index */
+    for (i = 0; i < TEST_KV_LARGE_LEN / 1024 + 1; i++) {
+        rt_snprintf((char *)buf, sizeof(buf), "large%c0%04X", 0x1F, (int)i);
+        uassert_null(fdb_kv_get_obj(&test_kvdb, (char *)buf, &iterator.curr_kv));
+        rt_snprintf((char *)buf, sizeof(buf), "large%c1%04X", 0x1F, (int)i);
+        uassert_null(fdb_kv_get_obj(&test_kvdb, (char *)buf, &iterator.curr_kv));
+    }
+
+    /* the large KV is replaced by a batch, its chunk KVs are deleted after the batch is committed */
+    test_fdb_kv_large_blob_write("large", 6, TEST_KV_LARGE_LEN, true);
+    {
+        const char *keys[] = { "large" };
+        struct fdb_blob blobs[1];
+
+        fdb_blob_make(&blobs[0], "batch", 5);
+        uassert_true(fdb_kv_set_batch(&test_kvdb, keys, blobs, 1) == FDB_NO_ERR);
+    }
+    uassert_int_equal(fdb_kv_get_blob(&test_kvdb, "large", fdb_blob_make(&blob, value, sizeof(value))), 5);
+    uassert_true(!memcmp(value, "batch", 5));
+    for (i = 0; i < TEST_KV_LARGE_LEN / 1024 + 1; i++) {
+        rt_snprintf((char *)buf, sizeof(buf), "large%c0%04X", 0x1F, (int)i);
+        uassert_null(fdb_kv_get_obj(&test_kvdb, (char *)buf, &iterator.curr_kv));
+        rt_snprintf((char *)buf, sizeof(buf), "large%c1%04X", 0x1F, (int)i);
+        uassert_null(fdb_kv_get_obj(&test_kvdb, (char *)buf, &iterator.curr_kv));
+    }
+
+    fdb_kv_set_default(&test_kvdb);
+}
+#endif /* FDB_KV_USING_LARGE_BLOB */
+
+#ifdef FDB_KV_USING_RW_LOCK
+static size_t test_rdlock_cnt, test_wrlock_cnt;
+static bool test_rd_held, test_wr_held;
+
+static void test_rdlock(fdb_db_t db)
+{
+    /* the reader is NOT nested in the writer */
+    uassert_false(test_wr_held);
+    test_rd_held = true;
+    test_rdlock_cnt++;
+}
+
+static void test_rdunlock(fdb_db_t db)
+{
+    test_rd_held = false;
+}
+
+static void test_wrlock(fdb_db_t db)
+{
+    uassert_false(test_rd_held);
+    test_wr_held = true;
+    test_wrlock_cnt++;
+}
+
+static void test_wrunlock(fdb_db_t db)
+{
+    test_wr_held = false;
+}
+
+static void test_fdb_kv_rw_lock(void)
+{
+    struct fdb_kv_iterator iterator;
+    struct fdb_blob blob;
+    struct fdb_kv kv;
+    char value[16];
+    size_t i, num;
+
+    fdb_kv_set_default(&test_kvdb);
+    fdb_kvdb_control(&test_kvdb, FDB_KVDB_CTRL_SET_LOCK, (void *)test_wrlock);
+    fdb_kvdb_control(&test_kvdb, FDB_KVDB_CTRL_SET_UNLOCK, (void *)test_wrunlock);
+    fdb_kvdb_control(&test_kvdb, FDB_KVDB_CTRL_SET_RDLOCK, (void *)test_rdlock);
+    fdb_kvdb_control(&test_kvdb, FDB_KVDB_CTRL_SET_RDUNLOCK, (void *)test_rdunlock);
+    test_rdlock_cnt = test_wrlock_cnt = 0;
+
+    /* the writer takes the exclusive lock */
+    for (i = 0; i < 10; i++) {
+        rt_snprintf(value, sizeof(value), "rw_%d", (int)i);
+        uassert_true(fdb_kv_set(&test_kvdb, value, value) == FDB_NO_ERR);
+    }
+    uassert_int_equal(test_rdlock_cnt, 0);
+    uassert_int_equal(test_wrlock_cnt, 10);
+
+    /* the readers take the shared read lock, the value is read without the KV and file cache changed */
+    test_wrlock_cnt = 0;
+    for (i = 0; i < 10; i++) {
+        char key[16];
+
+        rt_snprintf(key, sizeof(key), "rw_%d", (int)i);
+        memset(value, 0, sizeof(value));
+        uassert_int_equal(fdb_kv_get_blob(&test_kvdb, key, fdb_blob_make(&blob, value, sizeof(value))), strlen(key));
+        uassert_str_equal(value, key);
+        uassert_not_null(fdb_kv_get_obj(&test_kvdb, key, &kv));
+    }
+    uassert_null(fdb_kv_get_obj(&test_kvdb, "rw_none", &kv));
+    fdb_kv_iterator_init(&test_kvdb, &iterator);
+    for (num = 0; fdb_kv_iterate_prefix(&test_kvdb, &iterator, "rw_"); num++);
+    uassert_int_equal(num, 10);
+    uassert_int_equal(test_rdlock_cnt, 10 * 2 + 1 + 11);
+    uassert_int_equal(test_wrlock_cnt, 0);
+
+    /* the KV is changed by the writer between the readers */
+    uassert_true(fdb_kv_set(&test_kvdb, "rw_0", "new") == FDB_NO_ERR);
+    memset(value, 0, sizeof(value));
+    uassert_int_equal(fdb_kv_get_blob(&test_kvdb, "rw_0", fdb_blob_make(&blob, value, sizeof(value))), 3);
+    uassert_str_equal(value, "new");
+    uassert_false(test_rd_held || test_wr_held);
+
+    fdb_kvdb_control(&test_kvdb, FDB_KVDB_CTRL_SET_RDLOCK, NULL);
+    fdb_kvdb_control(&test_kvdb, FDB_KVDB_CTRL_SET_RDUNLOCK, NULL);
+    fdb_kvdb_control(&test_kvdb, FDB_KVDB_CTRL_SET_LOCK, NULL);
+    fdb_kvdb_control(&test_kvdb, FDB_KVDB_CTRL_SET_UNLOCK, NULL);
+    /* the reader takes the exclusive lock when the shared read lock is NOT set */
+    memset(value, 0, sizeof(value));
+    uassert_int_equal(fdb_kv_get_blob(&test_kvdb, "rw_1", fdb_blob_make(&blob, value, sizeof(value))), 4);
+    uassert_str_equal(value, "rw_1");
+
+    fdb_kv_set_default(&test_kvdb);
+}
+#endif /* FDB_KV_USING_RW_LOCK */
+
+#ifdef FDB_KV_USING_COMPRESS
+#define TEST_KV_COMP_LEN               600
+
+static void test_fdb_kv_compress_make(uint8_t *value, size_t len, int seed)
+{
+    size_t i;
+
+    /* the JSON like value compresses well */
+    for (i = 0; i + 1 < len; i += rt_strlen((char *)value + i)) {
+        rt_snprintf((char *)value + i, len - i, "{\"id\":%d,\"name\":\"sensor\",\"gain\":1.0},", (int)(seed + i / 40));
+    }
+}
+
+static void test_fdb_kv_compress_check(const char *key, int seed)
+{
+    static uint8_t value[TEST_KV_COMP_LEN], read_value[TEST_KV_COMP_LEN];
+    struct fdb_blob blob;
+    struct fdb_kv kv;
+
+    test_fdb_kv_compress_make(value, sizeof(value), seed);
+    memset(read_value, 0, sizeof(read_value));
+    uassert_int_equal(fdb_kv_get_blob(&test_kvdb, key, fdb_blob_make(&blob, read_value, sizeof(read_value))),
+            sizeof(value));
+    uassert_int_equal(blob.saved.len, sizeof(value));
+    uassert_buf_equal(read_value, value, sizeof(value));
+    /* the compressed value is saved on flash */
+    uassert_not_null(fdb_kv_get_obj(&test_kvdb, key, &kv));
+    uassert_true(kv.value_len < sizeof(value) / 2);
+}
+
+static void test_fdb_kv_compress(void)
+{
+    static uint8_t value[TEST_KV_COMP_LEN];
+    uint8_t head[50];
+    struct fdb_blob blob;
+    struct fdb_kv kv;
+    bool compress = true;
+    size_t i;
+    char *str;
+
+    fdb_kv_set_default(&test_kvdb);
+    fdb_kvdb_control(&test_kvdb, FDB_KVDB_CTRL_SET_COMPRESS, &compress);
+
+    test_fdb_kv_compress_make(value, sizeof(value), 0);
+    uassert_true(fdb_kv_set_blob(&test_kvdb, "comp", fdb_blob_make(&blob, value, sizeof(value))) == FDB_NO_ERR);
+    test_fdb_kv_compress_check("comp", 0);
+    /* only the head is decompressed to the smaller buffer */
+    uassert_int_equal(fdb_kv_get_blob(&test_kvdb, "comp", fdb_blob_make(&blob, head, sizeof(head))), sizeof(head));
+    uassert_int_equal(blob.saved.len, sizeof(value));
+    uassert_buf_equal(head, value, sizeof(head));
+#ifdef FDB_KV_USING_LARGE_BLOB
+    uassert_int_equal(fdb_kv_read_blob_at(&test_kvdb, "comp", 100, head, sizeof(head)), sizeof(head));
+    uassert_buf_equal(head, value + 100, sizeof(head));
+    uassert_int_equal(fdb_kv_read_blob_at(&test_kvdb, "comp", sizeof(value) - 10, head, sizeof(head)), 10);
+    uassert_buf_equal(head, value + sizeof(value) - 10, 10);
+    uassert_int_equal(fdb_kv_read_blob_at(&test_kvdb, "comp", sizeof(value), head, sizeof(head)), 0);
+#ifdef FDB_KV_USING_RW_LOCK
+    /* the value before the offset is decompressed to the shared buffer with the exclusive lock */
+    fdb_kvdb_control(&test_kvdb, FDB_KVDB_CTRL_SET_LOCK, (void *)test_wrlock);
+    fdb_kvdb_control(&test_kvdb, FDB_KVDB_CTRL_SET_UNLOCK, (void *)test_wrunlock);
+    fdb_kvdb_control(&test_kvdb, FDB_KVDB_CTRL_SET_RDLOCK, (void *)test_rdlock);
+    fdb_kvdb_control(&test_kvdb, FDB_KVDB_CTRL_SET_RDUNLOCK, (void *)test_rdunlock);
+    test_rdlock_cnt = test_wrlock_cnt = 0;
+    uassert_int_equal(fdb_kv_read_blob_at(&test_kvdb, "comp", 0, head, sizeof(head)), sizeof(head));
+    uassert_buf_equal(head, value, sizeof(head));
+    uassert_true(test_rdlock_cnt == 1 && test_wrlock_cnt == 0);
+    uassert_int_equal(fdb_kv_read_blob_at(&test_kvdb, "comp", 200, head, sizeof(head)), sizeof(head));
+    uassert_buf_equal(head, value + 200, sizeof(head));
+    uassert_true(test_rdlock_cnt == 2 && test_wrlock_cnt == 1);
+    uassert_false(test_rd_held || test_wr_held);
+    fdb_kvdb_control(&test_kvdb, FDB_KVDB_CTRL_SET_RDLOCK, NULL);
+    fdb_kvdb_control(&test_kvdb, FDB_KVDB_CTRL_SET_RDUNLOCK, NULL);
+    fdb_kvdb_control(&test_kvdb, FDB_KVDB_CTRL_SET_LOCK, NULL);
+    fdb_kvdb_control(&test_kvdb, FDB_KVDB_CTRL_SET_UNLOCK, NULL);
+#endif
+#endif
+    /* the string KV */
+    rt_snprintf((char *)value, 101, "%0100d", 0);
+    uassert_true(fdb_kv_set(&test_kvdb, "comp_str", (char *)value) == FDB_NO_ERR);
+    uassert_not_null(fdb_kv_get_obj(&test_kvdb, "comp_str", &kv));
+    uassert_true(kv.value_len < 100);
+    str = fdb_kv_get(&test_kvdb, "comp_str");
+    uassert_not_null(str);
+    uassert_str_equal(str, (char *)value);
+
+    /* the small and incompressible value is saved raw */
+    uassert_true(fdb_kv_set(&test_kvdb, "comp_small", "small") == FDB_NO_ERR);
+    uassert_not_null(fdb_kv_get_obj(&test_kvdb, "comp_small", &kv));
+    uassert_int_equal(kv.value_len, 5);
+    for (i = 0; i < 200; i++) {
+        value[i] = (uint8_t)((i * 2654435761U) >> 13);
+    }
+    uassert_true(fdb_kv_set_blob(&test_kvdb, "comp_rand", fdb_blob_make(&blob, value, 200)) == FDB_NO_ERR);
+    uassert_not_null(fdb_kv_get_obj(&test_kvdb, "comp_rand", &kv));
+    uassert_int_equal(kv.value_len, 200);
+
+    /* the compressed KV is moved by GC */
+    for (i = 0; i < TEST_KVDB_SECTOR_NUM * TEST_KVDB_SECTOR_SIZE / 100; i++) {
+        test_fdb_kv_compress_make(value, sizeof(value), (int)i + 1);
+        uassert_true(fdb_kv_set_blob(&test_kvdb, "comp_gc", fdb_blob_make(&blob, value, sizeof(value))) == FDB_NO_ERR);
+    }
+    test_fdb_kv_compress_check("comp_gc", (int)i);
+    test_fdb_kv_compress_check("comp", 0);
+    fdb_reboot();
+    test_fdb_kv_compress_check("comp", 0);
+
+    /* the compressed KV is read after the compression is disabled */
+    compress = false;
+    fdb_kvdb_control(&test_kvdb, FDB_KVDB_CTRL_SET_COMPRESS, &compress);
+    test_fdb_kv_compress_check("comp", 0);
+    test_fdb_kv_compress_make(value, sizeof(value), 0);
+    uassert_true(fdb_kv_set_blob(&test_kvdb, "comp", fdb_blob_make(&blob, value, sizeof(value))) == FDB_NO_ERR);
+    uassert_not_null(fdb_kv_get_obj(&test_kvdb, "comp", &kv));
+    uassert_int_equal(kv.value_len, sizeof(value));
+
+    fdb_kv_set_default(&test_kvdb);
+}
+#endif /* FDB_KV_USING_COMPRESS */
+
+#ifdef FDB_KV_USING_INCREMENTAL_GC
+#define TEST_KV_GC_STEP_NUM            40
+
+static void test_fdb_kv_gc_step_check(int round)
+{
+    char name[16];
+    int i, value;
+    struct fdb_blob blob;
+
+    for (i = 0; i < TEST_KV_GC_STEP_NUM; i++) {
+        rt_snprintf(name, sizeof(name), "gc%d", i);
+        value = -1;
+        uassert_true(fdb_kv_get_blob(&test_kvdb, name, fdb_blob_make(&blob, &value, sizeof(value))) == sizeof(value));
+        uassert_int_equal(value, round * 1000 + i);
+    }
+}
+
+static void test_fdb_kv_gc_step(void)
+{
+    char name[16];
+    int i, round, value, steps = 0;
+    size_t budget = 1;
+    struct fdb_blob blob;
+
+    fdb_kv_set_default(&test_kvdb);
+    /* only one KV is moved by each set */
+    fdb_kvdb_control(&test_kvdb, FDB_KVDB_CTRL_SET_GC_BUDGET, &budget);
+    for (round = 0; round < 8; round++) {
+        for (i = 0; i < TEST_KV_GC_STEP_NUM; i++) {
+            rt_snprintf(name, sizeof(name), "gc%d", i);
+            value = round * 1000 + i;
+            uassert_true(fdb_kv_set_blob(&test_kvdb, name, fdb_blob_make(&blob, &value, sizeof(value))) == FDB_NO_ERR);
+        }
+        test_fdb_kv_gc_step_check(round);
+    }
+    /* finish the GC in the idle time */
+    while (fdb_kvdb_gc_step(&test_kvdb, 64) && steps < 1000) {
+        steps++;
+    }
+    uassert_true(steps < 1000);
+    uassert_true(test_kvdb.gc_sec_addr == 0xFFFFFFFF);
+    test_fdb_kv_gc_step_check(round - 1);
+    fdb_reboot();
+    test_fdb_kv_gc_step_check(round - 1);
+
+    fdb_kv_set_default(&test_kvdb);
+}
+#endif /* FDB_KV_USING_INCREMENTAL_GC */
+
 static void test_fdb_kvdb_set_default(void)
 {
     uassert_true(fdb_kv_set_default(&test_kvdb) == FDB_NO_ERR);
@@ -896,8 +2000,50 @@ static void testcase(void)
     UTEST_UNIT_RUN(test_fdb_create_kv);
     UTEST_UNIT_RUN(test_fdb_change_kv);
     UTEST_UNIT_RUN(test_fdb_del_kv);
+    UTEST_UNIT_RUN(test_fdb_kv_cache_name);
+#if defined(FDB_KV_CRC_VERIFY_ONCE) && defined(FDB_USING_FILE_POSIX_MODE)
+    UTEST_UNIT_RUN(test_fdb_kv_verify_once);
+#endif
+#ifdef FDB_USING_FILE_POSIX_MODE
+    UTEST_UNIT_RUN(test_fdb_kv_scan_magic);
+#endif
+    UTEST_UNIT_RUN(test_fdb_kv_set_batch);
+    UTEST_UNIT_RUN(test_fdb_kv_iterate_by_name);
     UTEST_UNIT_RUN(test_fdb_gc);
     UTEST_UNIT_RUN(test_fdb_gc2);
+#ifdef FDB_KV_USING_GC_COST_BENEFIT
+    UTEST_UNIT_RUN(test_fdb_gc_cost_benefit);
+#endif
+#ifdef FDB_KV_USING_INDEX
+    UTEST_UNIT_RUN(test_fdb_kv_index);
+#endif
+#ifdef FDB_KV_USING_FREE_MAP
+    UTEST_UNIT_RUN(test_fdb_kv_free_map);
+#endif
+#ifdef FDB_KV_USING_CACHE
+    UTEST_UNIT_RUN(test_fdb_kv_sec_cache);
+#endif
+#ifdef FDB_KV_USING_INDEX_SNAPSHOT
+    UTEST_UNIT_RUN(test_fdb_kv_snapshot);
+#endif
+#ifdef FDB_KV_USING_LAZY_LOAD
+    UTEST_UNIT_RUN(test_fdb_kv_lazy_load);
+#endif
+#ifdef FDB_KV_USING_COUNTER
+    UTEST_UNIT_RUN(test_fdb_kv_counter);
+#endif
+#ifdef FDB_KV_USING_LARGE_BLOB
+    UTEST_UNIT_RUN(test_fdb_kv_large_blob);
+#endif
+#ifdef FDB_KV_USING_RW_LOCK
+    UTEST_UNIT_RUN(test_fdb_kv_rw_lock);
+#endif
+#ifdef FDB_KV_USING_COMPRESS
+    UTEST_UNIT_RUN(test_fdb_kv_compress);
+#endif
+#ifdef FDB_KV_USING_INCREMENTAL_GC
+    UTEST_UNIT_RUN(test_fdb_kv_gc_step);
+#endif
     UTEST_UNIT_RUN(test_fdb_scale_up);
     UTEST_UNIT_RUN(test_fdb_kvdb_set_default);
     UTEST_UNIT_RUN(test_fdb_kvdb_deinit);
@@ -407,6 +407,913 @@ static void test_fdb_tsl_iter_by_time_1(void)
     test_fdb_tsl_sector_bound_test(2, 2);
 }
 
+#ifdef FDB_TSDB_USING_TIME_DELTA
+static bool test_fdb_tsl_time_delta_cb(fdb_tsl_t tsl, void *arg)
+{
+    fdb_tsl_t tsl_buf = arg;
+
+    *tsl_buf = *tsl;
+
+    return true;
+}
+
+static void test_fdb_tsl_time_delta(void)
+{
+    struct fdb_blob blob;
+    struct fdb_tsl first, last;
+    int data = 0;
+    /* more than 32-bit delta from the sector start time */
+    fdb_time_t long_time = (fdb_time_t)UINT32_MAX + 2;
+
+    fdb_tsl_clean(&test_tsdb);
+    uassert_true(fdb_tsl_append_with_ts(&test_tsdb, fdb_blob_make(&blob, &data, sizeof(data)), 1) == FDB_NO_ERR);
+    uassert_true(fdb_tsl_append_with_ts(&test_tsdb, fdb_blob_make(&blob, &data, sizeof(data)), long_time) == FDB_NO_ERR);
+
+    fdb_reboot();
+
+    uassert_true(fdb_tsl_query_count(&test_tsdb, 0, long_time, FDB_TSL_WRITE) == 2);
+    fdb_tsl_iter(&test_tsdb, test_fdb_tsl_time_delta_cb, &first);
+    uassert_true(first.time == 1);
+    fdb_tsl_iter_reverse(&test_tsdb, test_fdb_tsl_time_delta_cb, &last);
+    uassert_true(last.time == long_time);
+    /* the long delta TSL MUST be saved to the next sector */
+    uassert_true(RT_ALIGN_DOWN(first.addr.index, TEST_SECTOR_SIZE) != RT_ALIGN_DOWN(last.addr.index, TEST_SECTOR_SIZE));
+
+    fdb_tsl_clean(&test_tsdb);
+}
+#endif /* FDB_TSDB_USING_TIME_DELTA */
+
+struct test_snapshot_args {
+    size_t count;
+    fdb_time_t last_time;
+    bool reverse;
+    int append_period;                           /**< append some new TSL every N callbacks, 0: not append */
+    int append_num;
+    bool append_once;
+};
+
+/* the TSL data is the same as its timestamp */
+static void test_fdb_tsl_append_time(int count)
+{
+    struct fdb_blob blob;
+    fdb_time_t time;
+
+    while (count-- > 0) {
+        time = get_time();
+        uassert_true(fdb_tsl_append_with_ts(&test_tsdb, fdb_blob_make(&blob, &time, sizeof(time)), time) == FDB_NO_ERR);
+    }
+}
+
+static bool test_fdb_tsl_snapshot_cb(fdb_tsl_t tsl, void *arg)
+{
+    struct test_snapshot_args *args = arg;
+    struct fdb_blob blob;
+    fdb_time_t data = 0;
+
+    fdb_blob_read((fdb_db_t) &test_tsdb, fdb_tsl_to_blob(tsl, fdb_blob_make(&blob, &data, sizeof(data))));
+    uassert_true(data == tsl->time);
+    if (args->count > 0) {
+        uassert_true(args->reverse ? tsl->time < args->last_time : tsl->time > args->last_time);
+    }
+    args->last_time = tsl->time;
+    args->count++;
+    /* the appender works during the iteration */
+    if (args->append_period && args->count % args->append_period == 0) {
+        test_fdb_tsl_append_time(args->append_num);
+        if (args->append_once) {
+            args->append_period = 0;
+        }
+    }
+
+    return false;
+}
+
+/* the sector of the first TSL is recycled by the appender before the blob is read */
+static bool test_fdb_tsl_snapshot_recycle_cb(fdb_tsl_t tsl, void *arg)
+{
+    struct fdb_blob blob;
+    fdb_time_t data = 0;
+    int *append_num = arg;
+
+    test_fdb_tsl_append_time(*append_num);
+    *append_num = (int)fdb_blob_read((fdb_db_t) &test_tsdb, fdb_tsl_to_blob(tsl, fdb_blob_make(&blob, &data, sizeof(data))));
+    if (*append_num > 0) {
+        uassert_true(data == tsl->time);
+    }
+
+    return true;
+}
+
+static void test_fdb_tsl_snapshot_read(void)
+{
+    struct test_snapshot_args args;
+    bool snapshot_read = true;
+    fdb_time_t first_time, snap_last_time;
+    size_t snap_count;
+
+    fdb_tsl_clean(&test_tsdb);
+    fdb_tsdb_control(&test_tsdb, FDB_TSDB_CTRL_SET_SNAPSHOT_READ, &snapshot_read);
+    first_time = cur_times + TEST_TIME_STEP;
+    test_fdb_tsl_append_time(400);
+
+    /* the TSL which is appended during the iteration is invisible */
+    fdb_tsdb_control(&test_tsdb, FDB_TSDB_CTRL_GET_LAST_TIME, &snap_last_time);
+    memset(&args, 0, sizeof(args));
+    args.append_period = 1;
+    args.append_num = 1;
+    fdb_tsl_iter(&test_tsdb, test_fdb_tsl_snapshot_cb, &args);
+    uassert_true(args.count == 400);
+    uassert_true(args.last_time == snap_last_time);
+
+    fdb_tsdb_control(&test_tsdb, FDB_TSDB_CTRL_GET_LAST_TIME, &snap_last_time);
+    memset(&args, 0, sizeof(args));
+    args.reverse = true;
+    args.append_period = 1;
+    args.append_num = 1;
+    fdb_tsl_iter_reverse(&test_tsdb, test_fdb_tsl_snapshot_cb, &args);
+    uassert_true(args.count == 800);
+    uassert_true(args.last_time == first_time);
+
+    /* the oldest sectors are recycled by the rollover during the iteration */
+    test_fdb_tsl_append_time(5000);
+    fdb_tsdb_control(&test_tsdb, FDB_TSDB_CTRL_GET_LAST_TIME, &snap_last_time);
+    snap_count = fdb_tsl_query_count(&test_tsdb, 0, snap_last_time, FDB_TSL_WRITE);
+    memset(&args, 0, sizeof(args));
+    args.append_period = 300;
+    args.append_num = 600;
+    args.append_once = true;
+    fdb_tsl_iter(&test_tsdb, test_fdb_tsl_snapshot_cb, &args);
+    uassert_true(args.count < snap_count);
+    uassert_true(args.last_time == snap_last_time);
+
+    memset(&args, 0, sizeof(args));
+    args.reverse = true;
+    args.append_period = 1;
+    args.append_num = 1;
+    fdb_tsl_iter_reverse(&test_tsdb, test_fdb_tsl_snapshot_cb, &args);
+    uassert_true(args.count > 0 && args.count < snap_count);
+
+    /* the blob read fails when the sector is recycled after the TSL is read */
+    {
+        int append_num = 0;
+
+        fdb_tsl_iter(&test_tsdb, test_fdb_tsl_snapshot_recycle_cb, &append_num);
+        uassert_int_equal(append_num, sizeof(fdb_time_t));
+        append_num = 600;
+        fdb_tsl_iter(&test_tsdb, test_fdb_tsl_snapshot_recycle_cb, &append_num);
+        uassert_int_equal(append_num, 0);
+    }
+
+    snapshot_read = false;
+    fdb_tsdb_control(&test_tsdb, FDB_TSDB_CTRL_SET_SNAPSHOT_READ, &snapshot_read);
+    fdb_tsl_clean(&test_tsdb);
+}
+
+#define TEST_TS_MERGE_DB_NUM          3
+
+struct test_merge_data {
+    fdb_time_t time;
+    uint32_t shard;
+};
+
+struct test_merge_args {
+    size_t count;
+    size_t max_count;
+    fdb_time_t last_time;
+    uint32_t last_shard;
+    bool reverse;
+};
+
+static struct fdb_tsdb test_merge_tsdb[TEST_TS_MERGE_DB_NUM];
+static fdb_tsdb_t test_merge_db[TEST_TS_MERGE_DB_NUM];
+
+static bool test_fdb_tsl_merge_cb(fdb_tsdb_t db, fdb_tsl_t tsl, void *arg)
+{
+    struct test_merge_args *args = arg;
+    struct test_merge_data data;
+    struct fdb_blob blob;
+
+    fdb_blob_read((fdb_db_t) db, fdb_tsl_to_blob(tsl, fdb_blob_make(&blob, &data, sizeof(data))));
+    uassert_true(data.time == tsl->time);
+    uassert_true(db == test_merge_db[data.shard]);
+    /* the TSL is in the global timestamp order, the earlier TSDB is first when the timestamp is same */
+    if (args->count > 0) {
+        if (tsl->time == args->last_time) {
+            uassert_true(data.shard > args->last_shard);
+        } else {
+            uassert_true(args->reverse ? tsl->time < args->last_time : tsl->time > args->last_time);
+        }
+    }
+    args->last_time = tsl->time;
+    args->last_shard = data.shard;
+    args->count++;
+
+    return args->max_count && args->count >= args->max_count;
+}
+
+static size_t test_fdb_tsl_merge_query(fdb_time_t from, fdb_time_t to, size_t max_count)
+{
+    struct test_merge_args args;
+
+    memset(&args, 0, sizeof(args));
+    args.max_count = max_count;
+    args.reverse = from > to;
+    fdb_tsl_iter_merge(test_merge_db, TEST_TS_MERGE_DB_NUM, from, to, test_fdb_tsl_merge_cb, &args);
+
+    return args.count;
+}
+
+static void test_fdb_tsl_iter_merge(void)
+{
+    const char *name[TEST_TS_MERGE_DB_NUM] = { "merge0", "merge1", "merge2" };
+    uint32_t sec_size = TEST_SECTOR_SIZE, db_size = sec_size * 16;
+    rt_bool_t file_mode = true;
+    struct test_merge_data data;
+    struct fdb_blob blob;
+    fdb_time_t first_time, last_time;
+    size_t count = 0, range_count = 0;
+    int i, j;
+
+    for (i = 0; i < TEST_TS_MERGE_DB_NUM; i++) {
+        memset(&test_merge_tsdb[i], 0, sizeof(struct fdb_tsdb));
+        test_merge_db[i] = &test_merge_tsdb[i];
+        fdb_tsdb_control(test_merge_db[i], FDB_TSDB_CTRL_SET_SEC_SIZE, &sec_size);
+        fdb_tsdb_control(test_merge_db[i], FDB_TSDB_CTRL_SET_FILE_MODE, &file_mode);
+        fdb_tsdb_control(test_merge_db[i], FDB_TSDB_CTRL_SET_MAX_SIZE, &db_size);
+        uassert_true(fdb_tsdb_init(test_merge_db[i], name[i], TEST_TS_PART_NAME, get_time, 128, NULL) == FDB_NO_ERR);
+        fdb_tsl_clean(test_merge_db[i]);
+    }
+
+    /* the TSL is written to the shards unevenly, and some timestamps are written to all shards */
+    first_time = cur_times + TEST_TIME_STEP;
+    for (i = 0; i < 900; i++) {
+        data.time = get_time();
+        for (j = 0; j < TEST_TS_MERGE_DB_NUM; j++) {
+            if ((i + j) % (j + 2) == 0 || i % 100 == 0) {
+                data.shard = j;
+                uassert_true(fdb_tsl_append_with_ts(test_merge_db[j], fdb_blob_make(&blob, &data, sizeof(data)), data.time) == FDB_NO_ERR);
+                count++;
+                if (i >= 300 && i < 600) {
+                    range_count++;
+                }
+            }
+        }
+    }
+    last_time = data.time;
+
+    uassert_true(test_fdb_tsl_merge_query(first_time, last_time, 0) == count);
+    uassert_true(test_fdb_tsl_merge_query(last_time, first_time, 0) == count);
+    uassert_true(test_fdb_tsl_merge_query(first_time + 300 * TEST_TIME_STEP, first_time + 599 * TEST_TIME_STEP, 0) == range_count);
+    uassert_true(test_fdb_tsl_merge_query(first_time + 599 * TEST_TIME_STEP, first_time + 300 * TEST_TIME_STEP, 0) == range_count);
+    uassert_true(test_fdb_tsl_merge_query(first_time, last_time, 100) == 100);
+    uassert_true(test_fdb_tsl_merge_query(last_time + 1, last_time + 100, 0) == 0);
+
+    for (i = 0; i < TEST_TS_MERGE_DB_NUM; i++) {
+        uassert_true(fdb_tsdb_deinit(test_merge_db[i]) == FDB_NO_ERR);
+    }
+}
+
+struct test_sub_args {
+    size_t count;
+    size_t max_count;
+    fdb_time_t last_time;
+};
+
+static int test_sub_locked;
+
+static void test_sub_lock(fdb_db_t db)
+{
+    uassert_true(test_sub_locked == 0);
+    test_sub_locked++;
+}
+
+static void test_sub_unlock(fdb_db_t db)
+{
+    uassert_true(test_sub_locked == 1);
+    test_sub_locked--;
+}
+
+static bool test_fdb_tsl_sub_cb(fdb_tsl_t tsl, void *arg)
+{
+    struct test_sub_args *args = arg;
+    struct fdb_blob blob;
+    fdb_time_t data;
+
+    /* the callback is called with the database locked */
+    uassert_true(test_sub_locked == 1);
+
+    /* the new TSL is readable in the callback */
+    fdb_blob_read((fdb_db_t) &test_tsdb, fdb_tsl_to_blob(tsl, fdb_blob_make(&blob, &data, sizeof(data))));
+    uassert_true(data == tsl->time);
+    uassert_true(tsl->time > args->last_time);
+    args->last_time = tsl->time;
+    args->count++;
+
+    return args->max_count && args->count >= args->max_count;
+}
+
+static int test_wait_count, test_notify_count;
+
+/* the fake wait function waits 10 for each call, appends the new TSL on the 3rd call, and timeout on the 5th call */
+static bool test_fdb_tsl_wait(fdb_db_t db, int32_t *timeout)
+{
+    /* the next wait only has the remaining time */
+    uassert_true(*timeout == 100 - 10 * (test_wait_count % 3));
+    *timeout -= 10;
+    /* the lock is released when waiting */
+    test_sub_unlock(db);
+    if (++test_wait_count == 3) {
+        test_fdb_tsl_append_time(1);
+    }
+    test_sub_lock(db);
+    return test_wait_count < 5;
+}
+
+static void test_fdb_tsl_notify(fdb_db_t db)
+{
+    test_notify_count++;
+}
+
+static void test_fdb_tsl_subscribe(void)
+{
+    struct test_sub_args args1, args2;
+    fdb_time_t last_time;
+
+    memset(&args1, 0, sizeof(args1));
+    memset(&args2, 0, sizeof(args2));
+    args2.max_count = 10;
+    fdb_tsdb_control(&test_tsdb, FDB_TSDB_CTRL_SET_LOCK, (void *)test_sub_lock);
+    fdb_tsdb_control(&test_tsdb, FDB_TSDB_CTRL_SET_UNLOCK, (void *)test_sub_unlock);
+    uassert_true(fdb_tsl_subscribe(&test_tsdb, test_fdb_tsl_sub_cb, &args1) == FDB_NO_ERR);
+    uassert_true(fdb_tsl_subscribe(&test_tsdb, test_fdb_tsl_sub_cb, &args2) == FDB_NO_ERR);
+    test_fdb_tsl_append_time(100);
+    fdb_tsdb_control(&test_tsdb, FDB_TSDB_CTRL_GET_LAST_TIME, &last_time);
+    uassert_true(args1.count == 100);
+    uassert_true(args1.last_time == last_time);
+    /* the subscription is canceled when callback return true */
+    uassert_true(args2.count == 10);
+    uassert_true(fdb_tsl_unsubscribe(&test_tsdb, test_fdb_tsl_sub_cb, &args2) == FDB_READ_ERR);
+    uassert_true(fdb_tsl_unsubscribe(&test_tsdb, test_fdb_tsl_sub_cb, &args1) == FDB_NO_ERR);
+    test_fdb_tsl_append_time(10);
+    uassert_true(args1.count == 100);
+
+    /* without the wait function, it only checks the last time */
+    fdb_tsdb_control(&test_tsdb, FDB_TSDB_CTRL_GET_LAST_TIME, &last_time);
+    uassert_true(fdb_tsl_wait_newer(&test_tsdb, last_time - 1, 100));
+    uassert_false(fdb_tsl_wait_newer(&test_tsdb, last_time, 100));
+
+    test_wait_count = test_notify_count = 0;
+    fdb_tsdb_control(&test_tsdb, FDB_TSDB_CTRL_SET_WAIT, (void *)test_fdb_tsl_wait);
+    fdb_tsdb_control(&test_tsdb, FDB_TSDB_CTRL_SET_NOTIFY, (void *)test_fdb_tsl_notify);
+    uassert_true(fdb_tsl_wait_newer(&test_tsdb, last_time, 100));
+    uassert_true(test_wait_count == 3);
+    uassert_true(test_notify_count == 1);
+    fdb_tsdb_control(&test_tsdb, FDB_TSDB_CTRL_GET_LAST_TIME, &last_time);
+    uassert_false(fdb_tsl_wait_newer(&test_tsdb, last_time, 100));
+    uassert_true(test_wait_count == 5);
+
+    fdb_tsdb_control(&test_tsdb, FDB_TSDB_CTRL_SET_WAIT, NULL);
+    fdb_tsdb_control(&test_tsdb, FDB_TSDB_CTRL_SET_NOTIFY, NULL);
+    uassert_true(test_sub_locked == 0);
+    fdb_tsdb_control(&test_tsdb, FDB_TSDB_CTRL_SET_LOCK, NULL);
+    fdb_tsdb_control(&test_tsdb, FDB_TSDB_CTRL_SET_UNLOCK, NULL);
+    fdb_tsl_clean(&test_tsdb);
+}
+
+#ifdef FDB_TSDB_USING_AGGREGATE
+struct test_agg_log {
+    int32_t value;
+    float ratio;
+};
+
+static bool test_fdb_tsl_agg_cb(fdb_tsl_t tsl, void *arg)
+{
+    struct fdb_tsl_agg_result *result = arg;
+    struct test_agg_log log;
+    struct fdb_blob blob;
+
+    fdb_blob_read((fdb_db_t) &test_tsdb, fdb_tsl_to_blob(tsl, fdb_blob_make(&blob, &log, sizeof(log))));
+    if (tsl->status != FDB_TSL_DELETED) {
+        if (result->count == 0 || log.value < result->min) {
+            result->min = log.value;
+        }
+        if (result->count == 0 || log.value > result->max) {
+            result->max = log.value;
+        }
+        result->sum += log.value;
+        result->count++;
+    }
+
+    return false;
+}
+
+static void test_fdb_tsl_aggregate(void)
+{
+    struct fdb_blob blob;
+    struct test_agg_log log;
+    struct fdb_tsl_extractor extractor = { FDB_TSL_FIELD_INT32, 0 };
+    struct fdb_tsl_agg_result result, expect;
+    uint32_t hist[4], hist_sum = 0;
+    struct fdb_tsl_agg_spec spec = { FDB_TSL_AGG_SUM | FDB_TSL_AGG_MIN | FDB_TSL_AGG_MAX | FDB_TSL_AGG_HIST, 0, 250, 4, hist };
+    fdb_time_t from, to;
+    int i;
+
+    fdb_tsl_clean(&test_tsdb);
+    /* make test data for more than 2 sectors */
+    for (i = 0; i < 1000; i++) {
+        log.value = (i * 37) % 1000 - 10;
+        log.ratio = i * 0.5f;
+        uassert_true(fdb_tsl_append(&test_tsdb, fdb_blob_make(&blob, &log, sizeof(log))) == FDB_NO_ERR);
+    }
+    fdb_reboot();
+
+    /* whole database */
+    memset(&expect, 0, sizeof(expect));
+    fdb_tsl_iter_by_time(&test_tsdb, 0, cur_times, test_fdb_tsl_agg_cb, &expect);
+    uassert_true(fdb_tsl_aggregate(&test_tsdb, 0, cur_times, &extractor, &spec, &result) == FDB_NO_ERR);
+    uassert_true(result.count == 1000 && result.count == expect.count);
+    uassert_true(result.sum == expect.sum);
+    uassert_true(result.avg == expect.sum / expect.count);
+    uassert_true(result.min == -10 && result.min == expect.min);
+    uassert_true(result.max == 989 && result.max == expect.max);
+    for (i = 0; i < 4; i++) {
+        hist_sum += hist[i];
+    }
+    uassert_true(hist_sum == 1000);
+    /* the values less than 0 are counted by the first bin */
+    uassert_true(hist[0] == 260 && hist[3] == 240);
+
+    /* a part of the database, the reverse time range is the same */
+    from = cur_times - 1500;
+    to = cur_times - 300;
+    memset(&expect, 0, sizeof(expect));
+    fdb_tsl_iter_by_time(&test_tsdb, from, to, test_fdb_tsl_agg_cb, &expect);
+    uassert_true(fdb_tsl_aggregate(&test_tsdb, to, from, &extractor, &spec, &result) == FDB_NO_ERR);
+    uassert_true(result.count == expect.count && result.sum == expect.sum);
+    uassert_true(result.min == expect.min && result.max == expect.max);
+
+    /* float field */
+    extractor.type = FDB_TSL_FIELD_FLOAT;
+    extractor.offset = sizeof(int32_t);
+    spec.ops = FDB_TSL_AGG_SUM | FDB_TSL_AGG_MAX;
+    uassert_true(fdb_tsl_aggregate(&test_tsdb, 0, cur_times, &extractor, &spec, &result) == FDB_NO_ERR);
+    uassert_true(result.count == 1000 && result.sum == 999 * 1000 / 4 && result.max == 499.5);
+
+    /* the field is out of the log */
+    extractor.type = FDB_TSL_FIELD_DOUBLE;
+    uassert_true(fdb_tsl_aggregate(&test_tsdb, 0, cur_times, &extractor, &spec, &result) == FDB_NO_ERR);
+    uassert_true(result.count == 0);
+
+    /* the INT64 field is summed without the double rounding */
+    fdb_tsl_clean(&test_tsdb);
+    for (i = 0; i < 3; i++) {
+        int64_t value64 = ((int64_t)1 << 53) + 1;
+        uassert_true(fdb_tsl_append(&test_tsdb, fdb_blob_make(&blob, &value64, sizeof(value64))) == FDB_NO_ERR);
+    }
+    extractor.type = FDB_TSL_FIELD_INT64;
+    extractor.offset = 0;
+    spec.ops = FDB_TSL_AGG_SUM;
+    uassert_true(fdb_tsl_aggregate(&test_tsdb, 0, cur_times, &extractor, &spec, &result) == FDB_NO_ERR);
+    uassert_true(result.count == 3 && result.sum == (double)(3 * ((int64_t)1 << 53) + 3));
+    uassert_true(result.avg == (double)(((int64_t)1 << 53) + 1));
+    uassert_false(result.overflow);
+
+    /* the overflowed INT64 sum is reported, and it's summed by double */
+    fdb_tsl_clean(&test_tsdb);
+    for (i = 0; i < 2; i++) {
+        int64_t value64 = INT64_MAX;
+        uassert_true(fdb_tsl_append(&test_tsdb, fdb_blob_make(&blob, &value64, sizeof(value64))) == FDB_NO_ERR);
+    }
+    uassert_true(fdb_tsl_aggregate(&test_tsdb, 0, cur_times, &extractor, &spec, &result) == FDB_NO_ERR);
+    uassert_true(result.count == 2 && result.overflow);
+    uassert_true(result.sum == 2 * (double)INT64_MAX && result.avg == (double)INT64_MAX);
+
+    fdb_tsl_clean(&test_tsdb);
+}
+#endif /* FDB_TSDB_USING_AGGREGATE */
+
+#ifdef FDB_TSDB_USING_ARCHIVE
+#define TEST_TS_ARC_COUNT             3000
+
+struct test_arc_data {
+    fdb_time_t time;
+    uint32_t value[6];
+};
+
+struct test_arc_args {
+    size_t count;
+    size_t max_count;
+    fdb_time_t last_time;
+    bool reverse;
+};
+
+static struct fdb_tsdb test_arc_tsdb;
+static int test_arc_locked;
+static size_t test_arc_lock_cnt;
+
+/* the TSDB lock is not recursive */
+static void test_arc_lock(fdb_db_t db)
+{
+    uassert_true(test_arc_locked == 0);
+    test_arc_locked++;
+    test_arc_lock_cnt++;
+}
+
+static void test_arc_unlock(fdb_db_t db)
+{
+    uassert_true(test_arc_locked == 1);
+    test_arc_locked--;
+}
+
+static void test_fdb_tsdb_arc_init(void)
+{
+    uint32_t sec_size = TEST_SECTOR_SIZE, db_size = sec_size * 4;
+    rt_bool_t file_mode = true, archive = true;
+
+    memset(&test_arc_tsdb, 0, sizeof(struct fdb_tsdb));
+    fdb_tsdb_control(&test_arc_tsdb, FDB_TSDB_CTRL_SET_SEC_SIZE, &sec_size);
+    fdb_tsdb_control(&test_arc_tsdb, FDB_TSDB_CTRL_SET_FILE_MODE, &file_mode);
+    fdb_tsdb_control(&test_arc_tsdb, FDB_TSDB_CTRL_SET_MAX_SIZE, &db_size);
+    fdb_tsdb_control(&test_arc_tsdb, FDB_TSDB_CTRL_SET_ARCHIVE, &archive);
+    fdb_tsdb_control(&test_arc_tsdb, FDB_TSDB_CTRL_SET_LOCK, (void *)test_arc_lock);
+    fdb_tsdb_control(&test_arc_tsdb, FDB_TSDB_CTRL_SET_UNLOCK, (void *)test_arc_unlock);
+    uassert_true(fdb_tsdb_init(&test_arc_tsdb, "test_arc", TEST_TS_PART_NAME, get_time, 128, NULL) == FDB_NO_ERR);
+}
+
+static bool test_fdb_tsl_arc_cb(fdb_tsl_t tsl, void *arg)
+{
+    struct test_arc_args *args = arg;
+    struct test_arc_data data;
+    struct fdb_blob blob;
+    uint32_t value = 0;
+
+    uassert_true(fdb_blob_read((fdb_db_t) &test_arc_tsdb, fdb_tsl_to_blob(tsl, fdb_blob_make(&blob, &data, sizeof(data)))) == sizeof(data));
+    uassert_true(data.time == tsl->time && data.value[5] == (uint32_t)(tsl->time % 7));
+    /* read one field of the TSL */
+    fdb_blob_make(&blob, &value, sizeof(value));
+    uassert_true(fdb_blob_read_at((fdb_db_t) &test_arc_tsdb, &blob, offsetof(struct test_arc_data, value[5]), sizeof(value)) == sizeof(value));
+    uassert_true(value == data.value[5]);
+    /* the TSL is continuous between the archive and the ring */
+    if (args->count > 0) {
+        uassert_true(tsl->time == args->last_time + (args->reverse ? -TEST_TIME_STEP : TEST_TIME_STEP));
+    }
+    args->last_time = tsl->time;
+    args->count++;
+
+    return args->max_count && args->count >= args->max_count;
+}
+
+static void test_fdb_tsl_arc_append(int count)
+{
+    struct test_arc_data data;
+    struct fdb_blob blob;
+
+    memset(&data, 0, sizeof(data));
+    while (count-- > 0) {
+        data.time = get_time();
+        data.value[5] = (uint32_t)(data.time % 7);
+        uassert_true(fdb_tsl_append_with_ts(&test_arc_tsdb, fdb_blob_make(&blob, &data, sizeof(data)), data.time) == FDB_NO_ERR);
+    }
+}
+
+/* the TSL is appended in the callback, the new sectors are archived during the iteration */
+static bool test_fdb_tsl_arc_append_cb(fdb_tsl_t tsl, void *arg)
+{
+    struct test_arc_args *args = arg;
+    struct test_arc_data data;
+    struct fdb_blob blob;
+
+    uassert_true(test_arc_locked == 0);
+    uassert_true(fdb_blob_read((fdb_db_t) &test_arc_tsdb, fdb_tsl_to_blob(tsl, fdb_blob_make(&blob, &data, sizeof(data)))) == sizeof(data));
+    uassert_true(data.time == tsl->time && data.value[5] == (uint32_t)(tsl->time % 7));
+    if (args->count > 0) {
+        uassert_true(args->reverse ? tsl->time < args->last_time : tsl->time > args->last_time);
+    }
+    args->last_time = tsl->time;
+    args->count++;
+    test_fdb_tsl_arc_append(1);
+
+    return false;
+}
+
+/* save the first TSL, it's read after the iteration */
+static bool test_fdb_tsl_arc_save_cb(fdb_tsl_t tsl, void *arg)
+{
+    *(struct fdb_tsl *)arg = *tsl;
+
+    return true;
+}
+
+static bool test_fdb_tsl_arc_merge_cb(fdb_tsdb_t db, fdb_tsl_t tsl, void *arg)
+{
+    return test_fdb_tsl_arc_cb(tsl, arg);
+}
+
+static size_t test_fdb_tsl_arc_query(fdb_time_t from, fdb_time_t to, size_t max_count)
+{
+    struct test_arc_args args;
+
+    memset(&args, 0, sizeof(args));
+    args.max_count = max_count;
+    args.reverse = from > to;
+    fdb_tsl_iter_by_time(&test_arc_tsdb, from, to, test_fdb_tsl_arc_cb, &args);
+
+    return args.count;
+}
+
+static void test_fdb_tsl_archive(void)
+{
+    struct test_arc_args args;
+    fdb_tsdb_t db[1] = { &test_arc_tsdb };
+    fdb_time_t first_time, last_time;
+    uint32_t arc_size;
+    bool snapshot_read = true;
+
+    test_fdb_tsdb_arc_init();
+    fdb_tsl_clean(&test_arc_tsdb);
+    first_time = cur_times + TEST_TIME_STEP;
+    test_fdb_tsl_arc_append(TEST_TS_ARC_COUNT);
+    fdb_tsdb_control(&test_arc_tsdb, FDB_TSDB_CTRL_GET_LAST_TIME, &last_time);
+
+    /* the recycled sectors are compressed into the archive file */
+    fdb_tsdb_control(&test_arc_tsdb, FDB_TSDB_CTRL_GET_ARCHIVE_SIZE, &arc_size);
+    uassert_true(arc_size > 0 && arc_size < TEST_TS_ARC_COUNT * sizeof(struct test_arc_data) / 2);
+
+    /* the query spans the archive and the ring */
+    uassert_true(test_fdb_tsl_arc_query(0, last_time, 0) == TEST_TS_ARC_COUNT);
+    uassert_true(test_fdb_tsl_arc_query(last_time, 0, 0) == TEST_TS_ARC_COUNT);
+    uassert_true(test_fdb_tsl_arc_query(first_time + 20, last_time - 20, 0) == TEST_TS_ARC_COUNT - 20);
+    uassert_true(test_fdb_tsl_arc_query(last_time - 20, first_time + 20, 0) == TEST_TS_ARC_COUNT - 20);
+    uassert_true(test_fdb_tsl_arc_query(0, last_time, 100) == 100);
+    uassert_true(test_fdb_tsl_arc_query(last_time, 0, TEST_TS_ARC_COUNT - 100) == TEST_TS_ARC_COUNT - 100);
+    uassert_true(fdb_tsl_query_count(&test_arc_tsdb, first_time, last_time, FDB_TSL_WRITE) == TEST_TS_ARC_COUNT);
+
+    /* the TSL iterators and the merge iterator walk the archive too */
+    memset(&args, 0, sizeof(args));
+    fdb_tsl_iter(&test_arc_tsdb, test_fdb_tsl_arc_cb, &args);
+    uassert_true(args.count == TEST_TS_ARC_COUNT && args.last_time == last_time);
+    memset(&args, 0, sizeof(args));
+    args.reverse = true;
+    fdb_tsl_iter_reverse(&test_arc_tsdb, test_fdb_tsl_arc_cb, &args);
+    uassert_true(args.count == TEST_TS_ARC_COUNT && args.last_time == first_time);
+    memset(&args, 0, sizeof(args));
+    fdb_tsl_iter_merge(db, 1, 0, last_time, test_fdb_tsl_arc_merge_cb, &args);
+    uassert_true(args.count == TEST_TS_ARC_COUNT);
+    {
+        struct fdb_tsl tsl;
+        struct test_arc_data data;
+        struct fdb_blob blob;
+        size_t lock_cnt;
+
+        /* the archived TSL is read with the lock held outside the iteration */
+        fdb_tsl_iter(&test_arc_tsdb, test_fdb_tsl_arc_save_cb, &tsl);
+        uassert_true(tsl.time == first_time);
+        lock_cnt = test_arc_lock_cnt;
+        uassert_true(fdb_blob_read((fdb_db_t) &test_arc_tsdb, fdb_tsl_to_blob(&tsl, fdb_blob_make(&blob, &data, sizeof(data)))) == sizeof(data));
+        uassert_true(data.time == first_time && test_arc_lock_cnt == lock_cnt + 1);
+    }
+#ifdef FDB_TSDB_USING_AGGREGATE
+    {
+        struct fdb_tsl_extractor extractor = { FDB_TSL_FIELD_UINT32, offsetof(struct test_arc_data, value[5]) };
+        struct fdb_tsl_agg_spec spec = { FDB_TSL_AGG_SUM | FDB_TSL_AGG_MAX, 0, 0, 0, NULL };
+        struct fdb_tsl_agg_result result;
+        double sum = 0;
+        fdb_time_t time;
+
+        for (time = first_time; time <= last_time; time += TEST_TIME_STEP) {
+            sum += (double)(time % 7);
+        }
+        uassert_true(fdb_tsl_aggregate(&test_arc_tsdb, 0, last_time, &extractor, &spec, &result) == FDB_NO_ERR);
+        uassert_true(result.count == TEST_TS_ARC_COUNT && result.sum == sum && result.max == 6);
+    }
+#endif
+
+    /* the callback is called without the lock in snapshot read mode, so the TSL can be appended in it */
+    fdb_tsdb_control(&test_arc_tsdb, FDB_TSDB_CTRL_SET_SNAPSHOT_READ, &snapshot_read);
+    memset(&args, 0, sizeof(args));
+    fdb_tsl_iter(&test_arc_tsdb, test_fdb_tsl_arc_append_cb, &args);
+    uassert_true(args.count > 0 && args.count <= TEST_TS_ARC_COUNT);
+    memset(&args, 0, sizeof(args));
+    args.reverse = true;
+    fdb_tsl_iter_by_time(&test_arc_tsdb, last_time, 0, test_fdb_tsl_arc_append_cb, &args);
+    uassert_true(args.count > 0 && args.count <= TEST_TS_ARC_COUNT && args.last_time == first_time);
+    snapshot_read = false;
+    fdb_tsdb_control(&test_arc_tsdb, FDB_TSDB_CTRL_SET_SNAPSHOT_READ, &snapshot_read);
+    fdb_tsdb_control(&test_arc_tsdb, FDB_TSDB_CTRL_GET_LAST_TIME, &last_time);
+    uassert_true(test_fdb_tsl_arc_query(0, last_time, 0) == (size_t)((last_time - first_time) / TEST_TIME_STEP + 1));
+
+    /* the archive is kept after reboot */
+    uassert_true(fdb_tsdb_deinit(&test_arc_tsdb) == FDB_NO_ERR);
+    test_fdb_tsdb_arc_init();
+    uassert_true(test_fdb_tsl_arc_query(0, last_time, 0) == (size_t)((last_time - first_time) / TEST_TIME_STEP + 1));
+
+    fdb_tsl_clean(&test_arc_tsdb);
+    fdb_tsdb_control(&test_arc_tsdb, FDB_TSDB_CTRL_GET_ARCHIVE_SIZE, &arc_size);
+    uassert_true(arc_size == 0);
+    uassert_true(test_fdb_tsl_arc_query(0, last_time, 0) == 0);
+    uassert_true(fdb_tsdb_deinit(&test_arc_tsdb) == FDB_NO_ERR);
+}
+#endif /* FDB_TSDB_USING_ARCHIVE */
+
+#if defined(FDB_TSDB_USING_SECTOR_POOL) && defined(FDB_USING_FAL_MODE)
+#define TEST_TS_POOL_PART_NAME        "fdb_tsdb_pool"
+#define TEST_TS_POOL_DB_NUM           2
+
+struct test_pool_args {
+    int tag;
+    size_t count;
+    uint32_t last_index;
+    bool reverse;
+};
+
+static struct fdb_tsdb_pool test_pool;
+static struct fdb_tsdb test_pool_tsdb[TEST_TS_POOL_DB_NUM];
+static uint32_t test_pool_index[TEST_TS_POOL_DB_NUM];
+static int test_pool_locked;
+
+/* the pool lock is not recursive */
+static void test_pool_lock(fdb_tsdb_pool_t pool)
+{
+    uassert_true(test_pool_locked == 0);
+    test_pool_locked++;
+}
+
+static void test_pool_unlock(fdb_tsdb_pool_t pool)
+{
+    uassert_true(test_pool_locked == 1);
+    test_pool_locked--;
+}
+
+static void test_fdb_tsdb_pool_init(void)
+{
+    const char *name[TEST_TS_POOL_DB_NUM] = { "pool_a", "pool_b" };
+    int i;
+
+    /* the pool is loaded from the flash again */
+    memset(&test_pool, 0, sizeof(test_pool));
+    test_pool.lock = test_pool_lock;
+    test_pool.unlock = test_pool_unlock;
+    for (i = 0; i < TEST_TS_POOL_DB_NUM; i++) {
+        memset(&test_pool_tsdb[i], 0, sizeof(struct fdb_tsdb));
+        fdb_tsdb_control(&test_pool_tsdb[i], FDB_TSDB_CTRL_SET_POOL, &test_pool);
+        uassert_true(fdb_tsdb_init(&test_pool_tsdb[i], name[i], TEST_TS_POOL_PART_NAME, get_time, 128, NULL) == FDB_NO_ERR);
+    }
+}
+
+static void test_fdb_tsdb_pool_deinit(void)
+{
+    int i;
+
+    for (i = 0; i < TEST_TS_POOL_DB_NUM; i++) {
+        uassert_true(fdb_tsdb_deinit(&test_pool_tsdb[i]) == FDB_NO_ERR);
+    }
+}
+
+/* the TSL data is the TSDB tag and the TSL index in this TSDB */
+static void test_fdb_tsl_pool_append(int tag, int count)
+{
+    struct fdb_blob blob;
+    uint32_t data[16];
+
+    while (count-- > 0) {
+        data[0] = tag;
+        data[1] = ++test_pool_index[tag];
+        uassert_true(fdb_tsl_append(&test_pool_tsdb[tag], fdb_blob_make(&blob, data, sizeof(data))) == FDB_NO_ERR);
+    }
+}
+
+static bool test_fdb_tsl_pool_cb(fdb_tsl_t tsl, void *arg)
+{
+    struct test_pool_args *args = arg;
+    struct fdb_blob blob;
+    uint32_t data[2] = { 0 };
+
+    fdb_blob_read((fdb_db_t) &test_pool_tsdb[args->tag], fdb_tsl_to_blob(tsl, fdb_blob_make(&blob, data, sizeof(data))));
+    uassert_true(data[0] == (uint32_t)args->tag);
+    /* the TSL is continuous in each TSDB */
+    if (args->count > 0) {
+        uassert_true(data[1] == (args->reverse ? args->last_index - 1 : args->last_index + 1));
+    }
+    args->last_index = data[1];
+    args->count++;
+
+    return false;
+}
+
+static size_t test_fdb_tsl_pool_check(int tag, uint32_t first_index)
+{
+    struct test_pool_args args;
+    size_t count;
+
+    memset(&args, 0, sizeof(args));
+    args.tag = tag;
+    fdb_tsl_iter(&test_pool_tsdb[tag], test_fdb_tsl_pool_cb, &args);
+    count = args.count;
+    if (count > 0) {
+        uassert_true(args.last_index == test_pool_index[tag]);
+        uassert_true(first_index == 0 || args.last_index - count + 1 == first_index);
+    }
+
+    memset(&args, 0, sizeof(args));
+    args.tag = tag;
+    args.reverse = true;
+    fdb_tsl_iter_reverse(&test_pool_tsdb[tag], test_fdb_tsl_pool_cb, &args);
+    uassert_true(args.count == count);
+    uassert_true(fdb_tsl_query_count(&test_pool_tsdb[tag], 0, INT32_MAX, FDB_TSL_WRITE) == count);
+
+    return count;
+}
+
+static void test_fdb_tsl_sector_pool(void)
+{
+    int i;
+    size_t count;
+
+    test_fdb_tsdb_pool_init();
+    for (i = 0; i < TEST_TS_POOL_DB_NUM; i++) {
+        fdb_tsl_clean(&test_pool_tsdb[i]);
+        test_pool_index[i] = 0;
+    }
+
+    /* the TSDBs allocate the sectors from the pool alternately */
+    for (i = 0; i < 200; i++) {
+        test_fdb_tsl_pool_append(0, 1);
+        test_fdb_tsl_pool_append(1, 1);
+    }
+    uassert_true(test_fdb_tsl_pool_check(0, 1) == 200);
+    uassert_true(test_fdb_tsl_pool_check(1, 1) == 200);
+
+    /* the sector chains are rebuilt on reboot */
+    test_fdb_tsdb_pool_deinit();
+    test_fdb_tsdb_pool_init();
+    uassert_true(test_fdb_tsl_pool_check(0, 1) == 200);
+    uassert_true(test_fdb_tsl_pool_check(1, 1) == 200);
+    test_fdb_tsl_pool_append(1, 10);
+    uassert_true(test_fdb_tsl_pool_check(1, 1) == 210);
+
+    /* the oldest sectors in the pool are recycled, the current using sector of other TSDB is kept */
+    test_fdb_tsl_pool_append(0, 2000);
+    count = test_fdb_tsl_pool_check(0, 0);
+    uassert_true(count > 200 && count < 2200);
+    count = test_fdb_tsl_pool_check(1, 0);
+    uassert_true(count > 0 && count < 210);
+
+    test_fdb_tsdb_pool_deinit();
+    test_fdb_tsdb_pool_init();
+    uassert_true(test_fdb_tsl_pool_check(1, 0) == count);
+
+    /* clean one TSDB, the other is not changed */
+    fdb_tsl_clean(&test_pool_tsdb[0]);
+    uassert_true(test_fdb_tsl_pool_check(0, 0) == 0);
+    uassert_true(test_fdb_tsl_pool_check(1, 0) == count);
+    test_fdb_tsl_pool_append(0, 10);
+    uassert_true(test_fdb_tsl_pool_check(0, test_pool_index[0] - 9) == 10);
+
+    test_fdb_tsdb_pool_deinit();
+}
+
+static void test_fdb_tsl_sector_pool_rollover(void)
+{
+    struct fdb_blob blob;
+    uint32_t data[16] = { 1 };
+    bool rollover = false;
+    size_t count;
+
+    test_fdb_tsdb_pool_init();
+    fdb_tsl_clean(&test_pool_tsdb[0]);
+    fdb_tsl_clean(&test_pool_tsdb[1]);
+    test_pool_index[0] = test_pool_index[1] = 0;
+
+    /* the TSDB B is not rollover, it takes all free sectors, only the current using sector of A is left */
+    fdb_tsdb_control(&test_pool_tsdb[1], FDB_TSDB_CTRL_SET_ROLLOVER, &rollover);
+    do {
+        data[1] = ++test_pool_index[1];
+    } while (fdb_tsl_append(&test_pool_tsdb[1], fdb_blob_make(&blob, data, sizeof(data))) == FDB_NO_ERR);
+    count = --test_pool_index[1];
+    uassert_true(count > 0);
+
+    /* the TSDB A is rollover, but the sectors are never taken from B, so it's full after its only sector */
+    data[0] = 0;
+    while (fdb_tsl_append(&test_pool_tsdb[0], fdb_blob_make(&blob, data, sizeof(data))) == FDB_NO_ERR);
+    uassert_true(fdb_tsl_append(&test_pool_tsdb[0], fdb_blob_make(&blob, data, sizeof(data))) == FDB_SAVED_FULL);
+    uassert_true(fdb_tsl_query_count(&test_pool_tsdb[0], 0, INT32_MAX, FDB_TSL_WRITE) > 0);
+    uassert_true(test_fdb_tsl_pool_check(1, 1) == count);
+    uassert_true(test_pool_locked == 0);
+
+    /* the B is rollover again, A takes the oldest sector from B after reboot */
+    test_fdb_tsdb_pool_deinit();
+    test_fdb_tsdb_pool_init();
+    test_fdb_tsl_pool_append(0, 1);
+    count = test_fdb_tsl_pool_check(1, 0);
+    uassert_true(count > 0 && count < test_pool_index[1]);
+    uassert_true(test_pool_locked == 0);
+
+    fdb_tsl_clean(&test_pool_tsdb[0]);
+    fdb_tsl_clean(&test_pool_tsdb[1]);
+    test_fdb_tsdb_pool_deinit();
+}
+#endif /* defined(FDB_TSDB_USING_SECTOR_POOL) && defined(FDB_USING_FAL_MODE) */
+
 static void test_fdb_github_issue_249(void)
 {
     if (access("storage_tsdb", 0) < 0)
@@ -467,6 +1374,22 @@ static void testcase(void)
     UTEST_UNIT_RUN(test_fdb_tsl_set_status);
     UTEST_UNIT_RUN(test_fdb_tsl_clean);
     UTEST_UNIT_RUN(test_fdb_tsl_iter_by_time_1);
+#ifdef FDB_TSDB_USING_TIME_DELTA
+    UTEST_UNIT_RUN(test_fdb_tsl_time_delta);
+#endif
+    UTEST_UNIT_RUN(test_fdb_tsl_snapshot_read);
+    UTEST_UNIT_RUN(test_fdb_tsl_iter_merge);
+    UTEST_UNIT_RUN(test_fdb_tsl_subscribe);
+#ifdef FDB_TSDB_USING_AGGREGATE
+    UTEST_UNIT_RUN(test_fdb_tsl_aggregate);
+#endif
+#ifdef FDB_TSDB_USING_ARCHIVE
+    UTEST_UNIT_RUN(test_fdb_tsl_archive);
+#endif
+#if defined(FDB_TSDB_USING_SECTOR_POOL) && defined(FDB_USING_FAL_MODE)
+    UTEST_UNIT_RUN(test_fdb_tsl_sector_pool);
+    UTEST_UNIT_RUN(test_fdb_tsl_sector_pool_rollover);
+#endif
     UTEST_UNIT_RUN(test_fdb_tsdb_deinit);
 
     UTEST_UNIT_RUN(test_fdb_github_issue_249);
@@ -0,0 +1,114 @@
+/*
+ * Copyright (c) 2020, Armink, <armink.ztl@gmail.com>
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/**
+ * @file
+ * @brief utils testcases.
+ *
+ * This testcases is be used in RT-Thread Utest framework.
+ * If you want run it, please add it to RT-Thread project.
+ */
+
+#include "utest.h"
+#include <flashdb.h>
+#include <fdb_low_lvl.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#if defined(RT_USING_UTEST)
+
+#define TEST_CRC32_BUF_SIZE           4096
+#define TEST_CRC32_BENCH_LOOP         256
+
+static uint8_t test_buf[TEST_CRC32_BUF_SIZE];
+
+/* the bitwise CRC32 (IEEE 802.3, reflected) as the reference */
+static uint32_t test_crc32_ref(uint32_t crc, const uint8_t *buf, size_t size)
+{
+    int i;
+
+    crc = ~crc;
+    while (size--) {
+        crc ^= *buf++;
+        for (i = 0; i < 8; i++) {
+            crc = (crc & 1) ? (crc >> 1) ^ 0xEDB88320 : crc >> 1;
+        }
+    }
+
+    return ~crc;
+}
+
+static void test_fdb_crc32(void)
+{
+    size_t i, offset, size, split;
+    uint32_t crc;
+
+    /* the check value of CRC-32 */
+    uassert_true(fdb_calc_crc32(0, "123456789", 9) == 0xCBF43926);
+    uassert_true(fdb_calc_crc32(0, NULL, 0) == 0);
+
+    srand(0);
+    for (i = 0; i < TEST_CRC32_BUF_SIZE; i++) {
+        test_buf[i] = (uint8_t) rand();
+    }
+    /* all lengths and unaligned start addresses */
+    for (offset = 0; offset < 16; offset++) {
+        for (size = 0; size + offset <= 300; size++) {
+            uassert_true(fdb_calc_crc32(0, test_buf + offset, size) == test_crc32_ref(0, test_buf + offset, size));
+        }
+    }
+    uassert_true(fdb_calc_crc32(0, test_buf, TEST_CRC32_BUF_SIZE) == test_crc32_ref(0, test_buf, TEST_CRC32_BUF_SIZE));
+    /* accumulated by several parts */
+    for (split = 0; split <= TEST_CRC32_BUF_SIZE; split += 509) {
+        crc = fdb_calc_crc32(0, test_buf, split);
+        crc = fdb_calc_crc32(crc, test_buf + split, TEST_CRC32_BUF_SIZE - split);
+        uassert_true(crc == test_crc32_ref(0, test_buf, TEST_CRC32_BUF_SIZE));
+    }
+    /* the padding data */
+    for (size = 0; size <= 100; size++) {
+        memset(test_buf, 0xFF, size);
+        crc = fdb_calc_crc32(0, "name", 4);
+        uassert_true(_fdb_calc_crc32_fill(crc, 0xFF, size) == fdb_calc_crc32(crc, test_buf, size));
+    }
+}
+
+static void test_fdb_crc32_bench(void)
+{
+    size_t i;
+    uint32_t crc = 0;
+    rt_tick_t start, ticks;
+
+    start = rt_tick_get();
+    for (i = 0; i < TEST_CRC32_BENCH_LOOP; i++) {
+        crc = fdb_calc_crc32(crc, test_buf, TEST_CRC32_BUF_SIZE);
+    }
+    ticks = rt_tick_get() - start;
+    rt_kprintf("CRC32 (slice %d) %d KB: %d ticks, crc 0x%08x\n", FDB_CRC32_SLICE,
+            TEST_CRC32_BENCH_LOOP * TEST_CRC32_BUF_SIZE / 1024, (int)ticks, (unsigned)crc);
+    if (ticks > 0) {
+        rt_kprintf("CRC32 throughput: %d KB/s\n",
+                (int)((uint64_t)TEST_CRC32_BENCH_LOOP * TEST_CRC32_BUF_SIZE / 1024 * RT_TICK_PER_SECOND / ticks));
+    }
+}
+
+static rt_err_t utest_tc_init(void)
+{
+    return RT_EOK;
+}
+
+static rt_err_t utest_tc_cleanup(void)
+{
+    return RT_EOK;
+}
+
+static void testcase(void)
+{
+    UTEST_UNIT_RUN(test_fdb_crc32);
+    UTEST_UNIT_RUN(test_fdb_crc32_bench);
+}
+
+UTEST_TC_EXPORT(testcase, "packages.system.flashdb.utils", utest_tc_init, utest_tc_cleanup, 20);
+#endif /* defined(RT_USING_UTEST) */
@@ -1,8 +1,10 @@
 #include <stdio.h>
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "freertos/semphr.h"
 #include "esp_system.h"
 #include "esp_log.h"
+#include "esp_timer.h"
 #include <flashdb.h>
 #include <string.h>
 #include "nvs_flash.h"
@@ -21,6 +23,7 @@ static const char *TAG = "TOUCH_LOGGER";
 
 // FlashDB TSDB for touch events
 static struct fdb_tsdb tsdb = {0};
+static SemaphoreHandle_t tsdb_mutex = NULL;
 
 // Touch pad configuration
 #define TOUCH_PAD_COUNT 7
@@ -128,15 +131,31 @@ static bool tsl_iter_cb(fdb_tsl_t tsl, void *arg)
 
 static fdb_time_t get_time(void)
 {
-    // Return current time in milliseconds or seconds.
-    // For simplicity, using FreeRTOS tick count here.
-    // Consider using esp_timer_get_time() for microsecond resolution or an RTC.
-    return xTaskGetTickCount() * portTICK_PERIOD_MS; // Time in milliseconds
+    // Return the time since boot in milliseconds.
+    // esp_timer_get_time() is 64-bit, so it does not wrap like the 32-bit FreeRTOS tick count
+    // (fdb_time_t is 64-bit with FDB_USING_TIMESTAMP_64BIT in fdb_cfg.h).
+    return (fdb_time_t)(esp_timer_get_time() / 1000); // Time in milliseconds
+}
+
+static void tsdb_lock(fdb_db_t db)
+{
+    xSemaphoreTake(tsdb_mutex, portMAX_DELAY);
+}
+
+static void tsdb_unlock(fdb_db_t db)
+{
+    xSemaphoreGive(tsdb_mutex);
 }
 
 static fdb_err_t tsdb_init(void)
 {
     fdb_err_t result;
+    bool snapshot_read = true;
+
+    // The touch task appends while the HTTP handlers iterate, so guard the TSDB with a mutex
+    tsdb_mutex = xSemaphoreCreateMutex();
+    fdb_tsdb_control(&tsdb, FDB_TSDB_CTRL_SET_LOCK, (void *)tsdb_lock);
+    fdb_tsdb_control(&tsdb, FDB_TSDB_CTRL_SET_UNLOCK, (void *)tsdb_unlock);
     ESP_LOGD(TAG, "Calling fdb_tsdb_init with name 'touch_events' and part_name 'flashdb'");
     result = fdb_tsdb_init(&tsdb, "touch_events", "flashdb", get_time, 128, NULL);
     if (result != FDB_NO_ERR)
@@ -146,6 +165,8 @@ static fdb_err_t tsdb_init(void)
     else
     {
         ESP_LOGD(TAG, "fdb_tsdb_init returned FDB_NO_ERR");
+        // Iterate a snapshot without the lock, so a long export never stalls the touch task
+        fdb_tsdb_control(&tsdb, FDB_TSDB_CTRL_SET_SNAPSHOT_READ, &snapshot_read);
     }
     return result;
 }